@@ -226,16 +226,21 @@ public:
 
 	ShaderBuilder& Type(ShaderType type);
 	ShaderBuilder& AddSource(const std::string& name, const std::string& code);
+	ShaderBuilder& Spirv(std::vector<uint32_t> code);
 
 	ShaderBuilder& OnIncludeSystem(std::function<ShaderIncludeResult(std::string headerName, std::string includerName, size_t inclusionDepth)> onIncludeSystem);
 	ShaderBuilder& OnIncludeLocal(std::function<ShaderIncludeResult(std::string headerName, std::string includerName, size_t inclusionDepth)> onIncludeLocal);
 
 	ShaderBuilder& DebugName(const char* name) { debugName = name; return *this; }
 
+	// Compiles the GLSL sources to SPIR-V. Does not need a device and may be called from any thread.
+	std::vector<uint32_t> CreateSpirv(uint32_t apiVersion);
+
 	std::unique_ptr<VulkanShader> Create(const char *shadername, VulkanDevice *device);
 
 private:
 	std::vector<std::pair<std::string, std::string>> sources;
+	std::vector<uint32_t> spirv;
 	std::function<ShaderIncludeResult(std::string headerName, std::string includerName, size_t inclusionDepth)> onIncludeSystem;
 	std::function<ShaderIncludeResult(std::string headerName, std::string includerName, size_t inclusionDepth)> onIncludeLocal;
 	int stage = 0;
@@ -147,6 +147,12 @@ ShaderBuilder& ShaderBuilder::AddSource(const std::string& name, const std::stri
 	return *this;
 }
 
+ShaderBuilder& ShaderBuilder::Spirv(std::vector<uint32_t> code)
+{
+	spirv = std::move(code);
+	return *this;
+}
+
 ShaderBuilder& ShaderBuilder::OnIncludeSystem(std::function<ShaderIncludeResult(std::string headerName, std::string includerName, size_t inclusionDepth)> onIncludeSystem)
 {
 	this->onIncludeSystem = std::move(onIncludeSystem);
@@ -247,7 +253,7 @@ private:
 	ShaderBuilder* shaderBuilder = nullptr;
 };
 
-std::unique_ptr<VulkanShader> ShaderBuilder::Create(const char *shadername, VulkanDevice *device)
+std::vector<uint32_t> ShaderBuilder::CreateSpirv(uint32_t apiVersion)
 {
 	EShLanguage stage = (EShLanguage)this->stage;
 
@@ -265,7 +271,7 @@ std::unique_ptr<VulkanShader> ShaderBuilder::Create(const char *shadername, Vulk
 	glslang::TShader shader(stage);
 	shader.setStringsWithLengthsAndNames(sourcesC.data(), lengthsC.data(), namesC.data(), (int)sources.size());
 	shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
-    if (device->Instance->ApiVersion >= VK_API_VERSION_1_2)
+    if (apiVersion >= VK_API_VERSION_1_2)
     {
         shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
         shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_4);
@@ -302,13 +308,20 @@ std::unique_ptr<VulkanShader> ShaderBuilder::Create(const char *shadername, Vulk
 	spvOptions.disableOptimizer = false;
 	spvOptions.optimizeSize = true;
 
-	std::vector<unsigned int> spirv;
+	std::vector<uint32_t> code;
 	spv::SpvBuildLogger logger;
-	glslang::GlslangToSpv(*intermediate, spirv, &logger, &spvOptions);
+	glslang::GlslangToSpv(*intermediate, code, &logger, &spvOptions);
+	return code;
+}
+
+std::unique_ptr<VulkanShader> ShaderBuilder::Create(const char *shadername, VulkanDevice *device)
+{
+	if (spirv.empty())
+		spirv = CreateSpirv(device->Instance->ApiVersion);
 
 	VkShaderModuleCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = spirv.size() * sizeof(unsigned int);
+	createInfo.codeSize = spirv.size() * sizeof(uint32_t);
 	createInfo.pCode = spirv.data();
 
 	VkShaderModule shaderModule;
@@ -39,6 +39,7 @@
 
 #include "i_module.h"
 #include "cmdlib.h"
+#include "m_fixed.h"
 
 #include "c_dispatch.h"
 #include "i_music.h"
@@ -141,6 +142,11 @@ public:
 		SoundHandle retval = { NULL };
         return retval;
 	}
+	SoundHandle LoadDecodedSound(FDecodedSound &sound)
+	{
+		SoundHandle retval = { NULL };
+		return retval;
+	}
 	void UnloadSound (SoundHandle sfx)
 	{
 	}
@@ -336,6 +342,64 @@ FString SoundStream::GetStats()
 	return "No stream stats available.";
 }
 
+//==========================================================================
+//
+// SoundRenderer :: DecodeSound
+//
+// Decodes a sound in any format ZMusic understands to PCM and resolves
+// its loop points to sample positions.
+//
+//==========================================================================
+
+bool SoundRenderer::DecodeSound(const uint8_t *sfxdata, int length, int def_loop_start, int def_loop_end, FDecodedSound &sound)
+{
+	uint32_t loop_start = 0, loop_end = ~0u;
+	zmusic_bool startass = false, endass = false;
+
+	if (def_loop_start < 0)
+	{
+		FindLoopTags(sfxdata, length, &loop_start, &startass, &loop_end, &endass);
+	}
+	else
+	{
+		loop_start = def_loop_start;
+		loop_end = def_loop_end;
+		startass = endass = true;
+	}
+	auto decoder = CreateDecoder(sfxdata, length, true);
+	if (!decoder)
+		return false;
+
+	SoundDecoder_GetInfo(decoder, &sound.SampleRate, &sound.Channels, &sound.Type);
+
+	auto &data = sound.Data;
+	unsigned total = 0;
+	unsigned got;
+
+	data.resize(total + 32768);
+	while ((got = (unsigned)SoundDecoder_Read(decoder, (char*)&data[total], data.size() - total)) > 0)
+	{
+		total += got;
+		data.resize(total * 2);
+	}
+	data.resize(total);
+	SoundDecoder_Close(decoder);
+	if (total == 0)
+	{
+		return false;
+	}
+
+	int samplesize = (sound.Type == SampleType_UInt8 ? 1 : sound.Type == SampleType_Int16 ? 2 : 4) * (sound.Channels == ChannelConfig_Stereo ? 2 : 1);
+	if (!startass) loop_start = Scale(loop_start, sound.SampleRate, 1000);
+	if (!endass && loop_end != ~0u) loop_end = Scale(loop_end, sound.SampleRate, 1000);
+	const uint32_t samples = total / samplesize;
+	if (loop_start > samples) loop_start = 0;
+	if (loop_end > samples) loop_end = samples;
+	sound.LoopStart = loop_start;
+	sound.LoopEnd = loop_end;
+	return true;
+}
+
 //==========================================================================
 //
 // SoundRenderer :: LoadSoundVoc
@@ -53,6 +53,17 @@ enum EStartSoundFlags
 	SNDF_NOREVERB=16,
 };
 
+// PCM data of a decoded sound, ready to be passed to the sound device.
+struct FDecodedSound
+{
+	TArray<uint8_t> Data;
+	int SampleRate = 0;
+	ChannelConfig Channels = ChannelConfig_Mono;
+	SampleType Type = SampleType_UInt8;
+	uint32_t LoopStart = 0;		// in samples
+	uint32_t LoopEnd = 0;
+};
+
 enum ECodecType
 {
 	CODEC_Unknown,
@@ -107,6 +118,9 @@ public:
 	virtual void SetMusicVolume (float volume) = 0;
 	virtual SoundHandle LoadSound(uint8_t *sfxdata, int length, int def_loop_start, int def_loop_end) = 0;
 	SoundHandle LoadSoundVoc(uint8_t *sfxdata, int length);
+	// Decodes a compressed sound without touching the sound device, so this may run on a worker thread.
+	static bool DecodeSound(const uint8_t *sfxdata, int length, int def_loop_start, int def_loop_end, FDecodedSound &sound);
+	virtual SoundHandle LoadDecodedSound(FDecodedSound &sound) = 0;
 	virtual SoundHandle LoadSoundRaw(uint8_t *sfxdata, int length, int frequency, int channels, int bits, int loopstart, int loopend = -1) = 0;
 	virtual void UnloadSound (SoundHandle sfx) = 0;	// unloads a sound from memory
 	virtual unsigned int GetMSLength(SoundHandle sfx) = 0;	// Gets the length of a sound at its default frequency
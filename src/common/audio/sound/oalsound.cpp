@@ -1098,70 +1098,42 @@ SoundHandle OpenALSoundRenderer::LoadSoundRaw(uint8_t *sfxdata, int length, int
 
 SoundHandle OpenALSoundRenderer::LoadSound(uint8_t *sfxdata, int length, int def_loop_start, int def_loop_end)
 {
-	SoundHandle retval = { NULL };
-	ALenum format = AL_NONE;
-	ChannelConfig chans;
-	SampleType type;
-	int srate;
-	uint32_t loop_start = 0, loop_end = ~0u;
-	zmusic_bool startass = false, endass = false;
-
-	if (def_loop_start < 0)
-	{
-		FindLoopTags(sfxdata, length, &loop_start, &startass, &loop_end, &endass);
-	}
-	else
+	FDecodedSound sound;
+	if (!DecodeSound(sfxdata, length, def_loop_start, def_loop_end, sound))
 	{
-		loop_start = def_loop_start;
-		loop_end = def_loop_end;
-		startass = endass = true;
-	}
-	auto decoder = CreateDecoder(sfxdata, length, true);
-	if (!decoder)
+		SoundHandle retval = { NULL };
 		return retval;
+	}
+	return LoadDecodedSound(sound);
+}
 
-	SoundDecoder_GetInfo(decoder, &srate, &chans, &type);
-	int samplesize = 1;
-	if (chans == ChannelConfig_Mono)
+SoundHandle OpenALSoundRenderer::LoadDecodedSound(FDecodedSound &sound)
+{
+	SoundHandle retval = { NULL };
+	ALenum format = AL_NONE;
+
+	if (sound.Channels == ChannelConfig_Mono)
 	{
-		if (type == SampleType_UInt8) format = AL_FORMAT_MONO8, samplesize = 1;
-		if (type == SampleType_Int16) format = AL_FORMAT_MONO16, samplesize = 2;
+		if (sound.Type == SampleType_UInt8) format = AL_FORMAT_MONO8;
+		if (sound.Type == SampleType_Int16) format = AL_FORMAT_MONO16;
 	}
-	else if (chans == ChannelConfig_Stereo)
+	else if (sound.Channels == ChannelConfig_Stereo)
 	{
-		if (type == SampleType_UInt8) format = AL_FORMAT_STEREO8, samplesize = 2;
-		if (type == SampleType_Int16) format = AL_FORMAT_STEREO16, samplesize = 4;
+		if (sound.Type == SampleType_UInt8) format = AL_FORMAT_STEREO8;
+		if (sound.Type == SampleType_Int16) format = AL_FORMAT_STEREO16;
 	}
 
 	if (format == AL_NONE)
 	{
-		SoundDecoder_Close(decoder);
-		Printf("Unsupported audio format: %s, %s\n", GetChannelConfigName(chans),
-			GetSampleTypeName(type));
-		return retval;
-	}
-
-	TArray<uint8_t> data;
-	unsigned total = 0;
-	unsigned got;
-
-	data.resize(total + 32768);
-	while ((got = (unsigned)SoundDecoder_Read(decoder, (char*)&data[total], data.size() - total)) > 0)
-	{
-		total += got;
-		data.resize(total * 2);
-	}
-	data.resize(total);
-	if (total == 0)
-	{
+		Printf("Unsupported audio format: %s, %s\n", GetChannelConfigName(sound.Channels),
+			GetSampleTypeName(sound.Type));
 		return retval;
 	}
-	SoundDecoder_Close(decoder);
 
 	ALenum err;
 	ALuint buffer = 0;
 	alGenBuffers(1, &buffer);
-	alBufferData(buffer, format, &data[0], (ALsizei)data.size(), srate);
+	alBufferData(buffer, format, &sound.Data[0], (ALsizei)sound.Data.size(), sound.SampleRate);
 	if((err=getALError()) != AL_NO_ERROR)
 	{
 		Printf("Failed to buffer data: %s\n", alGetString(err));
@@ -1170,12 +1142,7 @@ SoundHandle OpenALSoundRenderer::LoadSound(uint8_t *sfxdata, int length, int def
 		return retval;
 	}
 
-	if (!startass) loop_start = Scale(loop_start, srate, 1000);
-	if (!endass && loop_end != ~0u) loop_end = Scale(loop_end, srate, 1000);
-	const uint32_t samples = (uint32_t)data.size() / samplesize;
-	if (loop_start > samples) loop_start = 0;
-	if (loop_end > samples) loop_end = samples;
-
+	uint32_t loop_start = sound.LoopStart, loop_end = sound.LoopEnd;
 	if ((loop_start > 0 || loop_end > 0) && loop_end > loop_start && AL.SOFT_loop_points)
 	{
 		ALint loops[2] = { static_cast<ALint>(loop_start), static_cast<ALint>(loop_end) };
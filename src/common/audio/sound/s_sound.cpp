@@ -45,6 +45,10 @@
 #include "printf.h"
 #include "c_cvars.h"
 #include "gamestate.h"
+#include "workerpool.h"
+#include <future>
+#include <memory>
+#include <vector>
 
 CVARD(Bool, snd_enabled, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "enables/disables sound effects")
 CVAR(Bool, i_soundinbackground, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
@@ -92,6 +96,7 @@ void SoundEngine::Clear()
 	StopAllChannels();
 	UnloadAllSounds();
 	S_sfx.Clear();
+	LoadedLumps.Clear();
 	ClearRandoms();
 }
 
@@ -129,6 +134,42 @@ void SoundEngine::MarkUsed(FSoundID sid)
 	}
 }
 
+//==========================================================================
+//
+// Decodes that were queued by LoadSound while CacheMarkedSounds runs.
+// The sound device is only touched on the main thread, once a decode is done.
+//
+//==========================================================================
+
+struct FPendingDecode
+{
+	int SfxIndex;
+	FDecodedSound Sound;
+	std::future<bool> Result;
+};
+
+static bool DecodeOnWorkers;
+static std::vector<std::unique_ptr<FPendingDecode>> PendingDecodes;
+
+void SoundEngine::FinishPendingDecodes()
+{
+	for (auto &job : PendingDecodes)
+	{
+		sfxinfo_t *sfx = &S_sfx[job->SfxIndex];
+		sfx->bDecodePending = false;
+		if (job->Result.get())
+		{
+			sfx->data = GSnd->LoadDecodedSound(job->Sound);
+		}
+		if (!sfx->data.isValid())
+		{
+			LoadedLumps.Remove(sfx->lumpnum);
+			sfx->lumpnum = sfx_empty;
+		}
+	}
+	PendingDecodes.clear();
+}
+
 //==========================================================================
 //
 // Cache all marked sounds
@@ -143,6 +184,8 @@ void SoundEngine::CacheMarkedSounds()
 		MarkUsed(chan->SoundID);
 	}
 
+	// Compressed sounds get decoded on worker threads while the remaining lumps are read.
+	DecodeOnWorkers = true;
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (S_sfx[i].bUsed)
@@ -150,6 +193,9 @@ void SoundEngine::CacheMarkedSounds()
 			CacheSound(&S_sfx[i]);
 		}
 	}
+	DecodeOnWorkers = false;
+	FinishPendingDecodes();
+
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (!S_sfx[i].bUsed && S_sfx[i].link == sfxinfo_t::NO_LINK)
@@ -197,6 +243,12 @@ void SoundEngine::UnloadSound (sfxinfo_t *sfx)
 	{
 		GSnd->UnloadSound(sfx->data);
 		DPrintf(DMSG_NOTIFY, "Unloaded sound \"%s\" (%td)\n", sfx->name.GetChars(), sfx - &S_sfx[0]);
+
+		int *owner = LoadedLumps.CheckKey(sfx->lumpnum);
+		if (owner != nullptr && *owner == int(sfx - &S_sfx[0]))
+		{
+			LoadedLumps.Remove(sfx->lumpnum);
+		}
 	}
 	sfx->data.Clear();
 }
@@ -239,6 +291,7 @@ FSoundChan *SoundEngine::GetChannel(void *syschan)
 void SoundEngine::ReturnChannel(FSoundChan *chan)
 {
 	UnlinkChannel(chan);
+	UnindexChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	LinkChannel(chan, &FreeChannels);
 }
@@ -275,6 +328,50 @@ void SoundEngine::LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// S_IndexChannel
+//
+// (Re)inserts a channel into the sound and source hashes. Must be called
+// whenever a playing channel's SoundID or Source changes.
+//
+//==========================================================================
+
+void SoundEngine::IndexChannel(FSoundChan *chan)
+{
+	UnindexChannel(chan);
+
+	FSoundChan **head = &SfxChannels[chan->SoundID.index() & (CHANNEL_HASH_SIZE - 1)];
+	chan->NextSfxChan = *head;
+	if (*head != nullptr) (*head)->PrevSfxChan = &chan->NextSfxChan;
+	*head = chan;
+	chan->PrevSfxChan = head;
+
+	head = &SourceChannels[SourceHash(chan->Source)];
+	chan->NextSourceChan = *head;
+	if (*head != nullptr) (*head)->PrevSourceChan = &chan->NextSourceChan;
+	*head = chan;
+	chan->PrevSourceChan = head;
+}
+
+void SoundEngine::UnindexChannel(FSoundChan *chan)
+{
+	if (chan->PrevSfxChan != nullptr)
+	{
+		*chan->PrevSfxChan = chan->NextSfxChan;
+		if (chan->NextSfxChan != nullptr) chan->NextSfxChan->PrevSfxChan = chan->PrevSfxChan;
+		chan->PrevSfxChan = nullptr;
+		chan->NextSfxChan = nullptr;
+	}
+	if (chan->PrevSourceChan != nullptr)
+	{
+		*chan->PrevSourceChan = chan->NextSourceChan;
+		if (chan->NextSourceChan != nullptr) chan->NextSourceChan->PrevSourceChan = chan->PrevSourceChan;
+		chan->PrevSourceChan = nullptr;
+		chan->NextSourceChan = nullptr;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -544,18 +641,33 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	// If this actor is already playing something on the selected channel, stop it.
 	if (!(chanflags & CHANF_OVERLAP) && type != SOURCE_None && ((source == NULL && channel != CHAN_AUTO) || (source != NULL && IsChannelUsed(type, source, channel, &seen))))
 	{
-		for (chan = Channels; chan != NULL; chan = chan->NextChan)
+		if (source != NULL)
 		{
-			if (chan->SourceType == type && chan->EntChannel == channel)
+			for (chan = SourceChannels[SourceHash(source)]; chan != NULL; )
 			{
-				const bool foundit = (type == SOURCE_Unattached)
-					? (chan->Point[0] == pt->X && chan->Point[2] == pt->Z && chan->Point[1] == pt->Y)
-					: (chan->Source == source);
-
-				if (foundit)
+				FSoundChan *next = chan->NextSourceChan;
+				if (chan->SourceType == type && chan->EntChannel == channel && chan->Source == source)
 				{
 					StopChannel(chan);
 				}
+				chan = next;
+			}
+		}
+		else
+		{
+			for (chan = Channels; chan != NULL; chan = chan->NextChan)
+			{
+				if (chan->SourceType == type && chan->EntChannel == channel)
+				{
+					const bool foundit = (type == SOURCE_Unattached)
+						? (chan->Point[0] == pt->X && chan->Point[2] == pt->Z && chan->Point[1] == pt->Y)
+						: (chan->Source == source);
+
+					if (foundit)
+					{
+						StopChannel(chan);
+					}
+				}
 			}
 		}
 	}
@@ -630,6 +742,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		{
 			chan->Source = source;
 		}
+		IndexChannel(chan);
 	}
 
 	return chan;
@@ -704,6 +817,28 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 	}
 }
 
+//==========================================================================
+//
+// Returns the S_sfx index of the sound that holds the data for a lump,
+// or -1 if it isn't loaded. Stale entries are removed on the way.
+//
+//==========================================================================
+
+int SoundEngine::FindLoadedLump(int lumpnum)
+{
+	int *owner = LoadedLumps.CheckKey(lumpnum);
+	if (owner == nullptr) return -1;
+
+	int i = *owner;
+	if ((unsigned)i < S_sfx.Size() && (S_sfx[i].data.isValid() || S_sfx[i].bDecodePending) &&
+		S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == lumpnum)
+	{
+		return i;
+	}
+	LoadedLumps.Remove(lumpnum);
+	return -1;
+}
+
 //==========================================================================
 //
 // S_LoadSound
@@ -716,9 +851,9 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 {
 	if (GSnd->IsNull()) return sfx;
 
-	while (!sfx->data.isValid())
+	while (!sfx->data.isValid() && !sfx->bDecodePending)
 	{
-		unsigned int i;
+		int i;
 
 		if (sfx->lumpnum == sfx_empty)
 		{
@@ -727,18 +862,25 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 
 		// See if there is another sound already initialized with this lump. If so,
 		// then set this one up as a link, and don't load the sound again.
-		for (i = 0; i < S_sfx.Size(); i++)
+		i = FindLoadedLump(sfx->lumpnum);
+		if (i >= 0 && sfx->bLoadRAW && sfx->RawRate != S_sfx[i].RawRate)
 		{
-			if (S_sfx[i].data.isValid() && S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == sfx->lumpnum &&
-				(!sfx->bLoadRAW || (sfx->RawRate == S_sfx[i].RawRate)))	// Raw sounds with different sample rates may not share buffers, even if they use the same source data.
+			// Raw sounds with different sample rates may not share buffers, even if they use the same source data.
+			for (i = 0; i < (int)S_sfx.Size(); i++)
 			{
-				DPrintf (DMSG_NOTIFY, "Linked %s to %s (%d)\n", sfx->name.GetChars(), S_sfx[i].name.GetChars(), i);
-				sfx->link = FSoundID::fromInt(i);
-				// This is necessary to avoid using the rolloff settings of the linked sound if its
-				// settings are different.
-				if (sfx->Rolloff.MinDistance == 0) sfx->Rolloff = S_Rolloff;
-				return &S_sfx[i];
+				if (S_sfx[i].data.isValid() && S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == sfx->lumpnum && sfx->RawRate == S_sfx[i].RawRate)
+					break;
 			}
+			if (i == (int)S_sfx.Size()) i = -1;
+		}
+		if (i >= 0)
+		{
+			DPrintf (DMSG_NOTIFY, "Linked %s to %s (%d)\n", sfx->name.GetChars(), S_sfx[i].name.GetChars(), i);
+			sfx->link = FSoundID::fromInt(i);
+			// This is necessary to avoid using the rolloff settings of the linked sound if its
+			// settings are different.
+			if (sfx->Rolloff.MinDistance == 0) sfx->Rolloff = S_Rolloff;
+			return &S_sfx[i];
 		}
 
 		DPrintf(DMSG_NOTIFY, "Loading sound \"%s\" (%td)\n", sfx->name.GetChars(), sfx - &S_sfx[0]);
@@ -768,13 +910,30 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 				sfx->data = GSnd->LoadSoundRaw(sfxp+8, dmxlen, frequency, 1, 8, sfx->LoopStart);
 			}
 			// If that fails, let the sound system try and figure it out.
+			else if (DecodeOnWorkers)
+			{
+				auto job = std::make_unique<FPendingDecode>();
+				job->SfxIndex = int(sfx - &S_sfx[0]);
+				job->Result = WorkerPool().push([sfxdata = std::move(sfxdata), sound = &job->Sound, loopstart = sfx->LoopStart, loopend = sfx->LoopEnd](int)
+				{
+					return SoundRenderer::DecodeSound(sfxdata.data(), (int)sfxdata.size(), loopstart, loopend, *sound);
+				});
+				PendingDecodes.push_back(std::move(job));
+				sfx->bDecodePending = true;
+				LoadedLumps[sfx->lumpnum] = int(sfx - &S_sfx[0]);
+				break;
+			}
 			else
 			{
 				sfx->data = GSnd->LoadSound(sfxp, size, sfx->LoopStart, sfx->LoopEnd);
 			}
 		}
 
-		if (!sfx->data.isValid())
+		if (sfx->data.isValid())
+		{
+			LoadedLumps[sfx->lumpnum] = int(sfx - &S_sfx[0]);
+		}
+		else
 		{
 			if (sfx->lumpnum != sfx_empty)
 			{
@@ -829,8 +988,9 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 {
 	FSoundChan *chan;
 	int count;
+	int sfxindex = int(sfx - &S_sfx[0]);
 
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	for (chan = SfxChannels[sfxindex & (CHANNEL_HASH_SIZE - 1)], count = 0; chan != NULL && count < near_limit; chan = chan->NextSfxChan)
 	{
 		if (chan->ChanFlags & CHANF_FORGETTABLE) continue;
 		if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID.index()] == sfx)
@@ -992,6 +1152,7 @@ void SoundEngine::RelinkSound (int sourcetype, const void *from, const void *to,
 			if (to != NULL)
 			{
 				chan->Source = to;
+				IndexChannel(chan);
 			}
 			else if (!(chan->ChanFlags & CHANF_LOOP) && optpos)
 			{
@@ -1000,6 +1161,7 @@ void SoundEngine::RelinkSound (int sourcetype, const void *from, const void *to,
 				chan->Point[0] = optpos->X;
 				chan->Point[1] = optpos->Y;
 				chan->Point[2] = optpos->Z;
+				IndexChannel(chan);
 			}
 			else
 			{
@@ -1086,7 +1248,18 @@ void SoundEngine::SetPitch(FSoundChan *chan, float pitch)
 int SoundEngine::GetSoundPlayingInfo (int sourcetype, const void *source, FSoundID sound_id, int chann)
 {
 	int count = 0;
-	if (sound_id.isvalid())
+	if (sourcetype != SOURCE_Any && source != NULL)
+	{
+		for (FSoundChan *chan = SourceChannels[SourceHash(source)]; chan != NULL; chan = chan->NextSourceChan)
+		{
+			if (chann != -1 && chann != chan->EntChannel) continue;
+			if (chan->SourceType == sourcetype && chan->Source == source && (!sound_id.isvalid() || chan->OrgID == sound_id))
+			{
+				count++;
+			}
+		}
+	}
+	else if (sound_id.isvalid())
 	{
 		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
 		{
@@ -1129,7 +1302,7 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 	{
 		return true;
 	}
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = SourceChannels[SourceHash(actor)]; chan != NULL; chan = chan->NextSourceChan)
 	{
 		if (chan->SourceType == sourcetype && chan->Source == actor)
 		{
@@ -1151,7 +1324,8 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 
 bool SoundEngine::IsSourcePlayingSomething (int sourcetype, const void *actor, int channel, FSoundID sound_id)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	bool bysource = actor != NULL && sourcetype != SOURCE_None && sourcetype != SOURCE_Unattached;
+	for (FSoundChan *chan = bysource ? SourceChannels[SourceHash(actor)] : Channels; chan != NULL; chan = bysource ? chan->NextSourceChan : chan->NextChan)
 	{
 		if (chan->SourceType == sourcetype && (sourcetype == SOURCE_None || sourcetype == SOURCE_Unattached || chan->Source == actor))
 		{
@@ -1753,6 +1927,124 @@ CCMD(listsoundchannels)
 	Printf("%s", soundEngine->ListSoundChannels().GetChars());
 }
 
+//==========================================================================
+//
+// Times the per-sound channel checks that StartSound does against a large
+// number of fake playing channels, using the hashed channel lists and a
+// plain walk over all channels. The sound backend is never called.
+//
+//==========================================================================
+
+void SoundEngine::BenchChannelChecks(int numchannels, int numsources, int numqueries)
+{
+	if (S_sfx.Size() < 2)
+	{
+		Printf("No sounds defined\n");
+		return;
+	}
+
+	// Only the addresses of the sources are used. The channels are unattached,
+	// so CalcPosVel just returns the stored point.
+	TArray<uint8_t> sources(numsources * 16, true);
+	TArray<FSoundChan*> chans(numchannels, true);
+	uint32_t seed = 1;
+	auto random = [&]() { seed = seed * 1664525 + 1013904223; return seed >> 8; };
+	auto randompos = [&]() { return float(int(random() % 8192) - 4096); };
+
+	for (auto &chan : chans)
+	{
+		chan = GetChannel(nullptr);
+		chan->SoundID = chan->OrgID = FSoundID::fromInt(1 + random() % (S_sfx.Size() - 1));
+		chan->SourceType = SOURCE_Unattached;
+		chan->Source = &sources[(random() % numsources) * 16];
+		chan->EntChannel = random() % 8;
+		chan->DistanceScale = 1;
+		chan->Point[0] = randompos(); chan->Point[1] = 0; chan->Point[2] = randompos();
+		IndexChannel(chan);
+	}
+
+	struct Query
+	{
+		sfxinfo_t *sfx;
+		const void *source;
+		int channel;
+		FVector3 pos;
+	};
+	TArray<Query> queries(numqueries, true);
+	for (auto &q : queries)
+	{
+		q.sfx = &S_sfx[1 + random() % (S_sfx.Size() - 1)];
+		q.source = &sources[(random() % numsources) * 16];
+		q.channel = random() % 8;
+		q.pos = FVector3(randompos(), 0, randompos());
+	}
+
+	const int near_limit = 4;
+	const float limit_range = 256 * 256;
+	cycle_t indexedtime, lineartime;
+	indexedtime.Reset();
+	lineartime.Reset();
+	int indexedhits = 0, linearhits = 0;
+
+	indexedtime.Clock();
+	for (auto &q : queries)
+	{
+		int seen = 0;
+		indexedhits += SoundEngine::CheckSoundLimit(q.sfx, q.pos, near_limit, limit_range, SOURCE_Unattached, q.source, q.channel, 1.f);
+		indexedhits += IsChannelUsed(SOURCE_Unattached, q.source, q.channel, &seen);
+	}
+	indexedtime.Unclock();
+
+	lineartime.Clock();
+	for (auto &q : queries)
+	{
+		int count = 0;
+		bool restarting = false, used = false;
+		for (FSoundChan *chan = Channels; chan != NULL && count < near_limit; chan = chan->NextChan)
+		{
+			if (chan->ChanFlags & CHANF_FORGETTABLE) continue;
+			if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID.index()] == q.sfx)
+			{
+				if (chan->EntChannel == q.channel && chan->SourceType == SOURCE_Unattached && chan->Source == q.source)
+				{
+					restarting = true;
+					break;
+				}
+				FVector3 chanorigin;
+				CalcPosVel(chan, &chanorigin, NULL);
+				if ((chanorigin - q.pos).LengthSquared() <= limit_range / chan->DistanceScale) count++;
+			}
+		}
+		linearhits += !restarting && count >= near_limit;
+		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		{
+			if (chan->SourceType == SOURCE_Unattached && chan->Source == q.source && chan->EntChannel == q.channel)
+			{
+				used = true;
+				break;
+			}
+		}
+		linearhits += used;
+	}
+	lineartime.Unclock();
+
+	for (auto chan : chans)
+	{
+		ReturnChannel(chan);
+	}
+
+	Printf("%d channels, %d sources, %d sound starts: hashed %.2f ms, linear %.2f ms, results %s\n", numchannels, numsources, numqueries,
+		indexedtime.TimeMS(), lineartime.TimeMS(), indexedhits == linearhits ? "match" : "DIFFER");
+}
+
+CCMD(soundchannelbench)
+{
+	int numchannels = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 100000) : 4096;
+	int numsources = argv.argc() > 2 ? clamp(atoi(argv[2]), 1, 100000) : numchannels / 4 + 1;
+	int numqueries = argv.argc() > 3 ? clamp(atoi(argv[3]), 1, 1000000) : 10000;
+	soundEngine->BenchChannelChecks(numchannels, numsources, numqueries);
+}
+
 // intentionally moved here to keep the s_music include out of the rest of the file.
 
 //==========================================================================
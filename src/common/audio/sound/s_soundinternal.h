@@ -99,6 +99,7 @@ constexpr FSoundID INVALID_SOUND = FSoundID::fromInt(-1);
 	 bool		bSingular = false;
 	 bool		bTentative = true;
 	 bool		bExternal = false;
+	 bool		bDecodePending = false;				// Being decoded on a worker thread by CacheMarkedSounds.
 
 	 int			RawRate = 0;				// Sample rate to use when bLoadRAW is true
 	 int			LoopStart = -1;				// -1 means no specific loop defined
@@ -117,6 +118,10 @@ struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
 	FSoundChan **PrevChan;	// Previous channel in this list.
+	FSoundChan	*NextSfxChan;	// Next channel in the same SoundID hash bucket.
+	FSoundChan **PrevSfxChan;	// null if the channel is not indexed.
+	FSoundChan	*NextSourceChan;	// Next channel in the same Source hash bucket.
+	FSoundChan **PrevSourceChan;
 	FSoundID	SoundID;	// Sound ID of playing sound.
 	FSoundID	OrgID;		// Sound ID of sound used to start this channel.
 	float		Volume;
@@ -190,18 +195,30 @@ protected:
 	FSoundChan* Channels = nullptr;
 	FSoundChan* FreeChannels = nullptr;
 
+	// Playing channels hashed by sound and by source, so that the checks done
+	// for each new sound do not have to look at every playing channel.
+	enum { CHANNEL_HASH_SIZE = 256 };
+	FSoundChan* SfxChannels[CHANNEL_HASH_SIZE] = {};
+	FSoundChan* SourceChannels[CHANNEL_HASH_SIZE] = {};
+
 	// the complete set of sound effects
 	TArray<sfxinfo_t> S_sfx;
 	FRolloffInfo S_Rolloff{};
 	TArray<uint8_t> S_SoundCurve;
 	TMap<FName, FSoundID> SoundMap;
 	TMap<int, FSoundID> ResIdMap;
+	TMap<int, int> LoadedLumps;		// lump number -> S_sfx index of the sound holding that lump's data
 	TArray<FRandomSoundList> S_rnd;
 	bool blockNewSounds = false;
 
 private:
 	void LinkChannel(FSoundChan* chan, FSoundChan** head);
 	void UnlinkChannel(FSoundChan* chan);
+	void UnindexChannel(FSoundChan* chan);
+	static unsigned SourceHash(const void* source)
+	{
+		return unsigned((uintptr_t(source) >> 4) * 2654435761u) >> 24;
+	}
 	void ReturnChannel(FSoundChan* chan);
 	void RestartChannel(FSoundChan* chan);
 	void RestoreEvictedChannel(FSoundChan* chan);
@@ -216,6 +233,8 @@ private:
 
 	// Checks if a copy of this sound is already playing.
 	bool CheckSingular(FSoundID sound_id);
+	int FindLoadedLump(int lumpnum);
+	void FinishPendingDecodes();
 	virtual TArray<uint8_t> ReadSound(int lumpnum) = 0;
 
 protected:
@@ -271,6 +290,7 @@ public:
 	void SetVolume(FSoundChan* chan, float vol);
 
 	FSoundChan* GetChannel(void* syschan);
+	void IndexChannel(FSoundChan* chan);
 	void RestoreEvictedChannels();
 	void CalcPosVel(FSoundChan* chan, FVector3* pos, FVector3* vel);
 
@@ -383,6 +403,7 @@ public:
 
 	void ChannelVirtualChanged(FISoundChannel* ichan, bool is_virtual);
 	FString ListSoundChannels();
+	void BenchChannelChecks(int numchannels, int numsources, int numqueries);
 
 	// Allow this to be overridden for special needs.
 	virtual float GetRolloff(const FRolloffInfo* rolloff, float distance);
@@ -49,6 +49,8 @@ struct SystemCallbacks
 	FConfigFile* (*GetConfig)();
 	bool (*WantEscape)();
 	FTranslationID(*RemapTranslation)(FTranslationID trans);
+	void (*LoopbackReceive)(int node, const uint8_t* data, int len);
+	void (*LoopbackUpdate)(int node);
 };
 
 extern SystemCallbacks sysCallbacks;
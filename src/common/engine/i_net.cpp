@@ -75,6 +75,11 @@
 #include "cmdlib.h"
 #include "printf.h"
 #include "i_interface.h"
+#include "i_time.h"
+#include "c_cvars.h"
+#include "stats.h"
+#include "tarray.h"
+#include <random>
 
 
 #include "i_net.h"
@@ -160,6 +165,165 @@ struct PreGamePacket
 
 uint8_t TransmitBuffer[TRANSMIT_SIZE];
 
+//
+// Network condition simulation
+//
+// Game packets can be held back and dropped on their way out to see how
+// the protocol copes with bad connections, without needing one. Each node
+// only affects what it sends itself, so the round trip time goes up by the
+// sum of both sides' latency. Pregame packets are never affected. In a
+// -loopback game, the packets of the other nodes go through it as well.
+//
+// This only changes when and whether packets are sent. The packets
+// themselves and the way tics are resent are the same as without it.
+//
+CVAR(Int, net_fakelatency, 0, 0)	// milliseconds added to each outgoing packet
+CVAR(Int, net_fakejitter, 0, 0)		// random +/- milliseconds on top of that. Packets may arrive out of order.
+CVAR(Int, net_fakeloss, 0, 0)		// percentage of outgoing packets that get lost
+
+struct FDelayedPacket
+{
+	uint64_t SendTime;
+	int Node;
+	bool Inbound;		// from a loopback node to this machine
+	TArray<uint8_t> Data;
+};
+
+static TArray<FDelayedPacket> DelayedPackets;
+static std::mt19937 SimRandom;
+
+//
+// Loopback network
+//
+// -loopback <numplayers> starts a netgame without any sockets. This machine
+// is the host, and the other nodes live in the same process: the game plays
+// their side of the protocol through the loopback callbacks in sysCallbacks.
+// Their packets are coded and go through the simulation above just like real
+// ones, so bandwidth and recovery from loss can be measured on one machine.
+//
+static int LoopbackNodes;
+static TArray<FDelayedPacket> LoopbackInbox;
+static uint8_t LoopbackBuffer[MAX_MSGLEN];
+
+// Traffic counters for the 'net' stat
+static struct FNetTraffic
+{
+	uint64_t PacketsSent, BytesSent, UncompressedSent;
+	uint64_t PacketsReceived, BytesReceived;
+	uint64_t PacketsLost;
+} NetTraffic;
+
+static int DecodePacket (const uint8_t *packet, int size, uint8_t *data);
+
+static void QueuePacket (TArray<FDelayedPacket> &queue, uint64_t time, int node, bool inbound, const uint8_t *data, int len)
+{
+	FDelayedPacket &packet = queue[queue.Reserve(1)];
+	packet.SendTime = time;
+	packet.Node = node;
+	packet.Inbound = inbound;
+	packet.Data.Resize(len);
+	memcpy(packet.Data.Data(), data, len);
+}
+
+static void SendTo (int node, bool inbound, const uint8_t *data, int len)
+{
+	if (inbound)
+	{
+		QueuePacket(LoopbackInbox, 0, node, true, data, len);
+	}
+	else if (LoopbackNodes > 0)
+	{
+		len = DecodePacket(data, len, LoopbackBuffer);
+		if (len > 0 && sysCallbacks.LoopbackReceive)
+		{
+			sysCallbacks.LoopbackReceive(node, LoopbackBuffer, len);
+		}
+	}
+	else
+	{
+		sendto(mysocket, (const char *)data, len, 0, (sockaddr *)&sendaddress[node], sizeof(sendaddress[node]));
+	}
+}
+
+static void SimulateSend (int node, bool inbound, const uint8_t *data, int len)
+{
+	if (net_fakeloss > 0 && int(SimRandom() % 100) < net_fakeloss)
+	{
+		NetTraffic.PacketsLost++;
+		return;
+	}
+
+	int delay = max(*net_fakelatency, 0);
+	if (net_fakejitter > 0)
+	{
+		delay += int(SimRandom() % (2 * net_fakejitter + 1)) - net_fakejitter;
+	}
+	if (delay <= 0 && DelayedPackets.Size() == 0)
+	{
+		SendTo(node, inbound, data, len);
+		return;
+	}
+
+	QueuePacket(DelayedPackets, I_msTime() + max(delay, 0), node, inbound, data, len);
+}
+
+static void Transmit (int node, bool inbound, const uint8_t *data, int len)
+{
+	if (net_fakelatency > 0 || net_fakejitter > 0 || net_fakeloss > 0 || DelayedPackets.Size() > 0)
+	{
+		SimulateSend(node, inbound, data, len);
+	}
+	else
+	{
+		SendTo(node, inbound, data, len);
+	}
+}
+
+static void SendDelayedPackets ()
+{
+	if (DelayedPackets.Size() == 0)
+		return;
+
+	uint64_t now = I_msTime();
+	for (unsigned i = 0; i < DelayedPackets.Size(); )
+	{
+		if (DelayedPackets[i].SendTime <= now)
+		{
+			SendTo(DelayedPackets[i].Node, DelayedPackets[i].Inbound, DelayedPackets[i].Data.Data(), DelayedPackets[i].Data.Size());
+			DelayedPackets.Delete(i);
+		}
+		else i++;
+	}
+}
+
+ADD_STAT(net)
+{
+	static FNetTraffic last;
+	static uint64_t lasttime;
+	static FString rates;
+
+	uint64_t now = I_msTime();
+	if (now - lasttime >= 1000)
+	{
+		double secs = lasttime == 0 ? 1 : (now - lasttime) / 1000.;
+		uint64_t sent = NetTraffic.BytesSent - last.BytesSent;
+		uint64_t uncompressed = NetTraffic.UncompressedSent - last.UncompressedSent;
+		rates.Format("out: %.0f packets/s, %.2f kB/s (%.0f%% of uncompressed)  in: %.0f packets/s, %.2f kB/s",
+			(NetTraffic.PacketsSent - last.PacketsSent) / secs, sent / secs / 1024.,
+			uncompressed > 0 ? sent * 100. / uncompressed : 100.,
+			(NetTraffic.PacketsReceived - last.PacketsReceived) / secs, (NetTraffic.BytesReceived - last.BytesReceived) / secs / 1024.);
+		last = NetTraffic;
+		lasttime = now;
+	}
+
+	FString out = rates;
+	if (NetTraffic.PacketsLost > 0 || DelayedPackets.Size() > 0)
+	{
+		out.AppendFormat("\nsimulated: %llu packets lost, %u in flight", (unsigned long long)NetTraffic.PacketsLost, DelayedPackets.Size());
+	}
+	return out;
+}
+
 FString GetPlayerName(int num)
 {
 	if (sysCallbacks.GetPlayerName) return sysCallbacks.GetPlayerName(sendplayer[num]);
@@ -218,55 +382,346 @@ int FindNode (const sockaddr_in *address)
 }
 
 //
-// PacketSend
+// Packet range coder
 //
-void PacketSend (void)
+// An adaptive binary range coder in the style of LZMA's. Game packets are
+// short bundles of delta-encoded tics, so there is little for zlib's
+// string matching to find, but most bytes are small or zero. Each byte is
+// coded one bit at a time with probabilities picked by the kind of byte
+// that came before it, which learns that much faster than a Huffman table
+// could within one packet. A flag bit in front of every byte marks the end
+// of the data, so no length needs to be sent.
+//
+
+enum
 {
-	int c;
+	RC_PROBBITS = 12,
+	RC_MOVEBITS = 4,
+	RC_TOP = 1 << 24,
+	RC_CONTEXTS = 4,
+};
+
+struct FPacketModel
+{
+	uint16_t Bytes[RC_CONTEXTS][256];
+	uint16_t End;
+
+	FPacketModel()
+	{
+		for (auto &context : Bytes)
+		{
+			for (auto &prob : context) prob = 1 << (RC_PROBBITS - 1);
+		}
+		End = 1 << (RC_PROBBITS - 1);
+	}
+
+	static int Context(int prev)
+	{
+		return prev == 0 ? 0 : prev == 0xff ? 1 : prev < 0x10 ? 2 : 3;
+	}
+};
+
+class FRangeEncoder
+{
+	uint64_t Low = 0;
+	uint32_t Range = 0xFFFFFFFF;
+	uint8_t Cache = 0;
+	int CacheSize = 0;
+	bool First = true;
+	uint8_t *Out, *OutEnd;
+
+	void Put(uint8_t b)
+	{
+		// The first byte is always 0, since everything is coded below 1. Leave it out.
+		if (First) First = false;
+		else if (Out < OutEnd) *Out++ = b;
+		else Overflow = true;
+	}
+
+	void ShiftLow()
+	{
+		if (uint32_t(Low) < 0xFF000000u || (Low >> 32) != 0)
+		{
+			uint8_t carry = uint8_t(Low >> 32);
+			uint8_t temp = Cache;
+			do
+			{
+				Put(uint8_t(temp + carry));
+				temp = 0xFF;
+			} while (--CacheSize >= 0);
+			CacheSize = 0;
+			Cache = uint8_t(Low >> 24);
+		}
+		else
+		{
+			CacheSize++;
+		}
+		Low = uint32_t(Low) << 8;
+	}
+
+public:
+	bool Overflow = false;
+
+	FRangeEncoder(uint8_t *out, int size) : Out(out), OutEnd(out + size) {}
+
+	void Bit(uint16_t &prob, int bit)
+	{
+		uint32_t bound = (Range >> RC_PROBBITS) * prob;
+		if (bit == 0)
+		{
+			Range = bound;
+			prob += ((1 << RC_PROBBITS) - prob) >> RC_MOVEBITS;
+		}
+		else
+		{
+			Low += bound;
+			Range -= bound;
+			prob -= prob >> RC_MOVEBITS;
+		}
+		while (Range < RC_TOP)
+		{
+			Range <<= 8;
+			ShiftLow();
+		}
+	}
+
+	uint8_t *Finish(const uint8_t *start)
+	{
+		// Any value in [Low, Low + Range) decodes the same. Pick the one with the
+		// most trailing zero bits, because the decoder reads zeros past the end.
+		for (int bits = 32; bits > 0; bits--)
+		{
+			uint64_t mask = (uint64_t(1) << bits) - 1;
+			uint64_t value = (Low + mask) & ~mask;
+			if (value < Low + Range)
+			{
+				Low = value;
+				break;
+			}
+		}
+		for (int i = 0; i < 5; i++)
+		{
+			ShiftLow();
+		}
+		while (Out > start && Out[-1] == 0)
+		{
+			Out--;
+		}
+		return Out;
+	}
+};
+
+class FRangeDecoder
+{
+	uint32_t Range = 0xFFFFFFFF;
+	uint32_t Code = 0;
+	const uint8_t *In, *InEnd;
+
+	uint8_t Next()
+	{
+		return In < InEnd ? *In++ : 0;
+	}
+
+public:
+	FRangeDecoder(const uint8_t *in, int size) : In(in), InEnd(in + size)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			Code = (Code << 8) | Next();
+		}
+	}
+
+	int Bit(uint16_t &prob)
+	{
+		uint32_t bound = (Range >> RC_PROBBITS) * prob;
+		int bit;
+		if (Code < bound)
+		{
+			Range = bound;
+			prob += ((1 << RC_PROBBITS) - prob) >> RC_MOVEBITS;
+			bit = 0;
+		}
+		else
+		{
+			Code -= bound;
+			Range -= bound;
+			prob -= prob >> RC_MOVEBITS;
+			bit = 1;
+		}
+		while (Range < RC_TOP)
+		{
+			Range <<= 8;
+			Code = (Code << 8) | Next();
+		}
+		return bit;
+	}
+};
+
+// Returns the coded size, or -1 if it doesn't fit in outsize bytes.
+static int RangeEncode (const uint8_t *in, int len, uint8_t *out, int outsize)
+{
+	FPacketModel model;
+	FRangeEncoder rc(out, outsize);
+	int prev = 0;
+
+	for (int i = 0; i < len && !rc.Overflow; i++)
+	{
+		uint16_t *probs = model.Bytes[FPacketModel::Context(prev)];
+		int node = 1;
+
+		rc.Bit(model.End, 0);
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			int b = (in[i] >> bit) & 1;
+			rc.Bit(probs[node], b);
+			node = node * 2 + b;
+		}
+		prev = in[i];
+	}
+	rc.Bit(model.End, 1);
+	uint8_t *end = rc.Finish(out);
+	return rc.Overflow ? -1 : int(end - out);
+}
+
+// Returns the decoded size, or -1 if the data is bad.
+static int RangeDecode (const uint8_t *in, int len, uint8_t *out, int outsize)
+{
+	FPacketModel model;
+	FRangeDecoder rc(in, len);
+	int prev = 0;
+	int size = 0;
+
+	while (rc.Bit(model.End) == 0)
+	{
+		uint16_t *probs = model.Bytes[FPacketModel::Context(prev)];
+		int node = 1;
+
+		if (size == outsize)
+		{
+			return -1;
+		}
+		while (node < 256)
+		{
+			node = node * 2 + rc.Bit(probs[node]);
+		}
+		out[size++] = prev = node - 256;
+	}
+	return size;
+}
+
+//
+// EncodePacket
+//
+// Codes a packet with whichever of zlib and the range coder makes it
+// smallest. The range coder usually wins on plain tics, while zlib finds
+// the repeats in chat text and the other net specials.
+//
+
+static uint8_t RangeBuffer[TRANSMIT_SIZE];
+
+static const uint8_t *EncodePacket (const uint8_t *data, int len, int &size)
+{
+	const uint8_t *packet = data;
+	int c = -1;	// Just some random error code for when zlib isn't tried.
 
 	// FIXME: Catch this before we've overflown the buffer. With long chat
 	// text and lots of backup tics, it could conceivably happen. (Though
 	// apparently it hasn't yet, which is good.)
-	if (doomcom.datalength > MAX_MSGLEN)
+	if (len > MAX_MSGLEN)
 	{
 		I_FatalError("Netbuffer overflow!");
 	}
-	assert(!(doomcom.data[0] & NCMD_COMPRESSED));
+	assert(!(data[0] & (NCMD_COMPRESSED | NCMD_RANGECODED)));
 
-	uLong size = TRANSMIT_SIZE - 1;
-	if (doomcom.datalength >= 10)
+	size = len;
+	if (len >= 10)
 	{
-		TransmitBuffer[0] = doomcom.data[0] | NCMD_COMPRESSED;
-		c = compress2(TransmitBuffer + 1, &size, doomcom.data + 1, doomcom.datalength - 1, 9);
-		size += 1;
+		uLong zsize = TRANSMIT_SIZE - 1;
+		TransmitBuffer[0] = data[0] | NCMD_COMPRESSED;
+		c = compress2(TransmitBuffer + 1, &zsize, data + 1, len - 1, 9);
+		if (c == Z_OK && int(zsize + 1) < size)
+		{
+			packet = TransmitBuffer;
+			size = int(zsize + 1);
+		}
 	}
-	else
+	if (len >= 2)
 	{
-		c = -1;	// Just some random error code to avoid sending the compressed buffer.
+		RangeBuffer[0] = data[0] | NCMD_RANGECODED;
+		int rsize = RangeEncode(data + 1, len - 1, RangeBuffer + 1, min(size, TRANSMIT_SIZE) - 1);
+		if (rsize >= 0 && rsize + 1 < size)
+		{
+			packet = RangeBuffer;
+			size = rsize + 1;
+		}
 	}
-	if (c == Z_OK && size < (uLong)doomcom.datalength)
+	if (size > TRANSMIT_SIZE)
 	{
-//		Printf("send %lu/%d\n", size, doomcom.datalength);
-		c = sendto(mysocket, (char *)TransmitBuffer, size,
-			0, (sockaddr *)&sendaddress[doomcom.remotenode],
-			sizeof(sendaddress[doomcom.remotenode]));
+		I_Error("Net compression failed (zlib error %d)", c);
 	}
-	else
+	return packet;
+}
+
+//
+// DecodePacket
+//
+// Returns the size of the decoded packet, or -1 if it couldn't be decoded.
+//
+
+static int DecodePacket (const uint8_t *packet, int size, uint8_t *data)
+{
+	data[0] = packet[0] & ~(NCMD_COMPRESSED | NCMD_RANGECODED);
+	if (packet[0] & NCMD_COMPRESSED)
 	{
-		if (doomcom.datalength > TRANSMIT_SIZE)
+		uLongf msgsize = MAX_MSGLEN - 1;
+		int err = uncompress(data + 1, &msgsize, packet + 1, size - 1);
+		if (err != Z_OK)
 		{
-			I_Error("Net compression failed (zlib error %d)", c);
+			Printf("Net decompression failed (zlib error %s)\n", M_ZLibError(err).GetChars());
+			return -1;
 		}
-		else
+		return int(msgsize + 1);
+	}
+	else if (packet[0] & NCMD_RANGECODED)
+	{
+		int msgsize = RangeDecode(packet + 1, size - 1, data + 1, MAX_MSGLEN - 1);
+		if (msgsize < 0)
 		{
-//			Printf("send %d\n", doomcom.datalength);
-			c = sendto(mysocket, (char *)doomcom.data, doomcom.datalength,
-				0, (sockaddr *)&sendaddress[doomcom.remotenode],
-				sizeof(sendaddress[doomcom.remotenode]));
+			Printf("Net decompression failed (bad range coded packet)\n");
+			return -1;
 		}
+		return msgsize + 1;
 	}
-	//	if (c == -1)
-	//			I_Error ("SendPacket error: %s",strerror(errno));
+	memcpy(data + 1, packet + 1, size - 1);
+	return size;
+}
+
+//
+// PacketSend
+//
+void PacketSend (void)
+{
+	int size;
+	const uint8_t *packet = EncodePacket(doomcom.data, doomcom.datalength, size);
+
+	NetTraffic.PacketsSent++;
+	NetTraffic.BytesSent += size;
+	NetTraffic.UncompressedSent += doomcom.datalength;
+
+	Transmit(doomcom.remotenode, false, packet, size);
+}
+
+//
+// I_LoopbackSend
+//
+// Sends a packet from one of the loopback nodes to this machine.
+//
+void I_LoopbackSend (int node, const uint8_t *data, int len)
+{
+	int size;
+	const uint8_t *packet = EncodePacket(data, len, size);
+
+	Transmit(node, true, packet, size);
 }
 
 
@@ -280,10 +735,25 @@ void PacketGet (void)
 	sockaddr_in fromaddress;
 	int node;
 
-	fromlen = sizeof(fromaddress);
-	c = recvfrom (mysocket, (char*)TransmitBuffer, TRANSMIT_SIZE, 0,
-				  (sockaddr *)&fromaddress, &fromlen);
-	node = FindNode (&fromaddress);
+	if (LoopbackNodes > 0)
+	{
+		if (LoopbackInbox.Size() == 0)
+		{
+			doomcom.remotenode = -1;		// no packet
+			return;
+		}
+		node = LoopbackInbox[0].Node;
+		c = LoopbackInbox[0].Data.Size();
+		memcpy(TransmitBuffer, LoopbackInbox[0].Data.Data(), c);
+		LoopbackInbox.Delete(0);
+	}
+	else
+	{
+		fromlen = sizeof(fromaddress);
+		c = recvfrom (mysocket, (char*)TransmitBuffer, TRANSMIT_SIZE, 0,
+					  (sockaddr *)&fromaddress, &fromlen);
+		node = FindNode (&fromaddress);
+	}
 
 	if (node >= 0 && c == SOCKET_ERROR)
 	{
@@ -318,25 +788,15 @@ void PacketGet (void)
 	}
 	else if (node >= 0 && c > 0)
 	{
-		doomcom.data[0] = TransmitBuffer[0] & ~NCMD_COMPRESSED;
-		if (TransmitBuffer[0] & NCMD_COMPRESSED)
-		{
-			uLongf msgsize = MAX_MSGLEN - 1;
-			int err = uncompress(doomcom.data + 1, &msgsize, TransmitBuffer + 1, c - 1);
-//			Printf("recv %d/%lu\n", c, msgsize + 1);
-			if (err != Z_OK)
-			{
-				Printf("Net decompression failed (zlib error %s)\n", M_ZLibError(err).GetChars());
-				// Pretend no packet
-				doomcom.remotenode = -1;
-				return;
-			}
-			c = msgsize + 1;
-		}
-		else
+		NetTraffic.PacketsReceived++;
+		NetTraffic.BytesReceived += c;
+
+		c = DecodePacket(TransmitBuffer, c, doomcom.data);
+		if (c < 0)
 		{
-//			Printf("recv %d\n", c);
-			memcpy(doomcom.data + 1, TransmitBuffer + 1, c - 1);
+			// Pretend no packet
+			doomcom.remotenode = -1;
+			return;
 		}
 	}
 	else if (c > 0)
@@ -435,6 +895,8 @@ void BuildAddress (sockaddr_in *address, const char *name)
 
 void CloseNetwork (void)
 {
+	DelayedPackets.Clear();
+	LoopbackInbox.Clear();
 	if (mysocket != INVALID_SOCKET)
 	{
 		closesocket (mysocket);
@@ -923,6 +1385,40 @@ static int PrivateNetOf(in_addr in)
 	return 0;
 }
 
+//
+// StartLoopback
+//
+// Sets up a -loopback game. This machine is node 0 and the host, and every
+// other node is played by the game in this process.
+//
+static void StartLoopback (int i)
+{
+	int numplayers;
+
+	if ((i == Args->NumArgs() - 1) || !(numplayers = atoi (Args->GetArg(i+1))))
+	{	// No player count specified, assume 2
+		numplayers = 2;
+	}
+
+	if (numplayers > MAXNETNODES || numplayers < 2)
+	{
+		I_FatalError("You cannot start a loopback game with %d players. It needs 2 to %d.", numplayers, MAXNETNODES);
+	}
+
+	netgame = true;
+	multiplayer = true;
+
+	doomcom.id = DOOMCOM_ID;
+	doomcom.consoleplayer = 0;
+	doomcom.numplayers = doomcom.numnodes = LoopbackNodes = numplayers;
+
+	for (i = 0; i < numplayers; ++i)
+	{
+		sendplayer[i] = i;
+	}
+	Printf ("Loopback game with %d players\n", numplayers);
+}
+
 //
 // NodesOnSameNetwork
 //
@@ -985,6 +1481,7 @@ int I_InitNetwork (void)
 	// parse network game options,
 	//		player 1: -host <numplayers>
 	//		player x: -join <player 1's address>
+	//		testing:  -loopback <numplayers>
 	if ( (i = Args->CheckParm ("-host")) )
 	{
 		if (!HostGame (i)) return -1;
@@ -993,6 +1490,11 @@ int I_InitNetwork (void)
 	{
 		if (!JoinGame (i)) return -1;
 	}
+	else if ( (i = Args->CheckParm ("-loopback")) )
+	{
+		StartLoopback (i);
+		return false;
+	}
 	else
 	{
 		// single player game
@@ -1014,6 +1516,18 @@ int I_InitNetwork (void)
 
 void I_NetCmd (void)
 {
+	// Delayed packets go out whenever the game polls the network, which it does every frame.
+	SendDelayedPackets();
+
+	// The loopback nodes get to run just as often.
+	if (sysCallbacks.LoopbackUpdate)
+	{
+		for (int node = 1; node < LoopbackNodes; node++)
+		{
+			sysCallbacks.LoopbackUpdate(node);
+		}
+	}
+
 	if (doomcom.command == CMD_SEND)
 	{
 		PacketSend ();
@@ -11,6 +11,7 @@ void I_NetProgress(int val);
 void I_NetInit(const char* msg, int num);
 bool I_NetLoop(bool (*timer_callback)(void*), void* userdata);
 void I_NetDone();
+void I_LoopbackSend(int node, const uint8_t *data, int len);
 
 enum ENetConstants
 {
@@ -32,21 +33,25 @@ enum ENetConstants
 //  One byte with following flags.
 //  One byte with starttic
 //  One byte with master's maketic (master -> slave only!)
-//  If NCMD_RETRANSMIT set, one byte with retransmitfrom
+//  One byte with the first tic the sender still needs from the receiver (acknowledges all before it)
 //  If NCMD_XTICS set, one byte with number of tics (minus 3, so theoretically up to 258 tics in one packet)
 //  If NCMD_QUITTERS, one byte with number of players followed by one byte with each player's consolenum
+//  One byte with the sender's network delay
 //  If NCMD_MULTI, one byte with number of players followed by one byte with each player's consolenum
 //     - The first player's consolenum is not included in this list, because it always matches the sender
 //
 // For each tic:
 //  Two bytes with consistancy check, followed by tic data
 //
+// Tics are sent from the last one the receiver acknowledged, so every packet
+// repeats whatever may have been lost since then.
+//
 // Setup packets are different, and are described just before D_ArbitrateNetStart().
 
 enum ENCMD
 {
 	NCMD_EXIT				= 0x80,
-	NCMD_RETRANSMIT 		= 0x40,
+	NCMD_RANGECODED			= 0x40,		// remainder of packet is range coded
 	NCMD_SETUP				= 0x20,
 	NCMD_MULTI				= 0x10,		// multiple players in this packet
 	NCMD_QUITTERS			= 0x08,		// one or more players just quit (packet server only)
@@ -42,6 +42,7 @@
 #include "voxels.h"
 #include "texturemanager.h"
 #include "modelrenderer.h"
+#include "workerpool.h"
 
 
 TArray<FString> savedModelFiles;
@@ -50,6 +51,13 @@ TArray<FSpriteModelFrame> SpriteModelFrames;
 TMap<void*, FSpriteModelFrame> BaseSpriteModelFrames;
 
 
+/////////////////////////////////////////////////////////////////////////////
+
+void BuildModelMeshes(const TArray<FModel*> &models)
+{
+	RunOnWorkerPool(models.Size(), [&](int i) { models[i]->BuildMesh(); });
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 void FlushModels()
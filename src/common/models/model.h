@@ -85,6 +85,8 @@ public:
 
 	virtual void RenderFrame(FModelRenderer *renderer, FGameTexture * skin, int frame, int frame2, double inter, FTranslationID translation, const FTextureID* surfaceskinids, const TArray<VSMatrix>& boneData, int boneStartPosition) = 0;
 	virtual void BuildVertexBuffer(FModelRenderer *renderer) = 0;
+	// Generates the CPU side geometry ahead of BuildVertexBuffer. This gets called from worker threads so it may not touch the renderer.
+	virtual void BuildMesh() {}
 	virtual void AddSkins(uint8_t *hitlist, const FTextureID* surfaceskinids) = 0;
 	virtual float getAspectFactor(float vscale) { return 1.f; }
 	virtual const TArray<TRS>* AttachAnimationData() { return nullptr; };
@@ -102,6 +104,7 @@ private:
 	IModelVertexBuffer *mVBuf[NumModelRendererTypes];
 };
 
+void BuildModelMeshes(const TArray<FModel*> &models);
 int ModelFrameHash(FSpriteModelFrame* smf);
 unsigned FindModel(const char* path, const char* modelfile, bool silent = false);
 
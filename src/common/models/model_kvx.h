@@ -46,18 +46,19 @@ protected:
 	bool mOwningVoxel;	// if created through MODELDEF deleting this object must also delete the voxel object
 	FTextureID mPalette;
 	unsigned int mNumIndices;
+	bool mMeshBuilt = false;
 	TArray<FModelVertex> mVertices;
 	TArray<unsigned int> mIndices;
 
-	void MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check);
-	void AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t color, FVoxelMap &check);
-	unsigned int AddVertex(FModelVertex &vert, FVoxelMap &check);
-
 public:
 	FVoxelModel(FVoxel *voxel, bool owned);
 	~FVoxelModel();
 	bool Load(const char * fn, int lumpnum, const char * buffer, int length) override;
 	void Initialize();
+	void BuildMesh() override;
+
+	// greedy merges coplanar faces of the same color into larger quads, otherwise only vertical runs within a slab get merged.
+	static void MakeMesh(FVoxel *voxel, bool greedy, TArray<FModelVertex> &vertices, TArray<unsigned int> &indices);
 	virtual int FindFrame(const char* name, bool nodefault) override;
 	virtual void RenderFrame(FModelRenderer *renderer, FGameTexture * skin, int frame, int frame2, double inter, FTranslationID translation, const FTextureID* surfaceskinids, const TArray<VSMatrix>& boneData, int boneStartPosition) override;
 	virtual void AddSkins(uint8_t *hitlist, const FTextureID* surfaceskinids) override;
@@ -38,6 +38,13 @@
 #include "palettecontainer.h"
 #include "textures.h"
 #include "imagehelpers.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "stats.h"
+#include <algorithm>
+
+CVAR(Bool, gl_voxel_greedymesh, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 #ifdef _MSC_VER
 #pragma warning(disable:4244) // warning C4244: conversion from 'double' to 'float', possible loss of data
@@ -178,13 +185,37 @@ FVoxelModel::~FVoxelModel()
 }
 
 
+//===========================================================================
+//
+// Slab mesher
+//
+// Emits the faces of each slab directly, only merging vertical runs of
+// the same color.
+//
+//===========================================================================
+
+struct FVoxelSlabMesher
+{
+	FVoxelMipLevel *mip;
+	TArray<FModelVertex> &mVertices;
+	TArray<unsigned int> &mIndices;
+	FVoxelMap check;
+
+	FVoxelSlabMesher(FVoxelMipLevel *m, TArray<FModelVertex> &verts, TArray<unsigned int> &indices) : mip(m), mVertices(verts), mIndices(indices) {}
+
+	unsigned int AddVertex(FModelVertex &vert);
+	void AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t color);
+	void MakeSlabPolys(int x, int y, kvxslab_t *voxptr);
+	void MakeMesh();
+};
+
 //===========================================================================
 //
 // 
 //
 //===========================================================================
 
-unsigned int FVoxelModel::AddVertex(FModelVertex &vert, FVoxelMap &check)
+unsigned int FVoxelSlabMesher::AddVertex(FModelVertex &vert)
 {
 	unsigned int index = check[vert];
 	if (index == 0xffffffff)
@@ -200,11 +231,11 @@ unsigned int FVoxelModel::AddVertex(FModelVertex &vert, FVoxelMap &check)
 //
 //===========================================================================
 
-void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t col, FVoxelMap &check)
+void FVoxelSlabMesher::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t col)
 {
-	float PivotX = mVoxel->Mips[0].Pivot.X;
-	float PivotY = mVoxel->Mips[0].Pivot.Y;
-	float PivotZ = mVoxel->Mips[0].Pivot.Z;
+	float PivotX = mip->Pivot.X;
+	float PivotY = mip->Pivot.Y;
+	float PivotZ = mip->Pivot.Z;
 	FModelVertex vert;
 	unsigned int indx[4];
 
@@ -215,22 +246,22 @@ void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3
 	vert.x =  x1 - PivotX;
 	vert.z = -y1 + PivotY;
 	vert.y = -z1 + PivotZ;
-	indx[0] = AddVertex(vert, check);
+	indx[0] = AddVertex(vert);
 
 	vert.x =  x2 - PivotX;
 	vert.z = -y2 + PivotY;
 	vert.y = -z2 + PivotZ;
-	indx[1] = AddVertex(vert, check);
+	indx[1] = AddVertex(vert);
 
 	vert.x =  x4 - PivotX;
 	vert.z = -y4 + PivotY;
 	vert.y = -z4 + PivotZ;
-	indx[2] = AddVertex(vert, check);
+	indx[2] = AddVertex(vert);
 
 	vert.x =  x3 - PivotX;
 	vert.z = -y3 + PivotY;
 	vert.y = -z3 + PivotZ;
-	indx[3] = AddVertex(vert, check);
+	indx[3] = AddVertex(vert);
 
 
 	mIndices.Push(indx[0]);
@@ -247,7 +278,7 @@ void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3
 //
 //===========================================================================
 
-void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check)
+void FVoxelSlabMesher::MakeSlabPolys(int x, int y, kvxslab_t *voxptr)
 {
 	const uint8_t *col = voxptr->col;
 	int zleng = voxptr->zleng;
@@ -256,7 +287,7 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 
 	if (cull & 16)
 	{
-		AddFace(x, y, ztop, x+1, y, ztop, x, y+1, ztop, x+1, y+1, ztop, *col, check);
+		AddFace(x, y, ztop, x+1, y, ztop, x, y+1, ztop, x+1, y+1, ztop, *col);
 	}
 	int z = ztop;
 	while (z < ztop+zleng)
@@ -266,19 +297,19 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 
 		if (cull & 1)
 		{
-			AddFace(x, y, z, x, y+1, z, x, y, z+c, x, y+1, z+c, *col, check);
+			AddFace(x, y, z, x, y+1, z, x, y, z+c, x, y+1, z+c, *col);
 		}
 		if (cull & 2)
 		{
-			AddFace(x+1, y+1, z, x+1, y, z, x+1, y+1, z+c, x+1, y, z+c, *col, check);
+			AddFace(x+1, y+1, z, x+1, y, z, x+1, y+1, z+c, x+1, y, z+c, *col);
 		}
 		if (cull & 4)
 		{
-			AddFace(x+1, y, z, x, y, z, x+1, y, z+c, x, y, z+c, *col, check);
+			AddFace(x+1, y, z, x, y, z, x+1, y, z+c, x, y, z+c, *col);
 		}
 		if (cull & 8)
 		{
-			AddFace(x, y+1, z, x+1, y+1, z, x, y+1, z+c, x+1, y+1, z+c, *col, check);
+			AddFace(x, y+1, z, x+1, y+1, z, x, y+1, z+c, x+1, y+1, z+c, *col);
 		}	
 		z+=c;
 		col+=c;
@@ -286,7 +317,7 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 	if (cull & 32)
 	{
 		int zz = ztop+zleng-1;
-		AddFace(x+1, y, zz+1, x, y, zz+1, x+1, y+1, zz+1, x, y+1, zz+1, voxptr->col[zleng-1], check);
+		AddFace(x+1, y, zz+1, x, y, zz+1, x+1, y+1, zz+1, x, y+1, zz+1, voxptr->col[zleng-1]);
 	}
 }
 
@@ -296,10 +327,8 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 //
 //===========================================================================
 
-void FVoxelModel::Initialize()
+void FVoxelSlabMesher::MakeMesh()
 {
-	FVoxelMap check;
-	FVoxelMipLevel *mip = &mVoxel->Mips[0];
 	for (int x = 0; x < mip->SizeX; x++)
 	{
 		uint8_t *slabxoffs = &mip->GetSlabData(false)[mip->OffsetX[x]];
@@ -310,10 +339,496 @@ void FVoxelModel::Initialize()
 			kvxslab_t *voxend = (kvxslab_t *)(slabxoffs + xyoffs[y+1]);
 			for (; voxptr < voxend; voxptr = (kvxslab_t *)((uint8_t *)voxptr + voxptr->zleng + 3))
 			{
-				MakeSlabPolys(x, y, voxptr, check);
+				MakeSlabPolys(x, y, voxptr);
+			}
+		}
+	}
+}
+
+//===========================================================================
+//
+// Greedy mesher
+//
+// Sorts all exposed voxel faces by direction and slice, then merges
+// each slice's faces of the same color into rectangles. Vertices are
+// collected as integer lattice keys and deduplicated by sorting instead
+// of going through a hash map.
+//
+// A corner of one rectangle can lie in the middle of an edge of a bigger
+// neighbour. Rasterizing such a T-junction leaves sparkling gaps, so those
+// rectangles are split into a fan around their center that also goes
+// through every corner on their edges.
+//
+//===========================================================================
+
+struct FVoxelGreedyMesher
+{
+	enum
+	{
+		FaceLeft,	// -x, backfacecull & 1
+		FaceRight,	// +x, backfacecull & 2
+		FaceBack,	// -y, backfacecull & 4
+		FaceFront,	// +y, backfacecull & 8
+		FaceTop,	// -z, backfacecull & 16
+		FaceBottom,	// +z, backfacecull & 32
+		NumFaces
+	};
+
+	struct Face
+	{
+		uint16_t slice;
+		uint16_t u, v;
+		uint8_t color;
+	};
+
+	struct Quad
+	{
+		uint8_t dir, color;
+		uint16_t slice;
+		uint16_t u0, v0, u1, v1;
+	};
+
+	struct Corner
+	{
+		int pos[3];
+	};
+
+	FVoxelMipLevel *mip;
+	TArray<FModelVertex> &mVertices;
+	TArray<unsigned int> &mIndices;
+	int SizeZ = 0;
+	TArray<Face> Faces[NumFaces];
+	TArray<uint16_t> Mask;	// color + 1 of every unmerged face in the current slice, 0 if there is none.
+	int MaskWidth = 0, MaskHeight = 0;
+	TArray<Quad> Quads;
+	TArray<uint64_t> Lines[3];	// every corner position, sorted so that the corners on a line along each axis are contiguous.
+	TArray<Corner> Boundary;
+	TArray<uint64_t> Keys;	// lattice position and color of every emitted corner. mIndices points into this until Finish remaps it.
+
+	FVoxelGreedyMesher(FVoxelMipLevel *m, TArray<FModelVertex> &verts, TArray<unsigned int> &indices) : mip(m), mVertices(verts), mIndices(indices) {}
+
+	void CollectFaces();
+	void MergeFaces(int dir);
+	static void GetCorners(const Quad &quad, Corner c[4]);
+	static uint64_t LineKey(int axis, const int *pos);
+	void BuildLines();
+	void AddEdgeCorners(const Corner &a, const Corner &b);
+	void AddCorner(int x2, int y2, int z2, uint8_t color);
+	void AddQuad(const Quad &quad);
+	void Finish();
+	void MakeMesh();
+};
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::CollectFaces()
+{
+	SizeZ = mip->SizeZ;
+	for (int x = 0; x < mip->SizeX; x++)
+	{
+		uint8_t *slabxoffs = &mip->GetSlabData(false)[mip->OffsetX[x]];
+		short *xyoffs = &mip->OffsetXY[x * (mip->SizeY + 1)];
+		for (int y = 0; y < mip->SizeY; y++)
+		{
+			kvxslab_t *voxptr = (kvxslab_t *)(slabxoffs + xyoffs[y]);
+			kvxslab_t *voxend = (kvxslab_t *)(slabxoffs + xyoffs[y+1]);
+			for (; voxptr < voxend; voxptr = (kvxslab_t *)((uint8_t *)voxptr + voxptr->zleng + 3))
+			{
+				int ztop = voxptr->ztop;
+				int zleng = voxptr->zleng;
+				int cull = voxptr->backfacecull;
+				if (zleng == 0) continue;
+
+				SizeZ = max(SizeZ, ztop + zleng);
+				if (cull & 16) Faces[FaceTop].Push({ uint16_t(ztop), uint16_t(x), uint16_t(y), voxptr->col[0] });
+				if (cull & 32) Faces[FaceBottom].Push({ uint16_t(ztop + zleng - 1), uint16_t(x), uint16_t(y), voxptr->col[zleng - 1] });
+				for (int i = 0; i < zleng; i++)
+				{
+					uint16_t z = uint16_t(ztop + i);
+					uint8_t col = voxptr->col[i];
+					if (cull & 1) Faces[FaceLeft].Push({ uint16_t(x), uint16_t(y), z, col });
+					if (cull & 2) Faces[FaceRight].Push({ uint16_t(x), uint16_t(y), z, col });
+					if (cull & 4) Faces[FaceBack].Push({ uint16_t(y), uint16_t(x), z, col });
+					if (cull & 8) Faces[FaceFront].Push({ uint16_t(y), uint16_t(x), z, col });
+				}
+			}
+		}
+	}
+}
+
+//===========================================================================
+//
+// Lattice keys are unique per position and color, so vertices only get
+// shared between faces that also share a texture coordinate. Positions are
+// passed in half units, because fan centers can lie between voxel corners.
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::AddCorner(int x2, int y2, int z2, uint8_t color)
+{
+	uint64_t pos = (uint64_t(z2) * (2 * mip->SizeY + 1) + y2) * (2 * mip->SizeX + 1) + x2;
+	mIndices.Push(Keys.Push((pos << 8) | color));
+}
+
+//===========================================================================
+//
+// Corner order is the same as in FVoxelSlabMesher so that the winding
+// of the merged quads does not change.
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::GetCorners(const Quad &q, Corner c[4])
+{
+	int s = q.slice, u0 = q.u0, v0 = q.v0, u1 = q.u1, v1 = q.v1;
+	auto set = [&](int i, int x, int y, int z) { c[i].pos[0] = x; c[i].pos[1] = y; c[i].pos[2] = z; };
+
+	switch (q.dir)
+	{
+	case FaceLeft:
+		set(0, s, u0, v0); set(1, s, u1, v0); set(2, s, u0, v1); set(3, s, u1, v1);
+		break;
+	case FaceRight:
+		set(0, s+1, u1, v0); set(1, s+1, u0, v0); set(2, s+1, u1, v1); set(3, s+1, u0, v1);
+		break;
+	case FaceBack:
+		set(0, u1, s, v0); set(1, u0, s, v0); set(2, u1, s, v1); set(3, u0, s, v1);
+		break;
+	case FaceFront:
+		set(0, u0, s+1, v0); set(1, u1, s+1, v0); set(2, u0, s+1, v1); set(3, u1, s+1, v1);
+		break;
+	case FaceTop:
+		set(0, u0, v0, s); set(1, u1, v0, s); set(2, u0, v1, s); set(3, u1, v1, s);
+		break;
+	default:
+		set(0, u1, v0, s+1); set(1, u0, v0, s+1); set(2, u1, v1, s+1); set(3, u0, v1, s+1);
+		break;
+	}
+}
+
+//===========================================================================
+//
+// Sort key that puts the position along the given axis last, so all
+// corners on one line along that axis end up next to each other.
+//
+//===========================================================================
+
+uint64_t FVoxelGreedyMesher::LineKey(int axis, const int *pos)
+{
+	int a = (axis + 1) % 3, b = (axis + 2) % 3;
+	return (uint64_t(pos[a]) << 32) | (uint64_t(pos[b]) << 16) | uint64_t(pos[axis]);
+}
+
+void FVoxelGreedyMesher::BuildLines()
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		auto &line = Lines[axis];
+		line.Clear();
+		line.Reserve(Quads.Size() * 4);
+		for (auto &quad : Quads)
+		{
+			Corner c[4];
+			GetCorners(quad, c);
+			for (auto &corner : c)
+			{
+				line.Push(LineKey(axis, corner.pos));
+			}
+		}
+		std::sort(line.begin(), line.end());
+		line.Resize(unsigned(std::unique(line.begin(), line.end()) - line.begin()));
+	}
+}
+
+//===========================================================================
+//
+// Adds the corners of other quads that lie strictly between a and b,
+// in order from a to b.
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::AddEdgeCorners(const Corner &a, const Corner &b)
+{
+	int axis = a.pos[0] != b.pos[0] ? 0 : a.pos[1] != b.pos[1] ? 1 : 2;
+	int from = a.pos[axis], to = b.pos[axis];
+	int lo = min(from, to), hi = max(from, to);
+	if (hi - lo < 2) return;
+
+	auto &line = Lines[axis];
+	uint64_t base = LineKey(axis, a.pos) & ~uint64_t(0xffff);
+	auto first = std::upper_bound(line.begin(), line.end(), base | uint64_t(lo));
+	auto last = std::lower_bound(first, line.end(), base | uint64_t(hi));
+
+	unsigned start = Boundary.Size();
+	for (auto it = first; it != last; ++it)
+	{
+		Corner c = a;
+		c.pos[axis] = int(*it & 0xffff);
+		Boundary.Push(c);
+	}
+	if (from > to)
+	{
+		std::reverse(Boundary.begin() + start, Boundary.end());
+	}
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::AddQuad(const Quad &quad)
+{
+	Corner c[4];
+	GetCorners(quad, c);
+
+	// Walking the corners in this order follows the winding of both triangles.
+	static const int loop[4] = { 0, 1, 3, 2 };
+	Boundary.Clear();
+	for (int i = 0; i < 4; i++)
+	{
+		Boundary.Push(c[loop[i]]);
+		AddEdgeCorners(c[loop[i]], c[loop[(i + 1) & 3]]);
+	}
+
+	if (Boundary.Size() == 4)
+	{
+		// Same triangulation as FVoxelSlabMesher::AddFace: (1,2,3) and (2,4,3).
+		static const int order[6] = { 0, 1, 2, 1, 3, 2 };
+		for (int i : order)
+		{
+			AddCorner(c[i].pos[0] * 2, c[i].pos[1] * 2, c[i].pos[2] * 2, quad.color);
+		}
+	}
+	else
+	{
+		// Corners 0 and 3 are opposite each other, so their sum is the center in half units.
+		int cx = c[0].pos[0] + c[3].pos[0];
+		int cy = c[0].pos[1] + c[3].pos[1];
+		int cz = c[0].pos[2] + c[3].pos[2];
+		unsigned count = Boundary.Size();
+		for (unsigned i = 0; i < count; i++)
+		{
+			const int *p1 = Boundary[i].pos;
+			const int *p2 = Boundary[(i + 1) % count].pos;
+			AddCorner(cx, cy, cz, quad.color);
+			AddCorner(p1[0] * 2, p1[1] * 2, p1[2] * 2, quad.color);
+			AddCorner(p2[0] * 2, p2[1] * 2, p2[2] * 2, quad.color);
+		}
+	}
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::MergeFaces(int dir)
+{
+	auto &faces = Faces[dir];
+	if (faces.Size() == 0) return;
+
+	// Sort so that every slice is contiguous and within a slice the first remaining face is always the top left corner of a new rectangle.
+	std::sort(faces.begin(), faces.end(), [](const Face &a, const Face &b)
+	{
+		if (a.slice != b.slice) return a.slice < b.slice;
+		if (a.v != b.v) return a.v < b.v;
+		return a.u < b.u;
+	});
+
+	unsigned start = 0;
+	while (start < faces.Size())
+	{
+		unsigned end = start;
+		int slice = faces[start].slice;
+		while (end < faces.Size() && faces[end].slice == slice)
+		{
+			Mask[faces[end].v * MaskWidth + faces[end].u] = faces[end].color + 1;
+			end++;
+		}
+
+		for (unsigned i = start; i < end; i++)
+		{
+			const Face &face = faces[i];
+			uint16_t *row = &Mask[face.v * MaskWidth];
+			uint16_t col = face.color + 1;
+			if (row[face.u] != col) continue;	// already merged into an earlier rectangle.
+
+			int u1 = face.u + 1;
+			while (u1 < MaskWidth && row[u1] == col) u1++;
+
+			int v1 = face.v + 1;
+			for (; v1 < MaskHeight; v1++)
+			{
+				uint16_t *next = &Mask[v1 * MaskWidth];
+				int u = face.u;
+				while (u < u1 && next[u] == col) u++;
+				if (u < u1) break;
+			}
+
+			for (int v = face.v; v < v1; v++)
+			{
+				memset(&Mask[v * MaskWidth + face.u], 0, (u1 - face.u) * sizeof(uint16_t));
 			}
+			Quads.Push({ uint8_t(dir), face.color, uint16_t(slice), face.u, face.v, uint16_t(u1), uint16_t(v1) });
+		}
+		start = end;
+	}
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::Finish()
+{
+	TArray<unsigned int> order(Keys.Size());
+	for (unsigned i = 0; i < Keys.Size(); i++) order.Push(i);
+	std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return Keys[a] < Keys[b]; });
+
+	TArray<unsigned int> remap(Keys.Size(), true);
+	remap.Resize(Keys.Size());
+
+	float PivotX = mip->Pivot.X;
+	float PivotY = mip->Pivot.Y;
+	float PivotZ = mip->Pivot.Z;
+	unsigned latticeX = 2 * mip->SizeX + 1;
+	unsigned latticeY = 2 * mip->SizeY + 1;
+
+	for (unsigned i = 0; i < order.Size(); i++)
+	{
+		uint64_t key = Keys[order[i]];
+		if (i == 0 || key != Keys[order[i - 1]])
+		{
+			uint8_t col = uint8_t(key);
+			uint64_t pos = key >> 8;
+			int x = int(pos % latticeX);
+			int y = int((pos / latticeX) % latticeY);
+			int z = int(pos / latticeX / latticeY);
+
+			FModelVertex vert;
+			vert.packedNormal = 0;	// currently this is not being used for voxels.
+			vert.u = (((col & 15) + 0.5f) / 16.f);
+			vert.v = (((col / 16) + 0.5f) / 16.f);
+			vert.x =  x * 0.5f - PivotX;
+			vert.z = -y * 0.5f + PivotY;
+			vert.y = -z * 0.5f + PivotZ;
+			mVertices.Push(vert);
+		}
+		remap[order[i]] = mVertices.Size() - 1;
+	}
+
+	for (auto &index : mIndices)
+	{
+		index = remap[index];
+	}
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelGreedyMesher::MakeMesh()
+{
+	CollectFaces();
+
+	// The mask must hold any slice: u is x or y, v is y or z.
+	MaskWidth = max(mip->SizeX, mip->SizeY);
+	MaskHeight = max(mip->SizeY, SizeZ);
+	Mask.Resize(MaskWidth * MaskHeight);
+	memset(Mask.Data(), 0, Mask.Size() * sizeof(uint16_t));
+
+	for (int dir = 0; dir < NumFaces; dir++)
+	{
+		MergeFaces(dir);
+	}
+
+	BuildLines();
+	for (auto &quad : Quads)
+	{
+		AddQuad(quad);
+	}
+	Finish();
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelModel::MakeMesh(FVoxel *voxel, bool greedy, TArray<FModelVertex> &vertices, TArray<unsigned int> &indices)
+{
+	if (greedy)
+	{
+		FVoxelGreedyMesher mesher(&voxel->Mips[0], vertices, indices);
+		mesher.MakeMesh();
+	}
+	else
+	{
+		FVoxelSlabMesher mesher(&voxel->Mips[0], vertices, indices);
+		mesher.MakeMesh();
+	}
+}
+
+//===========================================================================
+//
+// 
+//
+//===========================================================================
+
+void FVoxelModel::Initialize()
+{
+	mVertices.Clear();
+	mIndices.Clear();
+	MakeMesh(mVoxel, gl_voxel_greedymesh, mVertices, mIndices);
+	mMeshBuilt = true;
+}
+
+void FVoxelModel::BuildMesh()
+{
+	if (!mMeshBuilt) Initialize();
+}
+
+//===========================================================================
+//
+// Compares the two meshers on all loaded voxels
+//
+//===========================================================================
+
+CCMD(voxelmeshbench)
+{
+	unsigned numTris[2] = {}, numVerts[2] = {};
+	double time[2] = {};
+
+	for (int greedy = 0; greedy < 2; greedy++)
+	{
+		cycle_t timer;
+		timer.Reset();
+		for (auto voxel : Voxels)
+		{
+			TArray<FModelVertex> vertices;
+			TArray<unsigned int> indices;
+			timer.Clock();
+			FVoxelModel::MakeMesh(voxel, !!greedy, vertices, indices);
+			timer.Unclock();
+			numTris[greedy] += indices.Size() / 3;
+			numVerts[greedy] += vertices.Size();
 		}
+		time[greedy] = timer.TimeMS();
 	}
+	Printf("%u voxels\n", Voxels.Size());
+	Printf("Slab mesher:   %u triangles, %u vertices, %.3f ms\n", numTris[0], numVerts[0], time[0]);
+	Printf("Greedy mesher: %u triangles, %u vertices, %.3f ms\n", numTris[1], numVerts[1], time[1]);
 }
 
 //===========================================================================
@@ -326,7 +841,7 @@ void FVoxelModel::BuildVertexBuffer(FModelRenderer *renderer)
 {
 	if (!GetVertexBuffer(renderer->GetType()))
 	{
-		Initialize();
+		BuildMesh();
 
 		auto vbuf = renderer->CreateVertexBuffer(true, true);
 		SetVertexBuffer(renderer->GetType(), vbuf);
@@ -346,6 +861,7 @@ void FVoxelModel::BuildVertexBuffer(FModelRenderer *renderer)
 		mIndices.Clear();
 		mVertices.ShrinkToFit();
 		mIndices.ShrinkToFit();
+		mMeshBuilt = false;
 	}
 }
 
@@ -22,6 +22,17 @@ struct LevelSubmeshDrawRange
 	int Count;
 };
 
+// Location of one baked tile in the lightmap atlas and where its pixels start in LMTilePixels
+struct LightmapTileUpload
+{
+	int X;
+	int Y;
+	int Width;
+	int Height;
+	int ArrayIndex;
+	uint32_t PixelsOffset;
+};
+
 class LevelSubmesh
 {
 public:
@@ -50,7 +61,10 @@ public:
 	// Lightmap atlas
 	int LMTextureCount = 0;
 	int LMTextureSize = 1024;
-	TArray<uint16_t> LMTextureData;
+
+	// Baked lightmap pixels (RGB half floats), stored tile by tile rather than as a full atlas
+	TArray<LightmapTileUpload> LMBakedTiles;
+	TArray<uint16_t> LMTilePixels;
 
 	uint16_t LightmapSampleDistance = 16;
 
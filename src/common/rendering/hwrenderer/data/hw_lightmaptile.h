@@ -19,6 +19,11 @@ struct LightmapTileBinding
 		if (ControlSector != other.ControlSector) return ControlSector < other.ControlSector;
 		return Type < other.Type;
 	}
+
+	bool operator==(const LightmapTileBinding& other) const
+	{
+		return TypeIndex == other.TypeIndex && ControlSector == other.ControlSector && Type == other.Type;
+	}
 };
 
 struct LightmapTile
@@ -180,6 +180,7 @@ public:
 	virtual void SetTextureFilterMode() {}
 	virtual IHardwareTexture *CreateHardwareTexture(int numchannels) { return nullptr; }
 	virtual void PrecacheMaterial(FMaterial *mat, int translation) {}
+	virtual void PrecacheMaterials(const TArray<std::pair<FMaterial*, int>> &materials) { for (auto &m : materials) PrecacheMaterial(m.first, m.second); }
 	virtual FMaterial* CreateMaterial(FGameTexture* tex, int scaleflags);
 	virtual void BeginFrame() {}
 	virtual void SetWindowSize(int w, int h) {}
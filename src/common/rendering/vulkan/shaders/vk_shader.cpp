@@ -22,6 +22,7 @@
 
 #include "vk_shader.h"
 #include "vk_ppshader.h"
+#include "vk_shadercache.h"
 #include "vulkan/vk_renderdevice.h"
 #include <zvulkan/vulkanbuilders.h>
 #include "hw_shaderpatcher.h"
@@ -29,27 +30,351 @@
 #include "engineerrors.h"
 #include "version.h"
 #include "cmdlib.h"
+#include "i_specialpaths.h"
+#include "workerpool.h"
+#include "md5.h"
+#include <future>
+#include <deque>
+#include <mutex>
+
+struct VkShaderSource
+{
+	ShaderType Type = ShaderType::Vertex;
+	FString Name;
+	std::vector<std::pair<std::string, std::string>> Sources;
+
+	void AddSource(const char* name, const FString& code) { Sources.push_back({ name, code.GetChars() }); }
+};
+
+struct VkShaderCompileResult
+{
+	bool Succeeded = false;
+	std::vector<VkShaderCacheInclude> Includes;
+	std::vector<uint32_t> Code;
+};
+
+typedef std::function<bool(const FString& name, bool system, FString& text)> VkShaderIncludeLoader;
+
+struct VkShaderPrewarmJob
+{
+	std::function<VkShaderCompileResult()> Compile;
+	std::promise<VkShaderCompileResult> Promise;
+	std::future<VkShaderCompileResult> Result;
+	bool Started = false;
+};
+
+// Shader variants being compiled on the shared worker pool ahead of their first use.
+// Only a few run at a time so that they do not hold up other work queued on the pool.
+struct VkShaderPrewarm
+{
+	std::mutex Mutex;
+	std::deque<std::shared_ptr<VkShaderPrewarmJob>> Queue;
+	int Running = 0;
+	bool Cancelled = false;
+
+	// Only accessed by the main thread
+	std::map<VkShaderCacheKey, std::shared_ptr<VkShaderPrewarmJob>> Jobs;
+	std::set<int> EffectStates;
+};
+
+// Must be called with the prewarm mutex locked
+static void RunPrewarmJobs(const std::shared_ptr<VkShaderPrewarm>& prewarm)
+{
+	int maxRunning = std::max(WorkerPoolSize() / 2, 1);
+	while (!prewarm->Cancelled && prewarm->Running < maxRunning && !prewarm->Queue.empty())
+	{
+		auto job = std::move(prewarm->Queue.front());
+		prewarm->Queue.pop_front();
+		if (job->Started)
+			continue; // CreateShader took it over
+
+		job->Started = true;
+		prewarm->Running++;
+		WorkerPool().push([prewarm, job](int id)
+		{
+			job->Promise.set_value(job->Compile());
+
+			std::lock_guard<std::mutex> lock(prewarm->Mutex);
+			prewarm->Running--;
+			RunPrewarmJobs(prewarm);
+		});
+	}
+}
 
 VkShaderManager::VkShaderManager(VulkanRenderDevice* fb) : fb(fb)
 {
+	FString path = M_GetCachePath(true);
+	CreatePath(path.GetChars());
+	ShaderCache = std::make_unique<VkShaderCache>(path + "/shadercache.zdsc");
+	Prewarm = std::make_shared<VkShaderPrewarm>();
 }
 
 VkShaderManager::~VkShaderManager()
 {
+	// Jobs already running keep the prewarm state alive until they are done
+	std::lock_guard<std::mutex> lock(Prewarm->Mutex);
+	Prewarm->Cancelled = true;
+	Prewarm->Queue.clear();
 }
 
 void VkShaderManager::Deinit()
 {
 	while (!PPShaders.empty())
 		RemoveVkPPShader(PPShaders.back());
+
+	ShaderCache->Save();
+}
+
+static VkShaderCacheKey GetCacheKey(const VkShaderSource& source, uint32_t apiVersion)
+{
+	MD5Context md5;
+	uint32_t header[2] = { apiVersion, (uint32_t)source.Type };
+	md5.Update((const uint8_t*)header, sizeof(header));
+	for (const auto& s : source.Sources)
+	{
+		uint32_t lengths[2] = { (uint32_t)s.first.size(), (uint32_t)s.second.size() };
+		md5.Update((const uint8_t*)lengths, sizeof(lengths));
+		md5.Update((const uint8_t*)s.first.data(), (unsigned)s.first.size());
+		md5.Update((const uint8_t*)s.second.data(), (unsigned)s.second.size());
+	}
+
+	VkShaderCacheKey key;
+	md5.Final(key.Hash);
+	return key;
+}
+
+// Compiles the source to SPIR-V. Only touches the include loader passed in, so this can run on a worker thread.
+static VkShaderCompileResult CompileShader(const VkShaderSource& source, uint32_t apiVersion, const VkShaderIncludeLoader& loadInclude)
+{
+	VkShaderCompileResult result;
+
+	auto onInclude = [&](std::string headerName, size_t depth, bool system)
+	{
+		if (depth > 8)
+			return ShaderIncludeResult("Too much include recursion!");
+
+		VkShaderCacheInclude include;
+		include.Name = headerName.c_str();
+		include.System = system;
+
+		FString text;
+		if (!loadInclude(include.Name, system, text))
+			return ShaderIncludeResult(FStringf("Unable to load '%s'", headerName.c_str()).GetChars());
+
+		VkShaderCache::HashText(text, include.Hash);
+		result.Includes.push_back(std::move(include));
+
+		FString includeguardname;
+		includeguardname << "_HEADERGUARD_" << headerName.c_str();
+		includeguardname.ReplaceChars("/\\.", '_');
+
+		FString code;
+		code << "#ifndef " << includeguardname.GetChars() << "\n";
+		code << "#define " << includeguardname.GetChars() << "\n";
+		code << "#line 1\n";
+		code << text.GetChars() << "\n";
+		code << "#endif\n";
+
+		return ShaderIncludeResult(headerName, code.GetChars());
+	};
+
+	ShaderBuilder builder;
+	builder.Type(source.Type);
+	for (const auto& s : source.Sources)
+		builder.AddSource(s.first, s.second);
+	builder.OnIncludeLocal([&](std::string headerName, std::string includerName, size_t depth) { return onInclude(headerName, depth, false); });
+	builder.OnIncludeSystem([&](std::string headerName, std::string includerName, size_t depth) { return onInclude(headerName, depth, true); });
+
+	result.Code = builder.CreateSpirv(apiVersion);
+	result.Succeeded = true;
+	return result;
+}
+
+bool VkShaderManager::LoadShaderInclude(const FString& name, bool system, FString& text)
+{
+	int lump = fileSystem.CheckNumForFullName(name.GetChars(), 0);
+	if (lump == -1 && !system) lump = fileSystem.CheckNumForFullName(name.GetChars());
+	if (lump == -1) return false;
+	text = GetStringFromLump(lump);
+	return true;
+}
+
+std::unique_ptr<VulkanShader> VkShaderManager::CreateShader(const VkShaderSource& source)
+{
+	VkShaderIncludeLoader loadInclude = [this](const FString& name, bool system, FString& text) { return LoadShaderInclude(name, system, text); };
+	uint32_t apiVersion = fb->GetDevice()->Instance->ApiVersion;
+
+	VkShaderCacheKey key = GetCacheKey(source, apiVersion);
+	std::vector<uint32_t> code = ShaderCache->Find(key, loadInclude);
+	if (code.empty())
+	{
+		VkShaderCompileResult result;
+
+		auto it = Prewarm->Jobs.find(key);
+		if (it != Prewarm->Jobs.end())
+		{
+			auto job = it->second;
+			Prewarm->Jobs.erase(it);
+
+			// If the job has not started yet it is faster to compile it right here than to wait for its turn
+			bool started;
+			{
+				std::lock_guard<std::mutex> lock(Prewarm->Mutex);
+				started = job->Started;
+				job->Started = true;
+			}
+			if (started)
+				result = job->Result.get();
+		}
+
+		if (!result.Succeeded)
+			result = CompileShader(source, apiVersion, loadInclude);
+
+		code = result.Code;
+		ShaderCache->Add(key, std::move(result.Includes), std::move(result.Code));
+	}
+
+	return ShaderBuilder()
+		.Type(source.Type)
+		.DebugName(source.Name.GetChars())
+		.Spirv(std::move(code))
+		.Create(source.Name.GetChars(), fb->GetDevice());
+}
+
+// Finds the files a source includes, so that a worker thread can compile it without accessing the file system.
+void VkShaderManager::CollectIncludes(const FString& text, std::map<std::pair<FString, bool>, FString>& includes)
+{
+	const char* pos = text.GetChars();
+	while ((pos = strstr(pos, "#include")) != nullptr)
+	{
+		pos += 8;
+		while (*pos == ' ' || *pos == '\t') pos++;
+
+		char terminator;
+		if (*pos == '"') terminator = '"';
+		else if (*pos == '<') terminator = '>';
+		else continue;
+
+		const char* end = strchr(pos + 1, terminator);
+		if (!end) break;
+
+		FString name(pos + 1, end - pos - 1);
+		bool system = terminator == '>';
+		pos = end + 1;
+
+		auto key = std::make_pair(name, system);
+		if (includes.find(key) != includes.end())
+			continue;
+
+		FString code;
+		if (LoadShaderInclude(name, system, code))
+		{
+			includes[key] = code;
+			CollectIncludes(code, includes);
+		}
+	}
+}
+
+void VkShaderManager::PrewarmShader(const VkShaderSource& source)
+{
+	uint32_t apiVersion = fb->GetDevice()->Instance->ApiVersion;
+	VkShaderCacheKey key = GetCacheKey(source, apiVersion);
+	if (ShaderCache->Contains(key) || Prewarm->Jobs.find(key) != Prewarm->Jobs.end())
+		return;
+
+	auto includes = std::make_shared<std::map<std::pair<FString, bool>, FString>>();
+	for (const auto& s : source.Sources)
+		CollectIncludes(s.second.c_str(), *includes);
+
+	auto job = std::make_shared<VkShaderPrewarmJob>();
+	job->Result = job->Promise.get_future();
+	job->Compile = [=]()
+	{
+		VkShaderIncludeLoader loadInclude = [=](const FString& name, bool system, FString& text)
+		{
+			auto it = includes->find(std::make_pair(name, system));
+			if (it == includes->end())
+				return false;
+			text = it->second;
+			return true;
+		};
+
+		try
+		{
+			return CompileShader(source, apiVersion, loadInclude);
+		}
+		catch (...)
+		{
+			// Leave it to Get to compile it again and report the error
+			return VkShaderCompileResult();
+		}
+	};
+	Prewarm->Jobs[key] = job;
+
+	std::lock_guard<std::mutex> lock(Prewarm->Mutex);
+	Prewarm->Queue.push_back(job);
+	RunPrewarmJobs(Prewarm);
+}
+
+void VkShaderManager::PrecacheEffectState(int effectState)
+{
+	if (!Prewarm->EffectStates.insert(effectState).second)
+		return;
+
+	if (effectState >= FIRST_USER_SHADER && (unsigned)(effectState - FIRST_USER_SHADER) >= usershaders.Size())
+		return;
+
+	// Guess which variants will be needed from the render states previous sessions used
+	std::set<VkShaderKey> keys;
+	for (const auto& cached : ShaderCache->GetVariants())
+	{
+		const VkShaderKey& variant = cached.first;
+		if (variant.SpecialEffect != EFF_NONE)
+			continue;
+
+		VkShaderKey key = variant;
+		key.EffectState = effectState;
+		auto it = programs.find(key);
+		if (it == programs.end() || !it->second.vert)
+			keys.insert(key);
+	}
+
+	for (const VkShaderKey& key : keys)
+	{
+		try
+		{
+			VkShaderSource vertsource, fragsource;
+			GetProgramSources(key, vertsource, fragsource);
+			PrewarmShader(vertsource);
+			if (!key.NoFragmentShader)
+				PrewarmShader(fragsource);
+		}
+		catch (const CRecoverableError&)
+		{
+			// Broken shaders are reported when they are used
+		}
+	}
 }
 
 VkShaderProgram* VkShaderManager::Get(const VkShaderKey& key)
 {
 	auto& program = programs[key];
-	if (program.frag)
+	if (program.vert)
 		return &program;
 
+	VkShaderSource vertsource, fragsource;
+	GetProgramSources(key, vertsource, fragsource);
+
+	program.vert = CreateShader(vertsource);
+	if (!key.NoFragmentShader)
+		program.frag = CreateShader(fragsource);
+
+	ShaderCache->AddVariant(key);
+	return &program;
+}
+
+void VkShaderManager::GetProgramSources(const VkShaderKey& key, VkShaderSource& vertsource, VkShaderSource& fragsource)
+{
 	const char* mainvp = "shaders/scene/vert_main.glsl";
 	const char* mainfp = "shaders/scene/frag_main.glsl";
 
@@ -75,9 +400,9 @@ VkShaderProgram* VkShaderManager::Get(const VkShaderKey& key)
 		};
 
 		const auto& desc = effectshaders[key.SpecialEffect];
-		program.vert = LoadVertShader(desc.ShaderName, mainvp, desc.defines, key.UseLevelMesh);
+		vertsource = GetVertShaderSource(desc.ShaderName, mainvp, desc.defines, key.UseLevelMesh);
 		if (!key.NoFragmentShader)
-			program.frag = LoadFragShader(desc.ShaderName, desc.fp1, desc.fp2, desc.fp3, desc.fp4, desc.defines, key);
+			fragsource = GetFragShaderSource(desc.ShaderName, desc.fp1, desc.fp2, desc.fp3, desc.fp4, desc.defines, key);
 	}
 	else
 	{
@@ -114,9 +439,9 @@ VkShaderProgram* VkShaderManager::Get(const VkShaderKey& key)
 		if (key.EffectState < FIRST_USER_SHADER)
 		{
 			const auto& desc = defaultshaders[key.EffectState];
-			program.vert = LoadVertShader(desc.ShaderName, mainvp, desc.Defines, key.UseLevelMesh);
+			vertsource = GetVertShaderSource(desc.ShaderName, mainvp, desc.Defines, key.UseLevelMesh);
 			if (!key.NoFragmentShader)
-				program.frag = LoadFragShader(desc.ShaderName, mainfp, desc.material_lump, desc.mateffect_lump, desc.lightmodel_lump, desc.Defines, key);
+				fragsource = GetFragShaderSource(desc.ShaderName, mainfp, desc.material_lump, desc.mateffect_lump, desc.lightmodel_lump, desc.Defines, key);
 		}
 		else
 		{
@@ -124,15 +449,14 @@ VkShaderProgram* VkShaderManager::Get(const VkShaderKey& key)
 			const FString& name = ExtractFileBase(desc.shader.GetChars());
 			FString defines = defaultshaders[desc.shaderType].Defines + desc.defines;
 
-			program.vert = LoadVertShader(name, mainvp, defines.GetChars(), key.UseLevelMesh);
+			vertsource = GetVertShaderSource(name, mainvp, defines.GetChars(), key.UseLevelMesh);
 			if (!key.NoFragmentShader)
-				program.frag = LoadFragShader(name, mainfp, desc.shader.GetChars(), defaultshaders[desc.shaderType].mateffect_lump, defaultshaders[desc.shaderType].lightmodel_lump, defines.GetChars(), key);
+				fragsource = GetFragShaderSource(name, mainfp, desc.shader.GetChars(), defaultshaders[desc.shaderType].mateffect_lump, defaultshaders[desc.shaderType].lightmodel_lump, defines.GetChars(), key);
 		}
 	}
-	return &program;
 }
 
-std::unique_ptr<VulkanShader> VkShaderManager::LoadVertShader(FString shadername, const char *vert_lump, const char *defines, bool levelmesh)
+VkShaderSource VkShaderManager::GetVertShaderSource(FString shadername, const char *vert_lump, const char *defines, bool levelmesh)
 {
 	FString definesBlock;
 	definesBlock << defines;
@@ -157,19 +481,17 @@ std::unique_ptr<VulkanShader> VkShaderManager::LoadVertShader(FString shadername
 	FString codeBlock;
 	codeBlock << LoadPrivateShaderLump(vert_lump).GetChars() << "\n";
 
-	return ShaderBuilder()
-		.Type(ShaderType::Vertex)
-		.DebugName(shadername.GetChars())
-		.AddSource("VersionBlock", GetVersionBlock().GetChars())
-		.AddSource("DefinesBlock", definesBlock.GetChars())
-		.AddSource("LayoutBlock", layoutBlock.GetChars())
-		.AddSource(vert_lump, codeBlock.GetChars())
-		.OnIncludeLocal([=](std::string headerName, std::string includerName, size_t depth) { return OnInclude(headerName.c_str(), includerName.c_str(), depth, false); })
-		.OnIncludeSystem([=](std::string headerName, std::string includerName, size_t depth) { return OnInclude(headerName.c_str(), includerName.c_str(), depth, true); })
-		.Create(shadername.GetChars(), fb->GetDevice());
+	VkShaderSource source;
+	source.Type = ShaderType::Vertex;
+	source.Name = shadername;
+	source.AddSource("VersionBlock", GetVersionBlock());
+	source.AddSource("DefinesBlock", definesBlock);
+	source.AddSource("LayoutBlock", layoutBlock);
+	source.AddSource(vert_lump, codeBlock);
+	return source;
 }
 
-std::unique_ptr<VulkanShader> VkShaderManager::LoadFragShader(FString shadername, const char *frag_lump, const char *material_lump, const char* mateffect_lump, const char *light_lump, const char *defines, const VkShaderKey& key)
+VkShaderSource VkShaderManager::GetFragShaderSource(FString shadername, const char *frag_lump, const char *material_lump, const char* mateffect_lump, const char *light_lump, const char *defines, const VkShaderKey& key)
 {
 	FString definesBlock;
 	if (fb->GetDevice()->SupportsExtension(VK_KHR_RAY_QUERY_EXTENSION_NAME) && fb->GetDevice()->PhysicalDevice.Features.RayQuery.rayQuery) definesBlock << "\n#define SUPPORTS_RAYQUERY\n";
@@ -295,20 +617,18 @@ std::unique_ptr<VulkanShader> VkShaderManager::LoadFragShader(FString shadername
 		mateffectBlock << LoadPrivateShaderLump(mateffect_lump).GetChars();
 	}
 
-	return ShaderBuilder()
-		.Type(ShaderType::Fragment)
-		.DebugName(shadername.GetChars())
-		.AddSource("VersionBlock", GetVersionBlock().GetChars())
-		.AddSource("DefinesBlock", definesBlock.GetChars())
-		.AddSource("LayoutBlock", layoutBlock.GetChars())
-		.AddSource("shaders/scene/includes.glsl", LoadPrivateShaderLump("shaders/scene/includes.glsl").GetChars())
-		.AddSource(mateffectname.GetChars(), mateffectBlock.GetChars())
-		.AddSource(materialname.GetChars(), materialBlock.GetChars())
-		.AddSource(lightname.GetChars(), lightBlock.GetChars())
-		.AddSource(frag_lump, codeBlock.GetChars())
-		.OnIncludeLocal([=](std::string headerName, std::string includerName, size_t depth) { return OnInclude(headerName.c_str(), includerName.c_str(), depth, false); })
-		.OnIncludeSystem([=](std::string headerName, std::string includerName, size_t depth) { return OnInclude(headerName.c_str(), includerName.c_str(), depth, true); })
-		.Create(shadername.GetChars(), fb->GetDevice());
+	VkShaderSource source;
+	source.Type = ShaderType::Fragment;
+	source.Name = shadername;
+	source.AddSource("VersionBlock", GetVersionBlock());
+	source.AddSource("DefinesBlock", definesBlock);
+	source.AddSource("LayoutBlock", layoutBlock);
+	source.AddSource("shaders/scene/includes.glsl", LoadPrivateShaderLump("shaders/scene/includes.glsl"));
+	source.AddSource(mateffectname.GetChars(), mateffectBlock);
+	source.AddSource(materialname.GetChars(), materialBlock);
+	source.AddSource(lightname.GetChars(), lightBlock);
+	source.AddSource(frag_lump, codeBlock);
+	return source;
 }
 
 FString VkShaderManager::GetVersionBlock()
@@ -335,30 +655,6 @@ FString VkShaderManager::GetVersionBlock()
 	return versionBlock;
 }
 
-ShaderIncludeResult VkShaderManager::OnInclude(FString headerName, FString includerName, size_t depth, bool system)
-{
-	if (depth > 8)
-		I_Error("Too much include recursion!");
-
-	FString includeguardname;
-	includeguardname << "_HEADERGUARD_" << headerName.GetChars();
-	includeguardname.ReplaceChars("/\\.", '_');
-
-	FString code;
-	code << "#ifndef " << includeguardname.GetChars() << "\n";
-	code << "#define " << includeguardname.GetChars() << "\n";
-	code << "#line 1\n";
-
-	if (system)
-		code << LoadPrivateShaderLump(headerName.GetChars()).GetChars() << "\n";
-	else
-		code << LoadPublicShaderLump(headerName.GetChars()).GetChars() << "\n";
-
-	code << "#endif\n";
-
-	return ShaderIncludeResult(headerName.GetChars(), code.GetChars());
-}
-
 FString VkShaderManager::LoadPublicShaderLump(const char *lumpname)
 {
 	int lump = fileSystem.CheckNumForFullName(lumpname, 0);
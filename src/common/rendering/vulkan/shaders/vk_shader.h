@@ -18,6 +18,9 @@ class VulkanDevice;
 class VulkanShader;
 class VkPPShader;
 class PPShader;
+class VkShaderCache;
+struct VkShaderSource;
+struct VkShaderPrewarm;
 
 struct MatricesUBO
 {
@@ -89,6 +92,16 @@ public:
 	int SpecialEffect = 0;
 	int EffectState = 0;
 
+	// Rejects flag combinations the renderer never builds, for keys read back from the shader cache
+	bool IsValid() const
+	{
+		if (Unused != 0 || (FogBeforeLights && FogAfterLights) || (FogRadial && !FogBeforeLights && !FogAfterLights) || (UseShadowmap && UseRaytrace))
+			return false;
+		if (SpecialEffect < EFF_NONE || SpecialEffect >= MAX_EFFECTS || EffectState < 0)
+			return false;
+		return SpecialEffect == EFF_NONE || EffectState == 0;
+	}
+
 	bool operator<(const VkShaderKey& other) const { return memcmp(this, &other, sizeof(VkShaderKey)) < 0; }
 	bool operator==(const VkShaderKey& other) const { return memcmp(this, &other, sizeof(VkShaderKey)) == 0; }
 	bool operator!=(const VkShaderKey& other) const { return memcmp(this, &other, sizeof(VkShaderKey)) != 0; }
@@ -115,16 +128,23 @@ public:
 
 	bool CompileNextShader() { return true; }
 
+	// Starts compiling the variants of a material shader the level is likely to use on worker threads
+	void PrecacheEffectState(int effectState);
+
 	VkPPShader* GetVkShader(PPShader* shader);
 
 	void AddVkPPShader(VkPPShader* shader);
 	void RemoveVkPPShader(VkPPShader* shader);
 
 private:
-	std::unique_ptr<VulkanShader> LoadVertShader(FString shadername, const char *vert_lump, const char *defines, bool levelmesh);
-	std::unique_ptr<VulkanShader> LoadFragShader(FString shadername, const char *frag_lump, const char *material_lump, const char* mateffect_lump, const char *lightmodel_lump, const char *defines, const VkShaderKey& key);
+	void GetProgramSources(const VkShaderKey& key, VkShaderSource& vertsource, VkShaderSource& fragsource);
+	VkShaderSource GetVertShaderSource(FString shadername, const char *vert_lump, const char *defines, bool levelmesh);
+	VkShaderSource GetFragShaderSource(FString shadername, const char *frag_lump, const char *material_lump, const char* mateffect_lump, const char *lightmodel_lump, const char *defines, const VkShaderKey& key);
 
-	ShaderIncludeResult OnInclude(FString headerName, FString includerName, size_t depth, bool system);
+	std::unique_ptr<VulkanShader> CreateShader(const VkShaderSource& source);
+	void PrewarmShader(const VkShaderSource& source);
+	void CollectIncludes(const FString& text, std::map<std::pair<FString, bool>, FString>& includes);
+	bool LoadShaderInclude(const FString& name, bool system, FString& text);
 
 	FString GetVersionBlock();
 	FString LoadPublicShaderLump(const char *lumpname);
@@ -134,5 +154,8 @@ private:
 
 	std::map<VkShaderKey, VkShaderProgram> programs;
 
+	std::unique_ptr<VkShaderCache> ShaderCache;
+	std::shared_ptr<VkShaderPrewarm> Prewarm;
+
 	std::list<VkPPShader*> PPShaders;
 };
@@ -0,0 +1,273 @@
+/*
+**  Vulkan backend
+**  Copyright (c) 2016-2020 Magnus Norddahl
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#include "vk_shadercache.h"
+#include "files.h"
+#include "md5.h"
+#include <algorithm>
+
+static const uint32_t ShaderCacheMagic = 0x4353445a; // "ZDSC"
+static const uint32_t ShaderCacheVersion = 2;
+
+static const uint32_t MaxUnusedSessions = 10;
+static const size_t MaxEntries = 4096;
+static const size_t MaxVariants = 1024;
+
+VkShaderCache::VkShaderCache(FString filename) : Filename(filename)
+{
+	try
+	{
+		Load();
+	}
+	catch (...)
+	{
+		Entries.clear();
+		Variants.clear();
+	}
+}
+
+VkShaderCache::~VkShaderCache()
+{
+	try
+	{
+		Save();
+	}
+	catch (...)
+	{
+	}
+}
+
+void VkShaderCache::HashText(const FString& text, uint8_t hash[16])
+{
+	MD5Context md5;
+	md5.Update((const uint8_t*)text.GetChars(), (unsigned)text.Len());
+	md5.Final(hash);
+}
+
+std::vector<uint32_t> VkShaderCache::Find(const VkShaderCacheKey& key, const std::function<bool(const FString& name, bool system, FString& text)>& loadInclude)
+{
+	auto it = Entries.find(key);
+	if (it == Entries.end())
+		return {};
+	it->second.Used = true;
+
+	for (const VkShaderCacheInclude& include : it->second.Includes)
+	{
+		FString text;
+		uint8_t hash[16];
+		if (!loadInclude(include.Name, include.System, text))
+			return {};
+		HashText(text, hash);
+		if (memcmp(hash, include.Hash, sizeof(hash)) != 0)
+			return {};
+	}
+
+	return it->second.Code;
+}
+
+void VkShaderCache::Add(const VkShaderCacheKey& key, std::vector<VkShaderCacheInclude> includes, std::vector<uint32_t> code)
+{
+	Entry& entry = Entries[key];
+	entry.Includes = std::move(includes);
+	entry.Code = std::move(code);
+	entry.Used = true;
+	Modified = true;
+}
+
+void VkShaderCache::AddVariant(const VkShaderKey& key)
+{
+	auto result = Variants.insert({ key, Usage() });
+	result.first->second.Used = true;
+	if (result.second)
+		Modified = true;
+}
+
+void VkShaderCache::Load()
+{
+	FileReader fr;
+	if (!fr.OpenFile(Filename.GetChars()))
+		return;
+
+	std::vector<uint8_t> data(fr.GetLength());
+	if (fr.Read(data.data(), data.size()) != (FileReader::Size)data.size())
+		return;
+
+	size_t pos = 0;
+	auto read = [&](void* dest, size_t size)
+	{
+		if (data.size() - pos < size)
+			throw std::runtime_error("Shader cache file is truncated");
+		memcpy(dest, data.data() + pos, size);
+		pos += size;
+	};
+	auto readUInt32 = [&]()
+	{
+		uint32_t value;
+		read(&value, sizeof(uint32_t));
+		return value;
+	};
+
+	// The variants are stored as raw VkShaderKey data, so a cache written with a different layout is useless
+	if (readUInt32() != ShaderCacheMagic || readUInt32() != ShaderCacheVersion || readUInt32() != sizeof(VkShaderKey))
+		return;
+
+	uint32_t numVariants = readUInt32();
+	for (uint32_t i = 0; i < numVariants; i++)
+	{
+		VkShaderKey key;
+		Usage usage;
+		read(&key, sizeof(VkShaderKey));
+		read(&usage.Age, sizeof(uint32_t));
+		if (key.IsValid())
+			Variants[key] = usage;
+	}
+
+	uint32_t numEntries = readUInt32();
+	for (uint32_t i = 0; i < numEntries; i++)
+	{
+		VkShaderCacheKey key;
+		read(key.Hash, sizeof(key.Hash));
+
+		Entry entry;
+		read(&entry.Age, sizeof(uint32_t));
+		entry.Includes.resize(readUInt32());
+		for (VkShaderCacheInclude& include : entry.Includes)
+		{
+			uint32_t len = readUInt32();
+			if (data.size() - pos < len)
+				throw std::runtime_error("Shader cache file is truncated");
+			include.Name = FString((const char*)data.data() + pos, len);
+			pos += len;
+			uint8_t system;
+			read(&system, 1);
+			include.System = system != 0;
+			read(include.Hash, sizeof(include.Hash));
+		}
+
+		uint32_t codesize = readUInt32();
+		if ((data.size() - pos) / sizeof(uint32_t) < codesize)
+			throw std::runtime_error("Shader cache file is truncated");
+		entry.Code.resize(codesize);
+		read(entry.Code.data(), codesize * sizeof(uint32_t));
+
+		Entries[key] = std::move(entry);
+	}
+}
+
+// Drops whatever went unused for too long, then the least recently used ones until the maps fit their limits
+template<typename Key, typename Value>
+static void PruneMap(std::map<Key, Value>& map, size_t maxCount)
+{
+	for (auto it = map.begin(); it != map.end();)
+	{
+		if (it->second.SavedAge() > MaxUnusedSessions)
+			it = map.erase(it);
+		else
+			++it;
+	}
+
+	if (map.size() <= maxCount)
+		return;
+
+	std::vector<uint32_t> ages;
+	ages.reserve(map.size());
+	for (const auto& it : map)
+		ages.push_back(it.second.SavedAge());
+	std::nth_element(ages.begin(), ages.begin() + (maxCount - 1), ages.end());
+	uint32_t maxAge = ages[maxCount - 1];
+
+	size_t keepAtMaxAge = maxCount - std::count_if(ages.begin(), ages.end(), [=](uint32_t age) { return age < maxAge; });
+	for (auto it = map.begin(); it != map.end();)
+	{
+		uint32_t age = it->second.SavedAge();
+		if (age > maxAge || (age == maxAge && keepAtMaxAge == 0))
+		{
+			it = map.erase(it);
+		}
+		else
+		{
+			if (age == maxAge)
+				keepAtMaxAge--;
+			++it;
+		}
+	}
+}
+
+void VkShaderCache::Prune()
+{
+	PruneMap(Entries, MaxEntries);
+	PruneMap(Variants, MaxVariants);
+}
+
+void VkShaderCache::Save()
+{
+	if (!Modified)
+		return;
+
+	Prune();
+
+	std::vector<uint8_t> data;
+	auto write = [&](const void* src, size_t size)
+	{
+		data.insert(data.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+	};
+	auto writeUInt32 = [&](uint32_t value)
+	{
+		write(&value, sizeof(uint32_t));
+	};
+
+	writeUInt32(ShaderCacheMagic);
+	writeUInt32(ShaderCacheVersion);
+	writeUInt32(sizeof(VkShaderKey));
+
+	writeUInt32((uint32_t)Variants.size());
+	for (const auto& it : Variants)
+	{
+		write(&it.first, sizeof(VkShaderKey));
+		writeUInt32(it.second.SavedAge());
+	}
+
+	writeUInt32((uint32_t)Entries.size());
+	for (const auto& it : Entries)
+	{
+		write(it.first.Hash, sizeof(it.first.Hash));
+		writeUInt32(it.second.SavedAge());
+		writeUInt32((uint32_t)it.second.Includes.size());
+		for (const VkShaderCacheInclude& include : it.second.Includes)
+		{
+			writeUInt32((uint32_t)include.Name.Len());
+			write(include.Name.GetChars(), include.Name.Len());
+			uint8_t system = include.System ? 1 : 0;
+			write(&system, 1);
+			write(include.Hash, sizeof(include.Hash));
+		}
+		writeUInt32((uint32_t)it.second.Code.size());
+		write(it.second.Code.data(), it.second.Code.size() * sizeof(uint32_t));
+	}
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(Filename.GetChars()));
+	if (fw)
+	{
+		fw->Write(data.data(), data.size());
+		Modified = false;
+	}
+}
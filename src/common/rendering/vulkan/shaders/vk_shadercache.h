@@ -0,0 +1,94 @@
+/*
+**  Vulkan backend
+**  Copyright (c) 2016-2020 Magnus Norddahl
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include "zstring.h"
+#include "vk_shader.h"
+#include <vector>
+#include <map>
+#include <functional>
+#include <cstring>
+
+struct VkShaderCacheKey
+{
+	uint8_t Hash[16] = {};
+
+	bool operator<(const VkShaderCacheKey& other) const { return memcmp(Hash, other.Hash, sizeof(Hash)) < 0; }
+	bool operator==(const VkShaderCacheKey& other) const { return memcmp(Hash, other.Hash, sizeof(Hash)) == 0; }
+};
+
+struct VkShaderCacheInclude
+{
+	FString Name;
+	bool System = false;
+	uint8_t Hash[16] = {};
+};
+
+// Disk cache of compiled SPIR-V, keyed by a hash of the assembled shader source.
+// Each entry also remembers the hashes of the files it included, so that a
+// changed include file invalidates it.
+//
+// Entries and variants that go unused for a number of sessions get dropped
+// when the cache is saved, and both are capped in size.
+class VkShaderCache
+{
+public:
+	VkShaderCache(FString filename);
+	~VkShaderCache();
+
+	// Returns the cached code, or an empty array if there is no entry or one of its includes changed
+	std::vector<uint32_t> Find(const VkShaderCacheKey& key, const std::function<bool(const FString& name, bool system, FString& text)>& loadInclude);
+	bool Contains(const VkShaderCacheKey& key) const { return Entries.find(key) != Entries.end(); }
+	void Add(const VkShaderCacheKey& key, std::vector<VkShaderCacheInclude> includes, std::vector<uint32_t> code);
+
+	struct Usage
+	{
+		uint32_t Age = 0; // Number of saved sessions since it was last used
+		bool Used = false;
+
+		uint32_t SavedAge() const { return Used ? 0 : Age + 1; }
+	};
+
+	// Shader variants used by previous sessions. Used to guess which variants a level will need.
+	void AddVariant(const VkShaderKey& key);
+	const std::map<VkShaderKey, Usage>& GetVariants() const { return Variants; }
+
+	void Save();
+
+	static void HashText(const FString& text, uint8_t hash[16]);
+
+private:
+	void Load();
+	void Prune();
+
+	struct Entry : Usage
+	{
+		std::vector<VkShaderCacheInclude> Includes;
+		std::vector<uint32_t> Code;
+	};
+
+	FString Filename;
+	std::map<VkShaderCacheKey, Entry> Entries;
+	std::map<VkShaderKey, Usage> Variants;
+	bool Modified = false;
+};
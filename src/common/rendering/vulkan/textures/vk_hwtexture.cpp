@@ -108,8 +108,7 @@ void VkHardwareTexture::CreateImage(FTexture *tex, int translation, int flags)
 	if (!tex->isHardwareCanvas())
 	{
 		FTextureBuffer texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
-		bool indexed = flags & CTF_Indexed;
-		CreateTexture(texbuffer.mWidth, texbuffer.mHeight,indexed? 1 : 4, indexed? VK_FORMAT_R8_UNORM : VK_FORMAT_B8G8R8A8_UNORM, texbuffer.mBuffer, !indexed);
+		CreateImage(texbuffer, flags);
 	}
 	else
 	{
@@ -135,6 +134,12 @@ void VkHardwareTexture::CreateImage(FTexture *tex, int translation, int flags)
 	}
 }
 
+void VkHardwareTexture::CreateImage(const FTextureBuffer &texbuffer, int flags)
+{
+	bool indexed = flags & CTF_Indexed;
+	CreateTexture(texbuffer.mWidth, texbuffer.mHeight,indexed? 1 : 4, indexed? VK_FORMAT_R8_UNORM : VK_FORMAT_B8G8R8A8_UNORM, texbuffer.mBuffer, !indexed);
+}
+
 void VkHardwareTexture::CreateTexture(int w, int h, int pixelsize, VkFormat format, const void *pixels, bool mipmap)
 {
 	if (w <= 0 || h <= 0)
@@ -42,6 +42,10 @@ public:
 	VkTextureImage *GetImage(FTexture *tex, int translation, int flags);
 	VkTextureImage *GetDepthStencil(FTexture *tex);
 
+	// Texture precaching
+	bool HasImage() const { return mImage.Image != nullptr; }
+	void CreateImage(const FTextureBuffer &texbuffer, int flags);
+
 	VulkanRenderDevice* fb = nullptr;
 	std::list<VkHardwareTexture*>::iterator it;
 
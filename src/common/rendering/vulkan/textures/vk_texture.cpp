@@ -26,6 +26,7 @@
 #include "vk_renderbuffers.h"
 #include "vulkan/vk_postprocess.h"
 #include "hw_cvars.h"
+#include "hw_levelmesh.h"
 
 VkTextureManager::VkTextureManager(VulkanRenderDevice* fb) : fb(fb)
 {
@@ -181,16 +182,12 @@ void VkTextureManager::CreateShadowmap()
 
 void VkTextureManager::CreateLightmap()
 {
-	TArray<uint16_t> data;
-	data.Push(0);
-	data.Push(0);
-	data.Push(0);
-	CreateLightmap(1, 1, std::move(data));
+	CreateLightmap(1, 1, {}, {});
 }
 
-void VkTextureManager::CreateLightmap(int newLMTextureSize, int newLMTextureCount, TArray<uint16_t>&& newPixelData)
+void VkTextureManager::CreateLightmap(int newLMTextureSize, int newLMTextureCount, TArray<LightmapTileUpload>&& newTiles, TArray<uint16_t>&& newPixelData)
 {
-	if (LMTextureSize == newLMTextureSize && LMTextureCount == newLMTextureCount + 1 && newPixelData.Size() == 0)
+	if (LMTextureSize == newLMTextureSize && LMTextureCount == newLMTextureCount + 1 && newTiles.Size() == 0)
 		return;
 
 	LMTextureSize = newLMTextureSize;
@@ -198,7 +195,6 @@ void VkTextureManager::CreateLightmap(int newLMTextureSize, int newLMTextureCoun
 	
 	int w = newLMTextureSize;
 	int h = newLMTextureSize;
-	int count = newLMTextureCount;
 	int pixelsize = 8;
 
 	Lightmap.Reset(fb);
@@ -218,11 +214,28 @@ void VkTextureManager::CreateLightmap(int newLMTextureSize, int newLMTextureCoun
 
 	auto cmdbuffer = fb->GetCommands()->GetTransferCommands();
 
-	if (count > 0 && newPixelData.Size() >= (size_t)w * h * count * 3)
+	// Clear the atlas on the GPU. Only the baked tiles are uploaded, everything else is left for the lightmapper.
+	VkImageTransition()
+		.AddImage(&Lightmap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, 0, 1, 0, LMTextureCount)
+		.Execute(cmdbuffer);
+
+	VkClearColorValue black = {};
+	VkImageSubresourceRange range = {};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.levelCount = 1;
+	range.layerCount = LMTextureCount;
+	cmdbuffer->clearColorImage(Lightmap.Image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &range);
+
+	size_t tilePixels = 0;
+	for (const LightmapTileUpload& tile : newTiles)
 	{
-		assert(newPixelData.Size() == (size_t)w * h * count * 3);
+		assert(tile.PixelsOffset + (size_t)tile.Width * tile.Height * 3 <= newPixelData.Size());
+		tilePixels += (size_t)tile.Width * tile.Height;
+	}
 
-		int totalSize = w * h * count * pixelsize;
+	if (tilePixels > 0)
+	{
+		size_t totalSize = tilePixels * pixelsize;
 
 		auto stagingBuffer = BufferBuilder()
 			.Size(totalSize)
@@ -231,34 +244,46 @@ void VkTextureManager::CreateLightmap(int newLMTextureSize, int newLMTextureCoun
 			.Create(fb->GetDevice());
 
 		uint16_t one = 0x3c00; // half-float 1.0
-		const uint16_t* src = newPixelData.Data();
 		uint16_t* data = (uint16_t*)stagingBuffer->Map(0, totalSize);
-		for (int i = w * h * count; i > 0; i--)
+
+		std::vector<VkBufferImageCopy> regions;
+		regions.reserve(newTiles.Size());
+		VkDeviceSize offset = 0;
+		for (const LightmapTileUpload& tile : newTiles)
 		{
-			*(data++) = *(src++);
-			*(data++) = *(src++);
-			*(data++) = *(src++);
-			*(data++) = one;
+			const uint16_t* src = newPixelData.Data() + tile.PixelsOffset;
+			for (int i = tile.Width * tile.Height; i > 0; i--)
+			{
+				*(data++) = *(src++);
+				*(data++) = *(src++);
+				*(data++) = *(src++);
+				*(data++) = one;
+			}
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.baseArrayLayer = tile.ArrayIndex;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset.x = tile.X;
+			region.imageOffset.y = tile.Y;
+			region.imageExtent.width = tile.Width;
+			region.imageExtent.height = tile.Height;
+			region.imageExtent.depth = 1;
+			regions.push_back(region);
+
+			offset += (VkDeviceSize)tile.Width * tile.Height * pixelsize;
 		}
 		stagingBuffer->Unmap();
 
-		VkImageTransition()
-			.AddImage(&Lightmap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, 0, 1, 0, LMTextureCount)
-			.Execute(cmdbuffer);
-
-		VkBufferImageCopy region = {};
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.layerCount = count;
-		region.imageExtent.depth = 1;
-		region.imageExtent.width = w;
-		region.imageExtent.height = h;
-		cmdbuffer->copyBufferToImage(stagingBuffer->buffer, Lightmap.Image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		cmdbuffer->copyBufferToImage(stagingBuffer->buffer, Lightmap.Image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
 
 		fb->GetCommands()->TransferDeleteList->Add(std::move(stagingBuffer));
-	
-		newPixelData.Clear();
 	}
 
+	newTiles.Clear();
+	newPixelData.Clear();
+
 	VkImageTransition()
 		.AddImage(&Lightmap, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, 0, 1, 0, LMTextureCount)
 		.Execute(cmdbuffer);
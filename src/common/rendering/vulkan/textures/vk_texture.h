@@ -12,6 +12,7 @@ class VkPPTexture;
 class VkTextureImage;
 enum class PPTextureType;
 class PPTexture;
+struct LightmapTileUpload;
 
 class VkTextureManager
 {
@@ -23,7 +24,7 @@ public:
 
 	void BeginFrame();
 
-	void CreateLightmap(int newLMTextureSize, int newLMTextureCount, TArray<uint16_t>&& newPixelData);
+	void CreateLightmap(int newLMTextureSize, int newLMTextureCount, TArray<LightmapTileUpload>&& newTiles, TArray<uint16_t>&& newPixelData);
 
 	VkTextureImage* GetTexture(const PPTextureType& type, PPTexture* tex);
 	VkFormat GetTextureFormat(PPTexture* texture);
@@ -65,6 +65,10 @@
 #include "c_dispatch.h"
 #include "menu.h"
 #include "cmdlib.h"
+#include "workerpool.h"
+#include <set>
+#include <future>
+#include <thread>
 
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int maxFrames = -1);
 
@@ -322,6 +326,78 @@ void VulkanRenderDevice::PrecacheMaterial(FMaterial *mat, int translation)
 		auto syslayer = static_cast<VkHardwareTexture*>(mat->GetLayer(i, 0, &layer));
 		syslayer->GetImage(layer->layerTexture, 0, layer->scaleFlags);
 	}
+
+	mShaderManager->PrecacheEffectState(mat->GetShaderIndex());
+}
+
+void VulkanRenderDevice::PrecacheMaterials(const TArray<std::pair<FMaterial*, int>> &materials)
+{
+	struct PrecacheJob
+	{
+		VkHardwareTexture* SysTex;
+		FTexture* Tex;
+		int Translation;
+		int Flags;
+		std::future<FTextureBuffer> Result;
+	};
+
+	// Find all layers that still need an image
+	std::vector<PrecacheJob> jobs;
+	std::set<VkHardwareTexture*> queued;
+	for (auto& it : materials)
+	{
+		FMaterial* mat = it.first;
+		if (mat->Source()->GetUseType() == ETextureType::SWCanvas) continue;
+
+		int numLayers = mat->NumLayers();
+		for (int i = 0; i < numLayers; i++)
+		{
+			int translation = i == 0 ? it.second : 0;
+			MaterialLayerInfo* layer;
+			auto systex = static_cast<VkHardwareTexture*>(mat->GetLayer(i, translation, &layer));
+			if (layer->layerTexture->isHardwareCanvas())
+				systex->GetImage(layer->layerTexture, translation, layer->scaleFlags);
+			else if (!systex->HasImage() && queued.insert(systex).second)
+				jobs.push_back({ systex, layer->layerTexture, translation, layer->scaleFlags });
+		}
+
+		mShaderManager->PrecacheEffectState(mat->GetShaderIndex());
+	}
+
+	// Reading the images goes through the file system and the image precache, neither of which is thread safe,
+	// so that part stays on this thread. Upscaling runs on worker threads while the next images are read, and
+	// the finished buffers are uploaded in order.
+	size_t maxInFlight = WorkerPoolSize() * 2;
+	size_t nextUpload = 0;
+
+	auto upload = [&](PrecacheJob& job)
+	{
+		FTextureBuffer texbuffer = job.Result.get();
+		job.Tex->ProcessTexBuffer(texbuffer, job.Flags);
+		job.SysTex->CreateImage(texbuffer, job.Flags);
+	};
+
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		FTexture* tex = jobs[i].Tex;
+		int flags = jobs[i].Flags;
+		FTextureBuffer texbuffer = tex->CreateTexBuffer(jobs[i].Translation, flags);
+		jobs[i].Result = WorkerPool().push([=, texbuffer = std::move(texbuffer)](int) mutable
+		{
+			tex->UpscaleTexBuffer(texbuffer, flags);
+			return std::move(texbuffer);
+		});
+
+		while (nextUpload <= i && (i + 1 - nextUpload > maxInFlight || jobs[nextUpload].Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+		{
+			upload(jobs[nextUpload++]);
+		}
+	}
+
+	while (nextUpload < jobs.size())
+	{
+		upload(jobs[nextUpload++]);
+	}
 }
 
 IHardwareTexture *VulkanRenderDevice::CreateHardwareTexture(int numchannels)
@@ -484,7 +560,7 @@ void VulkanRenderDevice::BeginFrame()
 
 		if (levelMesh && levelMesh->StaticMesh->LMTextureCount > 0)
 		{
-			GetTextureManager()->CreateLightmap(levelMesh->StaticMesh->LMTextureSize, levelMesh->StaticMesh->LMTextureCount, std::move(levelMesh->StaticMesh->LMTextureData));
+			GetTextureManager()->CreateLightmap(levelMesh->StaticMesh->LMTextureSize, levelMesh->StaticMesh->LMTextureCount, std::move(levelMesh->StaticMesh->LMBakedTiles), std::move(levelMesh->StaticMesh->LMTilePixels));
 			GetLightmapper()->SetLevelMesh(levelMesh);
 		}
 	}
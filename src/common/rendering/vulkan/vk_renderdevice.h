@@ -54,6 +54,7 @@ public:
 	void InitializeState() override;
 	bool CompileNextShader() override;
 	void PrecacheMaterial(FMaterial *mat, int translation) override;
+	void PrecacheMaterials(const TArray<std::pair<FMaterial*, int>> &materials) override;
 	void UpdatePalette() override;
 	const char* DeviceName() const override;
 	int Backend() override { return 1; }
@@ -396,19 +396,35 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 		result.mBuffer = buffer;
 		result.mWidth = W;
 		result.mHeight = H;
+		result.mTranslucent = isTransparent;
 
-		// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
-		if (GetImage() && flags & CTF_ProcessData)
+		if (flags & CTF_ProcessData)
 		{
-			if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
-
-			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+			UpscaleTexBuffer(result, flags);
+			ProcessTexBuffer(result, flags);
 		}
 	}
 	return result;
 
 }
 
+//===========================================================================
+// 
+//	Postprocessing for hardware textures. Only done for image-backed textures.
+//	(i.e. not for the burn texture which can also pass through here.)
+//
+//===========================================================================
+
+void FTexture::UpscaleTexBuffer(FTextureBuffer &buffer, int flags)
+{
+	if (GetImage() && (flags & CTF_Upscale)) CreateUpsampledTextureBuffer(buffer, !!buffer.mTranslucent, !!(flags & CTF_CheckOnly));
+}
+
+void FTexture::ProcessTexBuffer(FTextureBuffer &buffer, int flags)
+{
+	if (GetImage() && !(flags & CTF_CheckOnly)) ProcessData(buffer.mBuffer, buffer.mWidth, buffer.mHeight, false);
+}
+
 //===========================================================================
 // 
 // Dummy texture for the 0-entry.
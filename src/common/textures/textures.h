@@ -172,6 +172,7 @@ struct FTextureBuffer
 	int mWidth = 0;
 	int mHeight = 0;
 	uint64_t mContentId = 0;	// unique content identifier. (Two images created from the same image source with the same settings will return the same value.)
+	int mTranslucent = -1;		// translucency of the source data, needed by the upscaler. -1 if not known.
 
 	FTextureBuffer() = default;
 
@@ -187,6 +188,7 @@ struct FTextureBuffer
 		mWidth = other.mWidth;
 		mHeight = other.mHeight;
 		mContentId = other.mContentId;
+		mTranslucent = other.mTranslucent;
 		other.mBuffer = nullptr;
 	}
 
@@ -196,6 +198,7 @@ struct FTextureBuffer
 		mWidth = other.mWidth;
 		mHeight = other.mHeight;
 		mContentId = other.mContentId;
+		mTranslucent = other.mTranslucent;
 		other.mBuffer = nullptr;
 		return *this;
 	}
@@ -289,6 +292,10 @@ public:
 
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
+	// The two halves of the CTF_ProcessData postprocessing, for callers that create the buffer without it.
+	// UpscaleTexBuffer only touches the buffer and can run on a worker thread.
+	void UpscaleTexBuffer(FTextureBuffer &buffer, int flags);
+	void ProcessTexBuffer(FTextureBuffer &buffer, int flags);
 	virtual bool DetermineTranslucency();
 	bool GetTranslucency()
 	{
@@ -0,0 +1,114 @@
+/*
+** workerpool.cpp
+** Shared pool of worker threads
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "workerpool.h"
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+ctpl::thread_pool &WorkerPool()
+{
+	static ctpl::thread_pool pool(WorkerPoolSize());
+	return pool;
+}
+
+int WorkerPoolSize()
+{
+	return std::max((int)std::thread::hardware_concurrency() - 1, 1);
+}
+
+//==========================================================================
+//
+// The state is shared with the worker tasks because a task may only get
+// to run after the caller has already returned. Such a task finds no job
+// left and never touches the caller's function object.
+//
+//==========================================================================
+
+struct FWorkerPoolRun
+{
+	const std::function<void(int)> *Job;
+	int Count;
+	std::atomic<int> Next { 0 };
+	std::atomic<int> Done { 0 };
+	std::mutex Mutex;
+	std::condition_variable Finished;
+
+	void Work()
+	{
+		int i;
+		while ((i = Next++) < Count)
+		{
+			(*Job)(i);
+			if (++Done == Count)
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Finished.notify_all();
+			}
+		}
+	}
+};
+
+void RunOnWorkerPool(int count, const std::function<void(int)> &job)
+{
+	if (count <= 1)
+	{
+		if (count == 1) job(0);
+		return;
+	}
+
+	auto run = std::make_shared<FWorkerPoolRun>();
+	run->Job = &job;
+	run->Count = count;
+
+	int helpers = std::min(count - 1, WorkerPoolSize());
+	for (int i = 0; i < helpers; i++)
+	{
+		WorkerPool().push([run](int) { run->Work(); });
+	}
+	run->Work();
+
+	std::unique_lock<std::mutex> lock(run->Mutex);
+	run->Finished.wait(lock, [&] { return run->Done == count; });
+}
@@ -0,0 +1,86 @@
+/*
+** workerpool.h
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include "ctpl.h"
+
+// The engine's shared pool of worker threads, created on first use with one
+// thread less than there are cores. Everything that wants to run work in
+// parallel should use this instead of creating its own pool.
+//
+// Tasks pushed here must never wait for other tasks of this pool, or they
+// can deadlock once all workers are busy.
+ctpl::thread_pool &WorkerPool();
+int WorkerPoolSize();
+
+// Calls job(i) for every i in [0, count) and returns when all calls are done.
+// job must not throw.
+// The calling thread works on the jobs as well, so this does not stall when
+// the workers are busy with something else.
+void RunOnWorkerPool(int count, const std::function<void(int)> &job);
+
+// Holds the future of a task pushed to the pool and waits for it when it goes
+// out of scope. Use this when the task refers to data of the calling scope,
+// so that an exception leaving the scope cannot leave the task running on
+// data that no longer exists.
+template<class T>
+class TWorkerTask
+{
+public:
+	TWorkerTask() = default;
+	TWorkerTask(std::future<T> &&future) : Future(std::move(future)) {}
+	TWorkerTask(const TWorkerTask &) = delete;
+	TWorkerTask &operator=(const TWorkerTask &) = delete;
+	~TWorkerTask() { Wait(); }
+
+	TWorkerTask &operator=(std::future<T> &&future)
+	{
+		Wait();
+		Future = std::move(future);
+		return *this;
+	}
+
+	bool Valid() const { return Future.valid(); }
+	T Get() { return Future.get(); }
+
+	void Wait()
+	{
+		if (Future.valid()) Future.wait();
+	}
+
+private:
+	std::future<T> Future;
+};
@@ -1216,20 +1216,25 @@ void D_DoomLoop ()
 			// process one or more tics
 			if (singletics)
 			{
-				I_StartTic ();
-				D_ProcessEvents ();
-				G_BuildTiccmd (&netcmds[consoleplayer][maketic%BACKUPTICS]);
-				if (advancedemo)
-					D_DoAdvanceDemo ();
-				C_Ticker ();
-				M_Ticker ();
-				G_Ticker ();
-				// [RH] Use the consoleplayer's camera to update sounds
-				S_UpdateSounds (players[consoleplayer].camera);	// move positional sounds
-				gametic++;
-				maketic++;
-				GC::CheckGC ();
-				Net_NewMakeTic ();
+				// While a demo is seeking, run as many tics as fit into a few frames before drawing.
+				uint64_t frameend = I_msTime() + 50;
+				do
+				{
+					I_StartTic ();
+					D_ProcessEvents ();
+					G_BuildTiccmd (&netcmds[consoleplayer][maketic%BACKUPTICS]);
+					if (advancedemo)
+						D_DoAdvanceDemo ();
+					C_Ticker ();
+					M_Ticker ();
+					G_Ticker ();
+					// [RH] Use the consoleplayer's camera to update sounds
+					S_UpdateSounds (players[consoleplayer].camera);	// move positional sounds
+					gametic++;
+					maketic++;
+					GC::CheckGC ();
+					Net_NewMakeTic ();
+				} while (G_IsDemoSeeking() && I_msTime() < frameend);
 			}
 			else
 			{
@@ -3661,7 +3666,9 @@ static int D_DoomMain_Internal (void)
 		OkForLocalization,
 		[]() ->FConfigFile* { return GameConfig; },
 		nullptr, 
-		RemapUserTranslation
+		RemapUserTranslation,
+		Net_LoopbackReceive,
+		Net_LoopbackUpdate
 	};
 
 	
@@ -102,7 +102,6 @@ uint8_t NetMode = NET_PeerToPeer;
 //
 // a gametic cannot be run until nettics[] > gametic for all players
 //
-#define RESENDCOUNT 	10
 #define PL_DRONE		0x80	// bit flag in doomdata->player
 
 ticcmd_t		localcmds[LOCALCMDTICS];
@@ -112,9 +111,9 @@ ticcmd_t		netcmds[MAXPLAYERS][BACKUPTICS];
 int 			nettics[MAXNETNODES];
 bool 			nodeingame[MAXNETNODES];				// set false as nodes leave game
 bool			nodejustleft[MAXNETNODES];				// set when a node just left
-bool	 		remoteresend[MAXNETNODES];				// set when local needs tics
-int 			resendto[MAXNETNODES];					// set when remote needs tics
-int 			resendcount[MAXNETNODES];
+int 			ackedtics[MAXNETNODES];					// the remote node has all of our tics before this
+int 			senttics[MAXNETNODES];					// we have sent all of our tics before this
+int 			lastsendtime[MAXNETNODES];				// when the last packet to the node went out
 
 uint64_t		lastrecvtime[MAXPLAYERS];				// [RH] Used for pings
 uint64_t		currrecvtime[MAXPLAYERS];
@@ -151,31 +150,20 @@ static int	oldentertics;
 extern	bool	 advancedemo;
 
 CVAR(Bool, net_ticbalance, false, CVAR_SERVERINFO | CVAR_NOSAVE)
-CUSTOM_CVAR(Int, net_extratic, 0, CVAR_SERVERINFO | CVAR_NOSAVE)
+// Number of tics to collect before sending them out. Higher values send
+// fewer packets, but each tic then waits longer before it is sent.
+CUSTOM_CVAR(Int, net_ticbatch, 1, 0)
 {
-	if (self < 0)
+	if (self < 1)
 	{
-		self = 0;
+		self = 1;
 	}
-	else if (self > 2)
+	else if (self > 4)
 	{
-		self = 2;
+		self = 4;
 	}
 }
 
-#ifdef _DEBUG
-CVAR(Int, net_fakelatency, 0, 0);
-
-struct PacketStore
-{
-	int timer;
-	doomcom_t message;
-};
-
-static TArray<PacketStore> InBuffer;
-static TArray<PacketStore> OutBuffer;
-#endif
-
 // [RH] Special "ticcmds" get stored in here
 static struct TicSpecial
 {
@@ -321,9 +309,9 @@ void Net_ClearBuffers ()
 	memset (nodeingame, 0, sizeof(nodeingame));
 	memset (nodeforplayer, 0, sizeof(nodeforplayer));
 	memset (playerfornode, 0, sizeof(playerfornode));
-	memset (remoteresend, 0, sizeof(remoteresend));
-	memset (resendto, 0, sizeof(resendto));
-	memset (resendcount, 0, sizeof(resendcount));
+	memset (ackedtics, 0, sizeof(ackedtics));
+	memset (senttics, 0, sizeof(senttics));
+	memset (lastsendtime, 0, sizeof(lastsendtime));
 	memset (lastrecvtime, 0, sizeof(lastrecvtime));
 	memset (currrecvtime, 0, sizeof(currrecvtime));
 	memset (consistancy, 0, sizeof(consistancy));
@@ -355,10 +343,7 @@ int NetbufferSize ()
 		return doomcom.datalength;
 	}
 
-	int k = 2, count, numtics;
-
-	if (netbuffer[0] & NCMD_RETRANSMIT)
-		k++;
+	int k = 3, count, numtics;
 
 	if (NetMode == NET_PacketServer && doomcom.remotenode == nodeforplayer[Net_Arbitrator])
 		k++;
@@ -434,7 +419,7 @@ void HSendPacket (int node, int len)
 {
 	if (debugfile && node != 0)
 	{
-		int i, k, realretrans;
+		int i, k, realack;
 
 		if (netbuffer[0] & NCMD_SETUP)
 		{
@@ -458,20 +443,17 @@ void HSendPacket (int node, int len)
 				k++;
 			}
 
-			if (netbuffer[0] & NCMD_RETRANSMIT)
-				realretrans = ExpandTics (netbuffer[k++]);
-			else
-				realretrans = -1;
+			realack = ExpandTics (netbuffer[k++]);
 
 			int numtics = netbuffer[0] & 3;
 			if (numtics == 3)
 				numtics += netbuffer[k++];
 
-			fprintf (debugfile,"%i/%i send %i = (%i + %i, R %i) [%3i]",
+			fprintf (debugfile,"%i/%i send %i = (%i + %i, A %i) [%3i]",
 					gametic, maketic,
 					node,
 					ExpandTics(netbuffer[1]),
-					numtics, realretrans, len);
+					numtics, realack, len);
 			
 			for (i = 0; i < len; i++)
 				fprintf (debugfile, "%c%2x", i==k?'|':' ', ((uint8_t *)netbuffer)[i]);
@@ -517,30 +499,7 @@ void HSendPacket (int node, int len)
 	doomcom.remotenode = node;
 	doomcom.datalength = len;
 
-#ifdef _DEBUG
-	if (net_fakelatency / 2 > 0)
-	{
-		PacketStore store;
-		store.message = doomcom;
-		store.timer = I_GetTime() + ((net_fakelatency / 2) / (1000 / TICRATE));
-		OutBuffer.Push(store);
-	}
-	else
-		I_NetCmd();
-
-	for (unsigned int i = 0; i < OutBuffer.Size(); i++)
-	{
-		if (OutBuffer[i].timer <= I_GetTime())
-		{
-			doomcom = OutBuffer[i].message;
-			I_NetCmd();
-			OutBuffer.Delete(i);
-			i = -1;
-		}
-	}
-#else
 	I_NetCmd();
-#endif
 }
 
 //
@@ -566,42 +525,14 @@ bool HGetPacket (void)
 	doomcom.command = CMD_GET;
 	I_NetCmd ();
 
-#ifdef _DEBUG
-	if (net_fakelatency / 2 > 0 && doomcom.remotenode != -1)
-	{
-		PacketStore store;
-		store.message = doomcom;
-		store.timer = I_GetTime() + ((net_fakelatency / 2) / (1000 / TICRATE));
-		InBuffer.Push(store);
-		doomcom.remotenode = -1;
-	}
-	
-	if (doomcom.remotenode == -1)
-	{
-		bool gotmessage = false;
-		for (unsigned int i = 0; i < InBuffer.Size(); i++)
-		{
-			if (InBuffer[i].timer <= I_GetTime())
-			{
-				doomcom = InBuffer[i].message;
-				InBuffer.Delete(i);
-				gotmessage = true;
-				break;
-			}
-		}
-		if (!gotmessage)
-			return false;
-	}
-#else
 	if (doomcom.remotenode == -1)
 	{
 		return false;
 	}
-#endif
 		
 	if (debugfile)
 	{
-		int i, k, realretrans;
+		int i, k, realack;
 
 		if (netbuffer[0] & NCMD_SETUP)
 		{
@@ -626,20 +557,17 @@ bool HGetPacket (void)
 				k++;
 			}
 
-			if (netbuffer[0] & NCMD_RETRANSMIT)
-				realretrans = ExpandTics (netbuffer[k++]);
-			else
-				realretrans = -1;
+			realack = ExpandTics (netbuffer[k++]);
 
 			int numtics = netbuffer[0] & 3;
 			if (numtics == 3)
 				numtics += netbuffer[k++];
 
-			fprintf (debugfile,"%i/%i  get %i = (%i + %i, R %i) [%3i]",
+			fprintf (debugfile,"%i/%i  get %i = (%i + %i, A %i) [%3i]",
 					gametic, maketic,
 					doomcom.remotenode,
 					ExpandTics(netbuffer[1]),
-					numtics, realretrans, doomcom.datalength);
+					numtics, realack, doomcom.datalength);
 			
 			for (i = 0; i < doomcom.datalength; i++)
 				fprintf (debugfile, "%c%2x", i==k?'|':' ', ((uint8_t *)netbuffer)[i]);
@@ -749,7 +677,7 @@ void GetPackets (void)
 	int realend;
 	int realstart;
 	int numtics;
-	int retransmitfrom;
+	int realack;
 	int k;
 	uint8_t playerbytes[MAXNETNODES];
 	int numplayers;
@@ -791,10 +719,10 @@ void GetPackets (void)
 					{
 						if (playeringame[i])
 						{
-							int resend = ReadLong (&foo);
+							int acked = ReadLong (&foo);
 							if (i != consoleplayer)
 							{
-								resendto[nodeforplayer[i]] = resend;
+								ackedtics[nodeforplayer[i]] = senttics[nodeforplayer[i]] = acked;
 							}
 						}
 					}
@@ -817,14 +745,7 @@ void GetPackets (void)
 			mastertics = ExpandTics (netbuffer[k++]);
 		}
 
-		if (netbuffer[0] & NCMD_RETRANSMIT)
-		{
-			retransmitfrom = netbuffer[k++];
-		}
-		else
-		{
-			retransmitfrom = 0;
-		}
+		realack = ExpandTics (netbuffer[k++]);
 
 		numtics = (netbuffer[0] & NCMD_XTICS);
 		if (numtics == 3)
@@ -864,17 +785,11 @@ void GetPackets (void)
 		
 		nodeforplayer[netconsole] = netnode;
 		
-		// check for retransmit request
-		if (resendcount[netnode] <= 0 && (netbuffer[0] & NCMD_RETRANSMIT))
+		// Everything before the acknowledged tic needn't be sent again. Packets
+		// can arrive out of order, so an older acknowledgement changes nothing.
+		if (realack > ackedtics[netnode])
 		{
-			resendto[netnode] = ExpandTics (retransmitfrom);
-			if (debugfile)
-				fprintf (debugfile,"retransmit from %i\n", resendto[netnode]);
-			resendcount[netnode] = RESENDCOUNT;
-		}
-		else
-		{
-			resendcount[netnode]--;
+			ackedtics[netnode] = realack;
 		}
 		
 		// check for out of order / duplicated packet			
@@ -892,11 +807,11 @@ void GetPackets (void)
 		// check for a missed packet
 		if (realstart > nettics[netnode])
 		{
-			// stop processing until the other system resends the missed tics
+			// Packets start at the tic we last acknowledged, so this shouldn't
+			// happen. Wait for one that does.
 			if (debugfile)
 				fprintf (debugfile, "missed tics from %i (%i to %i)\n",
 						 netnode, nettics[netnode], realstart);
-			remoteresend[netnode] = true;
 			continue;
 		}
 
@@ -904,7 +819,6 @@ void GetPackets (void)
 		{
 			uint8_t *start;
 			int i, tics;
-			remoteresend[netnode] = false;
 
 			start = &netbuffer[k];
 
@@ -938,6 +852,7 @@ void NetUpdate (void)
 	int 	realstart;
 	uint8_t	*cmddata;
 	bool	resendOnly;
+	bool	holdNew;
 
 	GC::CheckGC();
 
@@ -1062,14 +977,19 @@ void NetUpdate (void)
 
 	if (demoplayback)
 	{
-		resendto[0] = nettics[0] = (maketic / ticdup);
+		ackedtics[0] = senttics[0] = nettics[0] = (maketic / ticdup);
 		return;			// Don't touch netcmd data while playing a demo, as it'll already exist.
 	}
 
-	// If maketic didn't cross a ticdup boundary, only send packets
-	// to players waiting for resends.
+	// If maketic didn't cross a ticdup boundary, no new tic was made,
+	// so only send packets to nodes that may need resends.
 	resendOnly = (maketic / ticdup) == (maketic - i) / ticdup;
 
+	// With net_ticbatch, new tics are held back until a whole batch of them
+	// is ready, and only then sent like normal.
+	int batch = ticdup * net_ticbatch;
+	holdNew = resendOnly || (maketic / batch) == (maketic - i) / batch;
+
 	// send the packet to the other nodes
 	int count = 1;
 	int quitcount = 0;
@@ -1127,7 +1047,10 @@ void NetUpdate (void)
 		{
 			continue;
 		}
-		if (resendOnly && resendcount[i] <= 0 && !remoteresend[i] && nettics[i])
+		// While holding back new tics, only send to nodes that still haven't
+		// acknowledged the last packet after a whole batch's time, and to the
+		// ones we haven't heard from yet.
+		if (holdNew && nettics[i] && (ackedtics[i] >= senttics[i] || nowtime - lastsendtime[i] < batch))
 		{
 			continue;
 		}
@@ -1138,7 +1061,7 @@ void NetUpdate (void)
 		lowtic = maketic / ticdup;
 
 		netbuffer[0] = 0;
-		netbuffer[1] = realstart = resendto[i];
+		netbuffer[1] = realstart = ackedtics[i];
 		k = 2;
 
 		if (NetMode == NET_PacketServer &&
@@ -1155,28 +1078,26 @@ void NetUpdate (void)
 			netbuffer[k++] = lowtic;
 		}
 
+		// Let the node know which of its tics it doesn't need to send again.
+		netbuffer[k++] = nettics[i];
+
+		// Everything the node hasn't acknowledged yet goes in every packet,
+		// so a lost packet is made up for by the next one that arrives.
 		numtics = max(0, lowtic - realstart);
 		if (numtics > BACKUPTICS)
 			I_Error ("NetUpdate: Node %d missed too many tics", i);
 
-		switch (net_extratic)
-		{
-		case 0:
-		default: 
-			resendto[i] = lowtic; break;
-		case 1: resendto[i] = max(0, lowtic - 1); break;
-		case 2: resendto[i] = nettics[i]; break;
-		}
-
-		if (numtics == 0 && resendOnly && !remoteresend[i] && nettics[i])
+		if (numtics == 0 && holdNew && nettics[i])
 		{
 			continue;
 		}
 
-		if (remoteresend[i])
+		senttics[i] = max(senttics[i], lowtic);
+		lastsendtime[i] = nowtime;
+		if (i == 0)
 		{
-			netbuffer[0] |= NCMD_RETRANSMIT;
-			netbuffer[k++] = nettics[i];
+			// Packets to ourselves can't get lost.
+			ackedtics[0] = lowtic;
 		}
 
 		if (numtics < 3)
@@ -1666,8 +1587,8 @@ bool D_CheckNetGame (void)
 	{
 		nodeingame[i] = false;
 		nettics[i] = 0;
-		remoteresend[i] = false;		// set when local needs tics
-		resendto[i] = 0;				// which tic to start sending
+		ackedtics[i] = 0;				// which tic to start sending
+		senttics[i] = 0;
 	}
 
 	// Packet server has proven to be rather slow over the internet. Print a warning about it.
@@ -1709,11 +1630,6 @@ bool D_CheckNetGame (void)
 			Printf("Selected " TEXTCOLOR_BLUE "%s" TEXTCOLOR_NORMAL " networking mode. (%s)\n", NetMode == NET_PeerToPeer ? "peer to peer" : "packet server",
 				v != NULL ? "forced" : "auto");
 		}
-
-		if (Args->CheckParm("-extratic"))
-		{
-			net_extratic = 1;
-		}
 	}
 
 	// [RH] Setup user info
@@ -1774,12 +1690,12 @@ void D_QuitNetGame (void)
 	{
 		uint8_t *foo = &netbuffer[2];
 
-		// Let the new arbitrator know what resendto counts to use
+		// Let the new arbitrator know which tics everyone already has
 
 		for (i = 0; i < MAXPLAYERS; ++i)
 		{
 			if (playeringame[i] && i != consoleplayer)
-				WriteLong (resendto[nodeforplayer[i]], &foo);
+				WriteLong (ackedtics[nodeforplayer[i]], &foo);
 		}
 		k = int(foo - netbuffer);
 	}
@@ -1803,6 +1719,178 @@ void D_QuitNetGame (void)
 		fclose (debugfile);
 }
 
+//==========================================================================
+//
+// Loopback nodes
+//
+// In a -loopback game, every node but this one is played here. Each goes
+// through setup like a real guest and then sends tics for a player that
+// turns back and forth in place, with the consistancy checks this machine
+// expects from it. Tics are acknowledged and repeated the same way as in
+// NetUpdate, so the game runs just like it would with real guests.
+//
+//==========================================================================
+
+static struct FLoopbackNode
+{
+	bool		InGame;
+	uint32_t	PlayersDetected;
+	uint8_t		GotSetup;
+	uint64_t	LastSetupTime;
+	int			Clock;			// time the node has made tics up to
+	int			MakeTic;
+	int			RecvTic;		// the node has all of our tics before this
+	int			AckedTic;		// we have all of the node's tics before this
+	int			SentTic;
+	int			LastSendTime;
+	short		Consistancy[BACKUPTICS];
+} loopbacknodes[MAXNETNODES];
+
+static void LoopbackTicCmd (int tic, usercmd_t *cmd)
+{
+	memset (cmd, 0, sizeof(*cmd));
+	cmd->yaw = ((tic / TICRATE) % 3 - 1) * 256;
+}
+
+void Net_LoopbackReceive (int node, const uint8_t *data, int len)
+{
+	FLoopbackNode &peer = loopbacknodes[node];
+
+	if (data[0] & NCMD_SETUP)
+	{
+		if (data[0] == NCMD_SETUP+1)
+		{
+			peer.PlayersDetected |= 1 << data[1];
+		}
+		else if (data[0] == NCMD_SETUP+2)
+		{
+			peer.GotSetup = 0x80;
+		}
+		else if (data[0] == NCMD_SETUP+3)
+		{
+			peer.InGame = true;
+		}
+		return;
+	}
+	if (data[0] & NCMD_EXIT)
+	{
+		return;
+	}
+
+	// Any game packet means the game has started, even if NCMD_SETUP+3 got lost.
+	peer.InGame = true;
+
+	int k = 2;
+	if (NetMode == NET_PacketServer)
+	{
+		k++;		// this machine is always the master
+	}
+	int realack = ExpandTics (data[k++]);
+	int realstart = ExpandTics (data[1]);
+	int numtics = data[0] & NCMD_XTICS;
+	if (numtics == 3)
+	{
+		numtics += data[k++];
+	}
+
+	if (realstart <= peer.RecvTic && realstart + numtics > peer.RecvTic)
+	{
+		peer.RecvTic = realstart + numtics;
+	}
+	peer.AckedTic = max(peer.AckedTic, realack);
+}
+
+void Net_LoopbackUpdate (int node)
+{
+	static uint8_t packet[MAX_MSGLEN];
+	FLoopbackNode &peer = loopbacknodes[node];
+	uint8_t *stream;
+	int nowtime = I_GetTime ();
+
+	if (!peer.InGame)
+	{
+		// Report to the host a few times a second, like DoArbitrate.
+		uint64_t now = I_msTime ();
+		peer.Clock = nowtime;
+		if (now - peer.LastSetupTime < 100)
+		{
+			return;
+		}
+		peer.LastSetupTime = now;
+
+		packet[0] = NCMD_SETUP;
+		packet[1] = node;			// player numbers match the nodes on the host
+		packet[2] = 255;
+		packet[3] = (NETGAMEVERSION >> 8) & 255;
+		packet[4] = NETGAMEVERSION & 255;
+		packet[5] = peer.PlayersDetected >> 24;
+		packet[6] = peer.PlayersDetected >> 16;
+		packet[7] = peer.PlayersDetected >> 8;
+		packet[8] = peer.PlayersDetected;
+		packet[9] = peer.GotSetup;
+		stream = &packet[10];
+		FStringf info("\\name\\Loopback %d", node + 1);
+		memcpy (stream, info.GetChars(), info.Len() + 1);
+		stream += info.Len() + 1;
+		I_LoopbackSend (node, packet, int(stream - packet));
+		return;
+	}
+
+	// Make tics at the same pace as this machine, and stop where NetUpdate
+	// would if we were its gametic.
+	for (; peer.Clock < nowtime; peer.Clock++)
+	{
+		if ((peer.MakeTic - peer.RecvTic * ticdup) / ticdup >= BACKUPTICS/2-1)
+			continue;
+
+		if (peer.MakeTic % ticdup == 0)
+		{
+			int tic = peer.MakeTic / ticdup;
+			peer.Consistancy[tic % BACKUPTICS] = consistancy[node][tic % BACKUPTICS];
+		}
+		peer.MakeTic++;
+	}
+
+	int lowtic = peer.MakeTic / ticdup;
+	if (lowtic == peer.SentTic && (peer.AckedTic >= peer.SentTic || nowtime - peer.LastSendTime < ticdup))
+	{
+		return;
+	}
+
+	int realstart = peer.AckedTic;
+	int numtics = clamp<int>(lowtic - realstart, 0, BACKUPTICS);
+	int k = 2;
+
+	packet[0] = 0;
+	packet[1] = realstart;
+	packet[k++] = peer.RecvTic;
+	if (numtics < 3)
+	{
+		packet[0] |= numtics;
+	}
+	else
+	{
+		packet[0] |= NCMD_XTICS;
+		packet[k++] = numtics - 3;
+	}
+	packet[k++] = 0;				// network delay
+
+	stream = &packet[k];
+	for (int tic = realstart; tic < realstart + numtics; tic++)
+	{
+		usercmd_t cmd, prev;
+
+		LoopbackTicCmd (tic, &cmd);
+		LoopbackTicCmd (tic - 1, &prev);
+		WriteWord (peer.Consistancy[tic % BACKUPTICS], &stream);
+		WriteUserCmdMessage (&cmd, tic > 0 ? &prev : NULL, &stream);
+	}
+
+	peer.SentTic = max(peer.SentTic, realstart + numtics);
+	peer.LastSendTime = nowtime;
+	I_LoopbackSend (node, packet, int(stream - packet));
+}
+
 // Forces playsim processing time to be consistent across frames.
 // This improves interpolation for frames in between tics.
 //
@@ -2015,7 +2103,7 @@ void Net_CheckLastReceived (int counts)
 		if (NetMode == NET_PeerToPeer || consoleplayer == Net_Arbitrator)
 		{
 			//Keep the local node in the for loop so we can still log any cases where the local node is /somehow/ late.
-			//However, we don't send a resend request for sanity reasons.
+			//However, we don't mark it as waiting for sanity reasons.
 			for (int i = 0; i < doomcom.numnodes; i++)
 			{
 				if (nodeingame[i] && nettics[i] <= gametic + counts)
@@ -2023,21 +2111,22 @@ void Net_CheckLastReceived (int counts)
 					if (debugfile && !players[playerfornode[i]].waiting)
 						fprintf(debugfile, "%i is slow (%i to %i)\n",
 						i, nettics[i], gametic + counts);
-					//Send resend request to the late node. Also mark the node as waiting to display it in the hud.
+					//Mark the node as waiting to display it in the hud. It resends its tics by
+					//itself as long as our acknowledgements stay behind.
 					if (i != 0)
-						remoteresend[i] = players[playerfornode[i]].waiting = hadlate = true;
+						players[playerfornode[i]].waiting = hadlate = true;
 				}
 				else
 					players[playerfornode[i]].waiting = false;
 			}
 		}
 		else
-		{	//Send a resend request to the Arbitrator, as it's obvious we are stuck here.
+		{	//The Arbitrator is late, as it's obvious we are stuck here.
 			if (debugfile && !players[Net_Arbitrator].waiting)
 				fprintf(debugfile, "Arbitrator is slow (%i to %i)\n",
 				nettics[nodeforplayer[Net_Arbitrator]], gametic + counts);
-			//Send resend request to the Arbitrator. Also mark the Arbitrator as waiting to display it in the hud.
-			remoteresend[nodeforplayer[Net_Arbitrator]] = players[Net_Arbitrator].waiting = hadlate = true;
+			//Mark the Arbitrator as waiting to display it in the hud.
+			players[Net_Arbitrator].waiting = hadlate = true;
 		}
 	}
 }
@@ -76,6 +76,10 @@ void Net_SkipCommand (int type, uint8_t **stream);
 
 void Net_ClearBuffers ();
 
+// The other nodes of a -loopback game
+void Net_LoopbackReceive (int node, const uint8_t *data, int len);
+void Net_LoopbackUpdate (int node);
+
 
 // Netgame stuff (buffers and pointers, i.e. indices).
 
@@ -100,19 +104,23 @@ extern	int 			ticdup;
 //  One byte with following flags.
 //  One byte with starttic
 //  One byte with master's maketic (master -> slave only!)
-//  If NCMD_RETRANSMIT set, one byte with retransmitfrom
+//  One byte with the first tic the sender still needs from the receiver (acknowledges all before it)
 //  If NCMD_XTICS set, one byte with number of tics (minus 3, so theoretically up to 258 tics in one packet)
 //  If NCMD_QUITTERS, one byte with number of players followed by one byte with each player's consolenum
+//  One byte with the sender's network delay
 //  If NCMD_MULTI, one byte with number of players followed by one byte with each player's consolenum
 //     - The first player's consolenum is not included in this list, because it always matches the sender
 //
 // For each tic:
 //  Two bytes with consistancy check, followed by tic data
 //
+// Tics are sent from the last one the receiver acknowledged, so every packet
+// repeats whatever may have been lost since then.
+//
 // Setup packets are different, and are described just before D_ArbitrateNetStart().
 
 #define NCMD_EXIT				0x80
-#define NCMD_RETRANSMIT 		0x40
+#define NCMD_RANGECODED			0x40		// remainder of packet is range coded
 #define NCMD_SETUP				0x20
 #define NCMD_MULTI				0x10		// multiple players in this packet
 #define NCMD_QUITTERS			0x08		// one or more players just quit (packet server only)
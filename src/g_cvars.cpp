@@ -120,6 +120,12 @@ CUSTOM_CVAR (Int, cl_maxdecals, 1024, CVAR_ARCHIVE|CVAR_NOINITCALL)
 }
 
 
+// Limits the number of impact decals on a single wall. 0 means unlimited.
+CUSTOM_CVAR (Int, cl_maxwalldecals, 0, CVAR_ARCHIVE|CVAR_NOINITCALL)
+{
+	if (self < 0) self = 0;
+}
+
 // [BC] Allow the maximum number of particles to be specified by a cvar (so people
 // with lots of nice hardware can have lots of particles!).
 CUSTOM_CVAR(Int, r_maxparticles, 10000, CVAR_ARCHIVE | CVAR_NOINITCALL)
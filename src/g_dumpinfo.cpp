@@ -45,6 +45,9 @@
 #include "gstrings.h"
 #include "texturemanager.h"
 #include "d_main.h"
+#include "doomstat.h"
+#include "decallib.h"
+#include "stats.h"
 
 //==========================================================================
 //
@@ -121,6 +124,59 @@ CCMD (countdecals)
 	}
 }
 
+//==========================================================================
+//
+// CCMD benchdecals
+//
+// Sticks impact decals to the walls of the current level and reports the
+// time it took, to measure decal allocation and eviction costs.
+//
+//==========================================================================
+
+CCMD (benchdecals)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: benchdecals <decal> [count]\n");
+		return;
+	}
+	if (netgame || demorecording || gamestate != GS_LEVEL)
+	{
+		Printf("benchdecals can only be used in a single player game\n");
+		return;
+	}
+	const FDecalTemplate *tpl = DecalLibrary.GetDecalByName(argv[1]);
+	if (tpl == nullptr || (tpl = tpl->GetDecal()) == nullptr)
+	{
+		Printf("Unknown decal %s\n", argv[1]);
+		return;
+	}
+	int count = argv.argc() > 2 ? (int)strtol(argv[2], nullptr, 10) : 10000;
+	auto Level = primaryLevel;
+	unsigned numsides = Level->sides.Size();
+	if (numsides == 0 || count <= 0) return;
+
+	cycle_t clock;
+	clock.Reset();
+	clock.Clock();
+	int created = 0;
+	for (int i = 0; i < count; i++)
+	{
+		// Step through the walls with a large prime stride so that consecutive
+		// decals end up in different parts of the level.
+		side_t *side = &Level->sides[(unsigned)((i * 7919u) % numsides)];
+		line_t *line = side->linedef;
+		sector_t *sec = side->sector;
+		if (line == nullptr || sec == nullptr) continue;
+
+		double frac = ((i * 37) % 97 + 1) / 98.;
+		DVector3 pos(line->v1->fPos() + line->Delta() * frac, sec->floorplane.ZatPoint(line->v1) + 8 + (i % 16) * 4);
+		if (DImpactDecal::StaticCreate(Level, tpl, pos, side, nullptr) != nullptr) created++;
+	}
+	clock.Unclock();
+	Printf("Created %d of %d decals in %.3f ms, level counter is at %d\n", created, count, clock.TimeMS(), Level->ImpactDecalCount);
+}
+
 CCMD (spray)
 {
 	if (players[consoleplayer].mo == NULL || argv.argc() < 2)
@@ -110,6 +110,10 @@ void	G_DoWorldDone (void);
 void	G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description);
 void	G_DoAutoSave ();
 void	G_DoQuickSave ();
+void	G_DoDemoSeek (void);
+void	G_CheckDemoSnapshot (void);
+static void G_ClearDemoSnapshots (void);
+static void G_EndDemoSeek (void);
 
 void STAT_Serialize(FSerializer &file);
 
@@ -179,6 +183,8 @@ size_t			maxdemosize;
 uint8_t*			zdemformend;			// end of FORM ZDEM chunk
 uint8_t*			zdembodyend;			// end of ZDEM BODY chunk
 bool 			singledemo; 			// quit after playing a demo from cmdline 
+static int		DemoTic;				// tics played since the demo started
+static int		DemoSeekTarget = -1;	// tic demo_seek is running to
  
 bool 			precache = true;		// if true, load all graphics at start 
   
@@ -1221,6 +1227,9 @@ void G_Ticker ()
 			gamestate = GS_INTRO;
 			gameaction = ga_nothing;
 			break;
+		case ga_demoseek:
+			G_DoDemoSeek ();
+			break;
 
 
 
@@ -1231,6 +1240,11 @@ void G_Ticker ()
 		C_AdjustBottom ();
 	}
 
+	if (demoplayback && gamestate == GS_LEVEL)
+	{
+		G_CheckDemoSnapshot ();
+	}
+
 	// get commands, check consistancy, and build new consistancy check
 	int buf = (gametic/ticdup)%BACKUPTICS;
 
@@ -1340,6 +1354,15 @@ void G_Ticker ()
 
 	// [MK] Additional ticker for UI events right after all others
 	primaryLevel->localEventManager->PostUiTick();
+
+	if (demoplayback)
+	{
+		DemoTic++;
+		if (DemoSeekTarget >= 0 && DemoTic >= DemoSeekTarget)
+		{
+			G_EndDemoSeek ();
+		}
+	}
 }
 
 
@@ -1984,6 +2007,77 @@ void C_SerializeCVars(FSerializer& arc, const char* label, uint32_t filter)
 void SetupLoadingCVars();
 void FinishLoadingCVars();
 
+//==========================================================================
+//
+// Restores everything but the level snapshots, which must already have
+// been set up, and loads the current level.
+//
+//==========================================================================
+
+static void G_ReadGlobals(FSerializer &arc, const char *map)
+{
+	// Read intermission data for hubs
+	G_SerializeHub(arc);
+
+	primaryLevel->BotInfo.RemoveAllBots(primaryLevel, true);
+
+	savegamerestore = true;		// Use the player actors in the savegame
+
+	FString cvar;
+	arc("importantcvars", cvar);
+	if (!cvar.IsEmpty())
+	{
+		uint8_t *vars_p = (uint8_t *)cvar.GetChars();
+		C_ReadCVars(&vars_p);
+	}
+	else
+	{
+		C_SerializeCVars(arc, "servercvars", CVAR_SERVERINFO);
+	}
+
+	uint32_t time[2] = { 1,0 };
+
+	arc("ticrate", time[0])
+		("leveltime", time[1])
+		("globalfreeze", globalfreeze);
+	// dearchive all the modifications
+	level.time = Scale(time[1], TICRATE, time[0]);
+
+	G_ReadVisited(arc);
+
+	// load a base level
+	bool demoplaybacksave = demoplayback;
+	G_InitNew(map, false);
+	FinishLoadingCVars();
+	demoplayback = demoplaybacksave;
+	savegamerestore = false;
+
+	STAT_Serialize(arc);
+	FRandom::StaticReadRNGState(arc);
+	P_ReadACSDefereds(arc);
+	P_ReadACSVars(arc);
+
+	NextSkill = -1;
+	arc("nextskill", NextSkill);
+
+	if (level.info != nullptr)
+		level.info->Snapshot.Clean();
+
+	//Push any added models from A_ChangeModel
+	for (auto& smf : savedModelFiles)
+	{
+		FString modelFilePath = smf.Left(smf.LastIndexOf("/")+1);
+		FString modelFileName = smf.Right(smf.Len() - smf.Left(smf.LastIndexOf("/") + 1).Len());
+		FindModel(modelFilePath.GetChars(), modelFileName.GetChars());
+	}
+
+	// At this point, the GC threshold is likely a lot higher than the
+	// amount of memory in use, so bring it down now by starting a
+	// collection.
+	GC::StartCollection();
+}
+
+
 void G_DoLoadGame ()
 {
 	SetupLoadingCVars();
@@ -2095,69 +2189,11 @@ void G_DoLoadGame ()
 	}
 
 
-	// Read intermission data for hubs
-	G_SerializeHub(arc);
-
-	primaryLevel->BotInfo.RemoveAllBots(primaryLevel, true);
-
-	savegamerestore = true;		// Use the player actors in the savegame
-
-	FString cvar;
-	arc("importantcvars", cvar);
-	if (!cvar.IsEmpty())
-	{
-		uint8_t *vars_p = (uint8_t *)cvar.GetChars();
-		C_ReadCVars(&vars_p);
-	}
-	else
-	{
-		C_SerializeCVars(arc, "servercvars", CVAR_SERVERINFO);
-	}
-
-	uint32_t time[2] = { 1,0 };
-
-	arc("ticrate", time[0])
-		("leveltime", time[1])
-		("globalfreeze", globalfreeze);
-	// dearchive all the modifications
-	level.time = Scale(time[1], TICRATE, time[0]);
-
 	G_ReadSnapshots(resfile.get());
 	resfile.reset(nullptr);	// we no longer need the resource file below this point
-	G_ReadVisited(arc);
-
-	// load a base level
-	bool demoplaybacksave = demoplayback;
-	G_InitNew(map.GetChars(), false);
-	FinishLoadingCVars();
-	demoplayback = demoplaybacksave;
-	savegamerestore = false;
-
-	STAT_Serialize(arc);
-	FRandom::StaticReadRNGState(arc);
-	P_ReadACSDefereds(arc);
-	P_ReadACSVars(arc);
-
-	NextSkill = -1;
-	arc("nextskill", NextSkill);
-
-	if (level.info != nullptr)
-		level.info->Snapshot.Clean();
 
+	G_ReadGlobals(arc, map.GetChars());
 	BackupSaveName = savename;
-
-	//Push any added models from A_ChangeModel
-	for (auto& smf : savedModelFiles)
-	{
-		FString modelFilePath = smf.Left(smf.LastIndexOf("/")+1);
-		FString modelFileName = smf.Right(smf.Len() - smf.Left(smf.LastIndexOf("/") + 1).Len());
-		FindModel(modelFilePath.GetChars(), modelFileName.GetChars());
-	}
-
-	// At this point, the GC threshold is likely a lot higher than the
-	// amount of memory in use, so bring it down now by starting a
-	// collection.
-	GC::StartCollection();
 }
 
 
@@ -2332,6 +2368,38 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
+//==========================================================================
+//
+// Writes the non-level related information that savegames need.
+//
+//==========================================================================
+
+static void G_WriteGlobals(FSerializer &savegameglobals)
+{
+	// Intermission stats for hubs
+	G_SerializeHub(savegameglobals);
+	C_SerializeCVars(savegameglobals, "servercvars", CVAR_SERVERINFO);
+
+	if (level.time != 0 || level.maptime != 0)
+	{
+		int tic = TICRATE;
+		savegameglobals("ticrate", tic);
+		savegameglobals("leveltime", level.time);
+	}
+
+	STAT_Serialize(savegameglobals);
+	FRandom::StaticWriteRNGState(savegameglobals);
+	P_WriteACSDefereds(savegameglobals);
+	P_WriteACSVars(savegameglobals);
+	G_WriteVisited(savegameglobals);
+
+
+	if (NextSkill != -1)
+	{
+		savegameglobals("nextskill", NextSkill);
+	}
+}
+
 void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
 {
 	TArray<FCompressedBuffer> savegame_content;
@@ -2406,28 +2474,7 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	PutSaveWads (savegameinfo);
 	PutSaveComment (savegameinfo);
 
-	// Intermission stats for hubs
-	G_SerializeHub(savegameglobals);
-	C_SerializeCVars(savegameglobals, "servercvars", CVAR_SERVERINFO);
-
-	if (level.time != 0 || level.maptime != 0)
-	{
-		int tic = TICRATE;
-		savegameglobals("ticrate", tic);
-		savegameglobals("leveltime", level.time);
-	}
-
-	STAT_Serialize(savegameglobals);
-	FRandom::StaticWriteRNGState(savegameglobals);
-	P_WriteACSDefereds(savegameglobals);
-	P_WriteACSVars(savegameglobals);
-	G_WriteVisited(savegameglobals);
-
-
-	if (NextSkill != -1)
-	{
-		savegameglobals("nextskill", NextSkill);
-	}
+	G_WriteGlobals(savegameglobals);
 
 	auto picdata = savepic.GetBuffer();
 	FCompressedBuffer bufpng = { picdata->size(), picdata->size(), FileSys::METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->size())), (char*)&(*picdata)[0] };
@@ -2907,6 +2954,7 @@ void G_DoPlayDemo (void)
 		}
 	}
 	demo_p = demobuffer;
+	G_ClearDemoSnapshots ();
 
 	if (singledemo) Printf ("Playing demo %s\n", defdemoname.GetChars());
 
@@ -3001,6 +3049,7 @@ bool G_CheckDemoStatus (void)
 		C_RestoreCVars ();		// [RH] Restore cvars demo might have changed
 		M_Free (demobuffer);
 		demobuffer = NULL;
+		G_ClearDemoSnapshots ();
 
 		P_SetupWeapons_ntohton();
 		demoplayback = false;
@@ -3095,6 +3144,241 @@ bool G_CheckDemoStatus (void)
 	return false; 
 }
 
+//==========================================================================
+//
+// Demo seeking
+//
+// While a demo plays, the game state is archived in memory every few
+// seconds, the same way a savegame stores it. Seeking backwards restores
+// the last snapshot before the target, and then the demo runs with
+// uncapped tics until the target is reached. If there are more than
+// demo_maxsnapshots, every other one is dropped and the interval doubles,
+// so the snapshots always cover the whole demo.
+//
+// Snapshots cost time and memory, so they are off unless
+// demo_snapshotinterval is set, and never taken for timedemos.
+// Each snapshot also records the sum of the random seeds used for the
+// network consistency check. When a demo replayed after seeking backwards
+// reaches a snapshot's tic again, the sums are compared to catch a restore
+// that did not bring back the exact game state.
+//
+//==========================================================================
+
+CVAR(Int, demo_snapshotinterval, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// in seconds, 0 disables snapshots and rewinding
+CVAR(Int, demo_maxsnapshots, 32, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+struct FDemoSnapshot
+{
+	int Tic;
+	uint32_t RNGSum;
+	ptrdiff_t DemoPos;
+	FString MapName;
+	FCompressedBuffer Globals = {};
+	TArray<FString> LevelNames;
+	TArray<FCompressedBuffer> Levels;
+
+	void Clean()
+	{
+		Globals.Clean();
+		for (auto &buffer : Levels)
+			buffer.Clean();
+	}
+};
+
+static TArray<FDemoSnapshot> DemoSnapshots;
+static int DemoSnapshotSpacing;
+static bool DemoSnapshotFailed;
+static int DemoSeekSnapshot = -1;
+static bool DemoSeekSingleTics;
+
+static void G_ClearDemoSnapshots ()
+{
+	for (auto &snapshot : DemoSnapshots)
+		snapshot.Clean();
+	DemoSnapshots.Clear();
+	DemoSnapshotSpacing = demo_snapshotinterval * TICRATE;
+	DemoSnapshotFailed = false;
+	DemoTic = 0;
+	if (DemoSeekTarget >= 0)
+	{
+		G_EndDemoSeek ();
+	}
+}
+
+void G_CheckDemoSnapshot ()
+{
+	if (demo_snapshotinterval <= 0 || DemoSnapshotFailed || demorecording || timingdemo)
+		return;
+
+	if (DemoSnapshots.Size() > 0 && DemoTic <= DemoSnapshots.Last().Tic)
+	{
+		// This part of the demo was played before, so check that it plays out the same way.
+		for (auto &snapshot : DemoSnapshots)
+		{
+			if (snapshot.Tic == DemoTic && snapshot.RNGSum != StaticSumSeeds())
+			{
+				Printf(PRINT_HIGH, "Demo is out of sync at tic %d after seeking\n", DemoTic);
+				break;
+			}
+		}
+		return;
+	}
+
+	// The interval may have been 0 when the demo started.
+	if (DemoSnapshotSpacing <= 0)
+		DemoSnapshotSpacing = demo_snapshotinterval * TICRATE;
+
+	if (DemoSnapshots.Size() > 0 && DemoTic < DemoSnapshots.Last().Tic + DemoSnapshotSpacing)
+		return;
+
+	insave = true;
+	try
+	{
+		level.SnapshotLevel();
+	}
+	catch (CRecoverableError &err)
+	{
+		insave = false;
+		level.info->Snapshot.Clean();
+		Printf(PRINT_HIGH, "Demo snapshot failed: %s\n", err.GetMessage());
+		DemoSnapshotFailed = true;
+		return;
+	}
+
+	FDemoSnapshot &snapshot = DemoSnapshots[DemoSnapshots.Reserve(1)];
+	snapshot.Tic = DemoTic;
+	snapshot.RNGSum = StaticSumSeeds();
+	snapshot.DemoPos = demo_p - demobuffer;
+	snapshot.MapName = primaryLevel->MapName;
+
+	FSerializer globals;
+	globals.OpenWriter(false);
+	G_WriteGlobals(globals);
+	snapshot.Globals = globals.GetCompressedOutput();
+
+	// The level snapshots are owned by the level infos, so they must be copied.
+	TArray<FCompressedBuffer> levels;
+	G_WriteSnapshots(snapshot.LevelNames, levels);
+	for (auto &buffer : levels)
+	{
+		FCompressedBuffer &copy = snapshot.Levels[snapshot.Levels.Push(buffer)];
+		copy.mBuffer = new char[buffer.mCompressedSize];
+		memcpy(copy.mBuffer, buffer.mBuffer, buffer.mCompressedSize);
+	}
+	level.info->Snapshot.Clean();
+	insave = false;
+
+	if (DemoSnapshots.Size() > (unsigned)max(*demo_maxsnapshots, 2))
+	{
+		// The first one is always kept so that the start of the demo can be reached.
+		for (unsigned i = 1; i < DemoSnapshots.Size(); i++)
+		{
+			DemoSnapshots[i].Clean();
+			DemoSnapshots.Delete(i);
+		}
+		DemoSnapshotSpacing *= 2;
+	}
+}
+
+void G_DoDemoSeek ()
+{
+	gameaction = ga_nothing;
+	if (!demoplayback || DemoSeekSnapshot < 0)
+		return;
+
+	FDemoSnapshot &snapshot = DemoSnapshots[DemoSeekSnapshot];
+	DemoSeekSnapshot = -1;
+
+	FSerializer arc;
+	if (!arc.OpenReader(&snapshot.Globals))
+	{
+		Printf(PRINT_HIGH, "Failed to restore demo snapshot\n");
+		G_EndDemoSeek ();
+		return;
+	}
+
+	SetupLoadingCVars();
+	G_ReadSnapshots(snapshot.LevelNames, snapshot.Levels);
+	precache = false;
+	G_ReadGlobals(arc, snapshot.MapName.GetChars());
+	precache = true;
+	usergame = false;
+
+	demo_p = demobuffer + snapshot.DemoPos;
+	DemoTic = snapshot.Tic;
+	if (DemoTic >= DemoSeekTarget)
+	{
+		G_EndDemoSeek ();
+	}
+}
+
+static void G_DemoSeek (int tic)
+{
+	if (!demoplayback)
+	{
+		Printf("Not playing a demo\n");
+		return;
+	}
+
+	tic = max(tic, 0);
+	if (tic == DemoTic)
+		return;
+
+	if (tic < DemoTic)
+	{
+		int best = -1;
+		for (unsigned i = 0; i < DemoSnapshots.Size() && DemoSnapshots[i].Tic <= tic; i++)
+		{
+			best = i;
+		}
+		if (best < 0)
+		{
+			Printf("There is no demo snapshot before tic %d\n", tic);
+			return;
+		}
+		DemoSeekSnapshot = best;
+		gameaction = ga_demoseek;
+	}
+
+	if (DemoSeekTarget < 0)
+	{
+		DemoSeekSingleTics = singletics;
+	}
+	DemoSeekTarget = tic;
+	singletics = true;
+}
+
+static void G_EndDemoSeek ()
+{
+	DemoSeekTarget = -1;
+	singletics = DemoSeekSingleTics;
+}
+
+bool G_IsDemoSeeking ()
+{
+	return DemoSeekTarget >= 0;
+}
+
+CCMD (demo_seek)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: demo_seek <tic>\n");
+		if (demoplayback)
+		{
+			Printf("Current tic: %d\n", DemoTic);
+		}
+		return;
+	}
+	G_DemoSeek(atoi(argv[1]));
+}
+
+CCMD (demo_rewind)
+{
+	int seconds = argv.argc() > 1 ? atoi(argv[1]) : 10;
+	G_DemoSeek(DemoTic - seconds * TICRATE);
+}
+
 void G_StartSlideshow(FLevelLocals *Level, FName whichone)
 {
 	auto SelectedSlideshow = whichone == NAME_None ? Level->info->slideshow : whichone;
@@ -76,6 +76,7 @@ void G_BeginRecording (const char *startmap);
 void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
 bool G_CheckDemoStatus (void);
+bool G_IsDemoSeeking (void);
 
 void G_Ticker (void);
 bool G_Responder (event_t*	ev);
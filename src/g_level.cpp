@@ -2003,36 +2003,55 @@ void G_WriteVisited(FSerializer &arc)
 //
 //==========================================================================
 
-void G_ReadSnapshots(FResourceFile *resf)
+static level_info_t *SnapshotLevelInfo(const char *name)
 {
-	FString MapName;
-	level_info_t *i;
+	auto ptr = strstr(name, ".map.json");
+	if (ptr != nullptr)
+	{
+		ptrdiff_t maplen = ptr - name;
+		FString mapname(name, (size_t)maplen);
+		return FindLevelInfo(mapname.GetChars());
+	}
+	else if (strstr(name, ".mapd.json") != nullptr)
+	{
+		return &TheDefaultLevelInfo;
+	}
+	return nullptr;
+}
 
+void G_ReadSnapshots(FResourceFile *resf)
+{
 	G_ClearSnapshots();
 
 	for (unsigned j = 0; j < resf->EntryCount(); j++)
 	{
-		auto name = resf->getName(j);
-		auto ptr = strstr(name, ".map.json");
-		if (ptr != nullptr)
+		level_info_t *i = SnapshotLevelInfo(resf->getName(j));
+		if (i != nullptr)
 		{
-			ptrdiff_t maplen = ptr - name;
-			FString mapname(name, (size_t)maplen);
-			i = FindLevelInfo(mapname.GetChars());
-			if (i != nullptr)
-			{
-				i->Snapshot = resf->GetRawData(j);
-			}
+			i->Snapshot = resf->GetRawData(j);
 		}
-		else
+	}
+}
+
+//==========================================================================
+//
+// Same for snapshots that were collected by G_WriteSnapshots and kept
+// in memory. The buffers are copied.
+//
+//==========================================================================
+
+void G_ReadSnapshots(const TArray<FString> &filenames, const TArray<FCompressedBuffer> &buffers)
+{
+	G_ClearSnapshots();
+
+	for (unsigned j = 0; j < filenames.Size(); j++)
+	{
+		level_info_t *i = SnapshotLevelInfo(filenames[j].GetChars());
+		if (i != nullptr)
 		{
-			auto ptr = strstr(name, ".mapd.json");
-			if (ptr != nullptr)
-			{
-				ptrdiff_t maplen = ptr - name;
-				FString mapname(name, (size_t)maplen);
-				TheDefaultLevelInfo.Snapshot = resf->GetRawData(j);
-			}
+			i->Snapshot = buffers[j];
+			i->Snapshot.mBuffer = new char[buffers[j].mCompressedSize];
+			memcpy(i->Snapshot.mBuffer, buffers[j].mBuffer, buffers[j].mCompressedSize);
 		}
 	}
 }
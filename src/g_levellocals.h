@@ -160,6 +160,7 @@ private:
 	void CollectLinkedPortals();
 	void CreateLinkedPortals();
 	bool ChangePortalLine(line_t *line, int destid);
+	void InvalidateActorSectorLists();
 	void AddDisplacementForPortal(FSectorPortal *portal);
 	void AddDisplacementForPortal(FLinePortal *portal);
 	bool ConnectPortalGroups();
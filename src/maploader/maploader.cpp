@@ -86,6 +86,7 @@
 #include "version.h"
 
 #include "common/utility/halffloat.h"
+#include "workerpool.h"
 
 enum
 {
@@ -95,6 +96,7 @@ enum
 CVAR (Bool, genblockmap, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, genlightmaps, false, CVAR_GLOBALCONFIG);
+CVAR (Bool, showloadtimes, false, 0);
 
 inline bool P_LoadBuildMap(uint8_t *mapdata, size_t len, FMapThing **things, int *numthings)
 {
@@ -2320,7 +2322,21 @@ static void CreatePackedBlockmap (TArray<int> &BlockMap, TArray<int> *blocks, in
 }
 
 
-void MapLoader::CreateBlockMap ()
+//===========================================================================
+//
+// BuildBlockMap
+//
+// Only works on a copy of the line positions so that it can run on a
+// worker thread while the node builder is busy with the actual level data.
+//
+//===========================================================================
+
+struct FBlockmapLine
+{
+	int x1, y1, x2, y2;
+};
+
+static TArray<int> BuildBlockMap (const TArray<FBlockmapLine> &lines, int minx, int miny, int maxx, int maxy)
 {
 	enum
 	{
@@ -2332,30 +2348,8 @@ void MapLoader::CreateBlockMap ()
 	TArray<TArray<int>> BlockLists;
 	int adder;
 	int bmapwidth, bmapheight;
-	double dminx, dmaxx, dminy, dmaxy;
-	int minx, maxx, miny, maxy;
 	int line;
 
-	if (Level->vertexes.Size() == 0)
-		return;
-
-	// Find map extents for the blockmap
-	dminx = dmaxx = Level->vertexes[0].fX();
-	dminy = dmaxy = Level->vertexes[0].fY();
-
-	for (auto &vert : Level->vertexes)
-	{
-			 if (vert.fX() < dminx) dminx = vert.fX();
-		else if (vert.fX() > dmaxx) dmaxx = vert.fX();
-			 if (vert.fY() < dminy) dminy = vert.fY();
-		else if (vert.fY() > dmaxy) dmaxy = vert.fY();
-	}
-
-	minx = int(dminx);
-	miny = int(dminy);
-	maxx = int(dmaxx);
-	maxy = int(dmaxy);
-
 	bmapwidth =	 ((maxx - minx) >> BLOCKBITS) + 1;
 	bmapheight = ((maxy - miny) >> BLOCKBITS) + 1;
 
@@ -2368,12 +2362,12 @@ void MapLoader::CreateBlockMap ()
 
 	BlockLists.Resize(bmapwidth * bmapheight);
 
-	for (line = 0; line < (int)Level->lines.Size(); ++line)
+	for (line = 0; line < (int)lines.Size(); ++line)
 	{
-		int x1 = int(Level->lines[line].v1->fX());
-		int y1 = int(Level->lines[line].v1->fY());
-		int x2 = int(Level->lines[line].v2->fX());
-		int y2 = int(Level->lines[line].v2->fY());
+		int x1 = lines[line].x1;
+		int y1 = lines[line].y1;
+		int x2 = lines[line].x2;
+		int y2 = lines[line].y2;
 		int dx = x2 - x1;
 		int dy = y2 - y1;
 		int bx = (x1 - minx) >> BLOCKBITS;
@@ -2486,12 +2480,43 @@ void MapLoader::CreateBlockMap ()
 
 	BlockMap.Reserve (bmapwidth * bmapheight);
 	CreatePackedBlockmap (BlockMap, BlockLists.Data(), bmapwidth, bmapheight);
+	return BlockMap;
+}
 
-	Level->blockmap.blockmaplump = new int[BlockMap.Size()];
-	for (unsigned int ii = 0; ii < BlockMap.Size(); ++ii)
+void MapLoader::CreateBlockMap ()
+{
+	// LoadLevel may already have built it in the background.
+	if (GeneratedBlockMap.Size() == 0)
 	{
-		Level->blockmap.blockmaplump[ii] = BlockMap[ii];
+		double dminx, dmaxx, dminy, dmaxy;
+
+		if (Level->vertexes.Size() == 0)
+			return;
+
+		// Find map extents for the blockmap
+		dminx = dmaxx = Level->vertexes[0].fX();
+		dminy = dmaxy = Level->vertexes[0].fY();
+
+		for (auto &vert : Level->vertexes)
+		{
+				 if (vert.fX() < dminx) dminx = vert.fX();
+			else if (vert.fX() > dmaxx) dmaxx = vert.fX();
+				 if (vert.fY() < dminy) dminy = vert.fY();
+			else if (vert.fY() > dmaxy) dmaxy = vert.fY();
+		}
+
+		TArray<FBlockmapLine> lines(Level->lines.Size(), true);
+		for (unsigned i = 0; i < Level->lines.Size(); ++i)
+		{
+			auto &ld = Level->lines[i];
+			lines[i] = { int(ld.v1->fX()), int(ld.v1->fY()), int(ld.v2->fX()), int(ld.v2->fY()) };
+		}
+		GeneratedBlockMap = BuildBlockMap(lines, int(dminx), int(dminy), int(dmaxx), int(dmaxy));
 	}
+
+	Level->blockmap.blockmaplump = new int[GeneratedBlockMap.Size()];
+	memcpy(Level->blockmap.blockmaplump, GeneratedBlockMap.Data(), GeneratedBlockMap.Size() * sizeof(int));
+	GeneratedBlockMap.Reset();
 }
 
 
@@ -3094,9 +3119,8 @@ bool MapLoader::LoadLightmap(MapData* map)
 	auto submesh = Level->levelMesh->StaticMesh.get();
 	const auto textureSize = submesh->LMTextureSize;
 
-	// Start with empty lightmap textures
-	submesh->LMTextureData.Resize(submesh->LMTextureCount * textureSize * textureSize * 3);
-	memset(submesh->LMTextureData.Data(), 0, submesh->LMTextureData.Size() * sizeof(uint16_t));
+	// The pixels are kept packed per tile. The backend clears the atlas and only uploads the baked tiles.
+	submesh->LMBakedTiles.Clear();
 
 	// Create lookup for finding tiles
 	std::map<LightmapTileBinding, LightmapTile*> levelTiles;
@@ -3134,27 +3158,38 @@ bool MapLoader::LoadLightmap(MapData* map)
 			continue;
 		}
 
-		const uint16_t* src = textureData.Data() + entry.pixelsOffset;
-		uint16_t* dst = &submesh->LMTextureData[tile->AtlasLocation.ArrayIndex * textureSize * textureSize * 3];
-
-		int x = tile->AtlasLocation.X;
-		int y = tile->AtlasLocation.Y;
-		int w = tile->AtlasLocation.Width;
-		int h = tile->AtlasLocation.Height;
-
-		for (int yy = 0; yy < w; yy++)
+		if ((size_t)entry.pixelsOffset + (size_t)entry.width * entry.height * 3 > textureData.Size())
 		{
-			const uint16_t* srcline = src + yy * w * 3;
-			uint16_t* dstline = dst + (x + yy * textureSize) * 3;
-			for (int xx = 0, end = w * 3; xx < end; xx++)
-			{
-				dstline[xx] = srcline[xx];
-			}
+			if (errors < 10 && developer >= 1)
+				Printf("Lightmap tile pixels out of bounds (type = %d, index = %d, control sector = %d)\n", entry.type, entry.typeIndex, entry.controlSector);
+			errors++;
+			continue;
 		}
 
+		LightmapTileUpload upload;
+		upload.X = tile->AtlasLocation.X;
+		upload.Y = tile->AtlasLocation.Y;
+		upload.Width = tile->AtlasLocation.Width;
+		upload.Height = tile->AtlasLocation.Height;
+		upload.ArrayIndex = tile->AtlasLocation.ArrayIndex;
+		upload.PixelsOffset = entry.pixelsOffset;
+		submesh->LMBakedTiles.Push(upload);
+
 		tile->NeedsUpdate = false;
 	}
 
+	submesh->LMTilePixels = std::move(textureData);
+
+	if (developer >= 1)
+	{
+		uint64_t atlasBytes = (uint64_t)submesh->LMTextureCount * textureSize * textureSize * 4 * sizeof(uint16_t);
+		uint64_t tileBytes = 0;
+		for (const LightmapTileUpload& upload : submesh->LMBakedTiles)
+			tileBytes += (uint64_t)upload.Width * upload.Height * 4 * sizeof(uint16_t);
+		Printf("Lightmap: %u of %u tiles baked, uploading %.1f MB of tile data into a %.1f MB atlas\n",
+			submesh->LMBakedTiles.Size(), submesh->LightmapTiles.Size(), tileBytes / (1024.0 * 1024.0), atlasBytes / (1024.0 * 1024.0));
+	}
+
 	if (errors > 0)
 	{
 		if (developer <= 0)
@@ -3166,6 +3201,38 @@ bool MapLoader::LoadLightmap(MapData* map)
 	return true;
 }
 
+//===========================================================================
+//
+// Per-stage timing of LoadLevel for 'showloadtimes'
+//
+//===========================================================================
+
+struct FLoadStageTimes
+{
+	uint64_t Start = I_nsTime();
+	uint64_t Last = Start;
+	TArray<std::pair<const char *, double>> Stages;
+
+	void Mark(const char *name)
+	{
+		uint64_t now = I_nsTime();
+		Stages.Push({ name, (now - Last) / 1e6 });
+		Last = now;
+	}
+
+	void Print(double blockmaptime, double aabbtime)
+	{
+		if (!showloadtimes) return;
+		Printf("Map loading took %.2f ms:\n", (Last - Start) / 1e6);
+		for (auto &stage : Stages)
+		{
+			Printf("  %-24s %8.2f ms\n", stage.first, stage.second);
+		}
+		if (blockmaptime >= 0) Printf("  %-24s %8.2f ms (background)\n", "blockmap", blockmaptime);
+		if (aabbtime >= 0) Printf("  %-24s %8.2f ms (background)\n", "AABB tree", aabbtime);
+	}
+};
+
 //==========================================================================
 //
 //
@@ -3175,6 +3242,13 @@ bool MapLoader::LoadLightmap(MapData* map)
 void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 {
 	const int *oldvertextable  = nullptr;
+	FLoadStageTimes times;
+	double blockmaptime = -1, aabbtime = -1;
+
+	// Runs the stages that only depend on finished data while the main thread continues.
+	// The tasks return how long they took along with their result.
+	TWorkerTask<std::pair<TArray<int>, double>> blockmaptask;
+	TWorkerTask<std::pair<std::unique_ptr<DoomLevelAABBTree>, double>> aabbtask;
 
 	// Reset defaults for lightmapping
 	Level->SunColor = FVector3(1.f, 1.f, 1.f);
@@ -3245,6 +3319,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 
 	LoadStrifeConversations(map, lumpname);
+	times.Mark("scripts");
 
 	FMissingTextureTracker missingtex;
 
@@ -3280,6 +3355,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	LoopSidedefs(true);
 
 	SummarizeMissingTextures(missingtex);
+	times.Mark("map data");
 	bool reloop = false;
 
 	if (!ForceNodeBuild)
@@ -3363,6 +3439,31 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 			line.AdjustLine();
 		}
 
+		// A rebuild always regenerates the blockmap, and that only needs the line positions.
+		// Build it from a copy while the node builder works on the real data. The node builder
+		// stores its vertices as fixed point, so the copy has to be converted the same way.
+		if (Level->lines.Size() > 0)
+		{
+			TArray<FBlockmapLine> bmlines(Level->lines.Size(), true);
+			int minx = INT_MAX, miny = INT_MAX, maxx = INT_MIN, maxy = INT_MIN;
+			for (unsigned i = 0; i < Level->lines.Size(); ++i)
+			{
+				auto &ld = Level->lines[i];
+				auto &bl = bmlines[i];
+				bl = { int(ld.v1->fixX() / 65536.), int(ld.v1->fixY() / 65536.), int(ld.v2->fixX() / 65536.), int(ld.v2->fixY() / 65536.) };
+				minx = min(minx, min(bl.x1, bl.x2));
+				miny = min(miny, min(bl.y1, bl.y2));
+				maxx = max(maxx, max(bl.x1, bl.x2));
+				maxy = max(maxy, max(bl.y1, bl.y2));
+			}
+			blockmaptask = WorkerPool().push([bmlines = std::move(bmlines), minx, miny, maxx, maxy](int id)
+			{
+				uint64_t start = I_nsTime();
+				auto blockmap = BuildBlockMap(bmlines, minx, miny, maxx, maxy);
+				return std::make_pair(std::move(blockmap), (I_nsTime() - start) / 1e6);
+			});
+		}
+
 		startTime = I_msTime();
 		TArray<FNodeBuilder::FPolyStart> polyspots, anchors;
 		GetPolySpots(map, polyspots, anchors);
@@ -3413,8 +3514,16 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	
 	// set the head node for gameplay purposes. If the separate gamenodes array is not empty, use that, otherwise use the render nodes.
 	Level->headgamenode = Level->gamenodes.Size() > 0 ? &Level->gamenodes[Level->gamenodes.Size() - 1] : Level->nodes.Size() ? &Level->nodes[Level->nodes.Size() - 1] : nullptr;
+	times.Mark("nodes");
 
+	if (blockmaptask.Valid())
+	{
+		auto result = blockmaptask.Get();
+		GeneratedBlockMap = std::move(result.first);
+		blockmaptime = result.second;
+	}
 	LoadBlockMap(map);
+	times.Mark("blockmap");
 
 	LoadReject(map, false);
 	GroupLines(false);
@@ -3425,6 +3534,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	// Create the item indices, after the last function which may change the data has run.
 	CalcIndices();
+	times.Mark("reject and grouping");
 
 	Level->bodyqueslot = 0;
 	// phares 8/10/98: Clear body queue so the corpses from previous games are
@@ -3474,6 +3584,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 		double fdy = FIXED2DBL(node.dy);
 		node.len = (float)g_sqrt(fdx * fdx + fdy * fdy);
 	}
+	times.Mark("things and specials");
 
 	InitRenderInfo();				// create hardware independent renderer resources for the level. This must be done BEFORE the PolyObj Spawn!!!
 
@@ -3485,8 +3596,18 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	PO_Init();				// Initialize the polyobjs
 	if (!Level->IsReentering())
 		Level->FinalizePortals();	// finalize line portals after polyobjects have been initialized. This info is needed for properly flagging them.
+	times.Mark("render setup");
+
+	// The line positions are final now. The remaining stages do not touch them.
+	aabbtask = WorkerPool().push([level = Level](int id)
+	{
+		uint64_t start = I_nsTime();
+		auto tree = std::make_unique<DoomLevelAABBTree>(level);
+		return std::make_pair(std::move(tree), (I_nsTime() - start) / 1e6);
+	});
 
 	InitLevelMesh(map);
+	times.Mark("level mesh");
 
 	Level->ClearDynamic3DFloorData();	// CreateVBO must be run on the plain 3D floor data.
 	CreateVBO(*screen->RenderState(), Level->sectors);
@@ -3494,6 +3615,11 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	{
 		P_Recalculate3DFloors(&sec);
 	}
+	times.Mark("vertex buffers");
 
-	Level->aabbTree = new DoomLevelAABBTree(Level);
+	auto aabbresult = aabbtask.Get();
+	Level->aabbTree = aabbresult.first.release();
+	aabbtime = aabbresult.second;
+	times.Mark("AABB tree");
+	times.Print(blockmaptime, aabbtime);
 }
@@ -130,6 +130,9 @@ private:
 	// Polyobject init
 	TArray<int32_t> KnownPolySides;
 
+	// Blockmap that was built in parallel with the nodes
+	TArray<int> GeneratedBlockMap;
+
 	FName CheckCompatibility(MapData *map);
 	void PostProcessLevel(FName checksum);
 
@@ -54,6 +54,8 @@
 #include "texturemanager.h"
 #include "a_scroll.h"
 #include "p_spec_thinkers.h"
+#include "c_dispatch.h"
+#include "stats.h"
 
 //===========================================================================
 //
@@ -155,6 +157,236 @@ namespace
 //
 //===========================================================================
 
+//===========================================================================
+//
+// FUDMFScanner
+//
+// The UDMF parsers spend most of their time on the tokens of 'key = value;'
+// lines. For the plain forms (identifiers as keys, decimal integers, floats,
+// strings without escape sequences and booleans) these functions work
+// directly on the script buffer and leave the scanner in exactly the state
+// the generic token-by-token parse would produce. For anything else they
+// return without moving, and the generic scanner deals with it and prints
+// the proper errors.
+//
+//===========================================================================
+
+static inline bool UDMFIsDigit(char c) { return c >= '0' && c <= '9'; }
+static inline bool UDMFIsIdentChar(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || UDMFIsDigit(c); }
+
+// Skips whitespace and comments. The buffer always ends with a '\n' and is null terminated, so looking one character ahead is safe.
+bool FUDMFScanner::SkipWhitespace(const char *&p, int &line, bool &crossed)
+{
+	const char *end = ScriptEndPtr;
+	while (p < end)
+	{
+		if (*p == ' ' || *p == '\t' || *p == '\r')
+		{
+			p++;
+		}
+		else if (*p == '\n')
+		{
+			line++;
+			crossed = true;
+			p++;
+		}
+		else if (p[0] == '/' && p[1] == '/')
+		{
+			while (p < end && *p != '\n') p++;
+		}
+		else if (p[0] == '/' && p[1] == '*')
+		{
+			for (p += 2; p < end && !(p[0] == '*' && p[1] == '/'); p++)
+			{
+				if (*p == '\n')
+				{
+					line++;
+					crossed = true;
+				}
+			}
+			if (p >= end) return false;
+			p += 2;
+		}
+		else return true;
+	}
+	return false;
+}
+
+//===========================================================================
+//
+// Same as CheckToken('}'), but reads the key that usually follows directly.
+//
+//===========================================================================
+
+bool FUDMFScanner::CheckBlockEnd()
+{
+	if (!FastPath || !ScriptOpen || AlreadyGot) return CheckToken('}');
+
+	const char *p = ScriptPtr;
+	int line = Line;
+	bool crossed = false;
+	if (!SkipWhitespace(p, line, crossed) || (*p >= '0' && *p <= '9') || !UDMFIsIdentChar(*p)) return CheckToken('}');
+
+	const char *start = p;
+	while (UDMFIsIdentChar(*p)) p++;
+	int len = int(p - start);
+	if (len >= MAX_STRING_SIZE) return CheckToken('}');
+
+	// Commit as if the key had been read by GetToken and then ungot.
+	LastGotPtr = ScriptPtr;
+	LastGotLine = Line;
+	LastGotToken = true;
+	AlreadyGot = true;
+	AlreadyGotLine = LastGotLine;
+	ScriptPtr = p;
+	Line = line;
+	Crossed = crossed;
+	ParseError = false;
+	memcpy(StringBuffer, start, len);
+	StringBuffer[len] = 0;
+	String = StringBuffer;
+	StringLen = len;
+	TokenType = TK_Identifier;
+	return false;
+}
+
+//===========================================================================
+//
+// Parses the '= value ;' part of a key.
+//
+//===========================================================================
+
+bool FUDMFScanner::GetAssignedValue(FString &stringvalue)
+{
+	if (!FastPath || !ScriptOpen) return false;
+
+	const char *p = ScriptPtr;
+	const char *end = ScriptEndPtr;
+	int line = Line;
+	bool crossed = false;
+	auto skip = [&]() { return SkipWhitespace(p, line, crossed); };
+
+	if (AlreadyGot)
+	{
+		// ParseKey's check for a block start ungot the '=' token.
+		if (!LastGotToken || TokenType != '=') return false;
+	}
+	else
+	{
+		if (!skip() || *p != '=') return false;
+		p++;
+	}
+
+	if (!skip()) return false;
+	bool neg = false;
+	if (*p == '+' || *p == '-')
+	{
+		neg = *p == '-';
+		p++;
+		if (!skip() || !UDMFIsDigit(*p)) return false;
+	}
+
+	int tokentype;
+	int number = 0;
+	int64_t bignumber = BigNumber;
+	double flt = 0;
+	const char *strstart = nullptr;
+
+	if (UDMFIsDigit(*p))
+	{
+		const char *start = p;
+		// Octal and hexadecimal constants go through the generic path.
+		if (p[0] == '0' && (UDMFIsDigit(p[1]) || p[1] == 'x' || p[1] == 'X')) return false;
+
+		while (UDMFIsDigit(*p)) p++;
+		bool isfloat = false;
+		if (*p == '.')
+		{
+			isfloat = true;
+			p++;
+			while (UDMFIsDigit(*p)) p++;
+		}
+		if (*p == 'e' || *p == 'E')
+		{
+			const char *e = p + 1;
+			if (*e == '+' || *e == '-') e++;
+			if (!UDMFIsDigit(*e)) return false;
+			isfloat = true;
+			p = e;
+			while (UDMFIsDigit(*p)) p++;
+		}
+		// Type suffixes and other oddities
+		if (UDMFIsIdentChar(*p) || *p == '.') return false;
+
+		if (isfloat)
+		{
+			tokentype = TK_FloatConst;
+			flt = strtod(start, nullptr);
+		}
+		else
+		{
+			// Values that may overflow are left to strtoll.
+			if (p - start > 9) return false;
+			bignumber = 0;
+			for (const char *c = start; c < p; c++) bignumber = bignumber * 10 + (*c - '0');
+			tokentype = TK_IntConst;
+			number = (int)bignumber;
+			flt = number;
+		}
+		if (neg)
+		{
+			number = -number;
+			flt = -flt;
+		}
+	}
+	else if (*p == '"')
+	{
+		strstart = ++p;
+		while (p < end && *p != '"')
+		{
+			if (*p == '\\' || *p == '\n' || *p == 0) return false;
+			p++;
+		}
+		if (p >= end) return false;
+		p++;
+		tokentype = TK_StringConst;
+	}
+	else if (UDMFIsIdentChar(*p))
+	{
+		const char *start = p;
+		while (UDMFIsIdentChar(*p)) p++;
+		if (p - start == 4 && !strnicmp(start, "true", 4)) tokentype = TK_True;
+		else if (p - start == 5 && !strnicmp(start, "false", 5)) tokentype = TK_False;
+		else return false;
+	}
+	else return false;
+
+	const char *valueend = p;
+	int valueline = line;
+	crossed = false;
+	if (!skip() || *p != ';') return false;
+
+	// Commit everything as if the ';' had just been read by GetToken.
+	if (strstart) stringvalue = FString(strstart, valueend - 1 - strstart);
+	AlreadyGot = false;
+	LastGotToken = true;
+	LastGotPtr = valueend;
+	LastGotLine = valueline;
+	ScriptPtr = p + 1;
+	Line = line;
+	Crossed = crossed;
+	ParseError = false;
+	StringBuffer[0] = ';';
+	StringBuffer[1] = 0;
+	String = StringBuffer;
+	StringLen = 1;
+	TokenType = tokentype;
+	Number = number;
+	BigNumber = bignumber;
+	Float = flt;
+	return true;
+}
+
 //===========================================================================
 //
 // Skip a key or block
@@ -214,6 +446,10 @@ FName UDMFParserBase::ParseKey(bool checkblock, bool *isblock)
 		}
 		else if (isblock) *isblock = false;
 	}
+	if (sc.GetAssignedValue(parsedString))
+	{
+		return key;
+	}
 	sc.MustGetToken('=');
 
 	sc.Number = 0;
@@ -519,7 +755,7 @@ public:
 		th->Health = 1;
 		th->FloatbobPhase = -1;
 		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		while (!sc.CheckBlockEnd())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -899,7 +1135,7 @@ public:
 		if (Level->flags2 & LEVEL2_CHECKSWITCHRANGE) ld->flags |= ML_CHECKSWITCHRANGE;
 
 		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		while (!sc.CheckBlockEnd())
 		{
 			FName key = ParseKey();
 
@@ -1300,7 +1536,7 @@ public:
 		sd->UDMFIndex = index;
 
 		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		while (!sc.CheckBlockEnd())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -1734,7 +1970,7 @@ public:
 		sec->movefactor = ORIG_FRICTION_FACTOR;
 
 		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		while (!sc.CheckBlockEnd())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -2379,7 +2615,7 @@ public:
 
 		sc.MustGetToken('{');
 		double x = 0, y = 0;
-		while (!sc.CheckToken('}'))
+		while (!sc.CheckBlockEnd())
 		{
 			FName key = ParseKey();
 			switch (key.GetIndex())
@@ -2714,3 +2950,101 @@ void MapLoader::ParseTextMap(MapData *map, FMissingTextureTracker &missingtex)
 
 	parse.ParseTextMap(map);
 }
+
+//===========================================================================
+//
+// Measures the TEXTMAP key/value parsing with and without the fast path
+// and checks that both return the same values.
+//
+//===========================================================================
+
+class UDMFBenchParser : public UDMFParserBase
+{
+public:
+	uint64_t Run(MapData *map, bool fastpath, int &numkeys)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&](const void *data, size_t size)
+		{
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ ((const uint8_t*)data)[i]) * 1099511628211ull;
+			}
+		};
+		auto mixkey = [&](FName key)
+		{
+			int index = key.GetIndex();
+			mix(&index, sizeof(index));
+			mix(&sc.TokenType, sizeof(sc.TokenType));
+			mix(&sc.Number, sizeof(sc.Number));
+			mix(&sc.Float, sizeof(sc.Float));
+			if (sc.TokenType == TK_StringConst) mix(parsedString.GetChars(), parsedString.Len());
+			mix(&sc.Line, sizeof(sc.Line));
+			numkeys++;
+		};
+
+		numkeys = 0;
+		sc.OpenMem(fileSystem.GetFileFullName(map->lumpnum), map->Read(ML_TEXTMAP));
+		sc.SetCMode(true);
+		sc.FastPath = fastpath;
+		while (sc.GetString())
+		{
+			sc.UnGet();
+			bool isblock;
+			FName key = ParseKey(true, &isblock);
+			if (isblock)
+			{
+				while (!sc.CheckBlockEnd())
+				{
+					mixkey(ParseKey());
+				}
+			}
+			else
+			{
+				mixkey(key);
+			}
+		}
+		return hash;
+	}
+};
+
+CCMD(udmfparsebench)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: udmfparsebench <map> [count]\n");
+		return;
+	}
+	MapData *map = P_OpenMapData(argv[1], true);
+	if (map == nullptr || !map->isText)
+	{
+		Printf("%s is not a UDMF map\n", argv[1]);
+		delete map;
+		return;
+	}
+	int count = argv.argc() > 2 ? clamp(atoi(argv[2]), 1, 100) : 5;
+
+	UDMFBenchParser parser;
+	cycle_t generictime, fasttime;
+	generictime.Reset();
+	fasttime.Reset();
+	uint64_t generichash = 0, fasthash = 0;
+	int numkeys = 0;
+	for (int i = 0; i < count; i++)
+	{
+		generictime.Clock();
+		generichash = parser.Run(map, false, numkeys);
+		generictime.Unclock();
+
+		fasttime.Clock();
+		fasthash = parser.Run(map, true, numkeys);
+		fasttime.Unclock();
+	}
+
+	double megabytes = map->Size(ML_TEXTMAP) / (1024.0 * 1024.0);
+	Printf("%s: %d keys, generic %.2f ms (%.1f MB/s), fast path %.2f ms (%.1f MB/s), results %s\n", argv[1], numkeys,
+		generictime.TimeMS() / count, megabytes * count * 1000.0 / generictime.TimeMS(),
+		fasttime.TimeMS() / count, megabytes * count * 1000.0 / fasttime.TimeMS(),
+		generichash == fasthash ? "match" : "DIFFER");
+	delete map;
+}
@@ -4,10 +4,23 @@
 #include "sc_man.h"
 #include "m_fixed.h"
 
+// FScanner with a fast path for the 'key = value;' lines that make up the bulk of a TEXTMAP lump.
+class FUDMFScanner : public FScanner
+{
+public:
+	bool CheckBlockEnd();
+	bool GetAssignedValue(FString &stringvalue);
+
+	bool FastPath = true;
+
+private:
+	bool SkipWhitespace(const char *&p, int &line, bool &crossed);
+};
+
 class UDMFParserBase
 {
 protected:
-	FScanner sc;
+	FUDMFScanner sc;
 	FName namespc = NAME_None;
 	int namespace_bits;
 	FString parsedString;
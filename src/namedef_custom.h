@@ -226,6 +226,10 @@ xx(A_FireOldBFG)
 xx(A_FireRailgun)
 xx(MBF21_ConsumeAmmo)
 
+// Monster actions recognized by the batched sight checks
+xx(A_Look)
+xx(A_Chase)
+
 // Special translation names
 xx(RainPillar1)
 xx(RainPillar2)
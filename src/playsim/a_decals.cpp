@@ -48,6 +48,7 @@
 
 EXTERN_CVAR (Bool, cl_spreaddecals)
 EXTERN_CVAR (Int, cl_maxdecals)
+EXTERN_CVAR (Int, cl_maxwalldecals)
 
 
 //----------------------------------------------------------------------------
@@ -245,24 +246,15 @@ void DBaseDecal::SetShade (int r, int g, int b)
 
 //----------------------------------------------------------------------------
 //
-// Returns the texture the decal stuck to.
+// Finds the part of the wall a decal at the given spot goes on and the plane
+// its height is relative to. Returns the texture of that part, or an invalid
+// one if the decal cannot go there. This does not change anything, so it
+// can be used to check a spot before creating a decal for it.
 //
 //----------------------------------------------------------------------------
 
-FTextureID DBaseDecal::StickToWall (side_t *wall, double x, double y, F3DFloor *ffloor)
+static FTextureID GetDecalWallPart (side_t *wall, double x, double y, double z, F3DFloor *ffloor, int &renderflags, double &planez, sector_t *&sector)
 {
-	Side = wall;
-	WallPrev = wall->AttachedDecals;
-
-	while (WallPrev != nullptr && WallPrev->WallNext != nullptr)
-	{
-		WallPrev = WallPrev->WallNext;
-	}
-	if (WallPrev != nullptr) WallPrev->WallNext = this;
-	else wall->AttachedDecals = this;
-	WallNext = nullptr;
-
-
 	sector_t *front, *back;
 	line_t *line;
 	FTextureID tex;
@@ -280,39 +272,39 @@ FTextureID DBaseDecal::StickToWall (side_t *wall, double x, double y, F3DFloor *
 	}
 	if (back == NULL)
 	{
-		RenderFlags |= RF_RELMID;
+		renderflags = RF_RELMID;
 		if (line->flags & ML_DONTPEGBOTTOM)
-			Z -= front->GetPlaneTexZ(sector_t::floor);
+			planez = front->GetPlaneTexZ(sector_t::floor);
 		else
-			Z -= front->GetPlaneTexZ(sector_t::ceiling);
+			planez = front->GetPlaneTexZ(sector_t::ceiling);
 		tex = wall->GetTexture(side_t::mid);
 	}
-	else if (back->floorplane.ZatPoint (x, y) >= Z)
+	else if (back->floorplane.ZatPoint (x, y) >= z)
 	{
-		RenderFlags |= RF_RELLOWER|RF_CLIPLOWER;
+		renderflags = RF_RELLOWER|RF_CLIPLOWER;
 		if (line->flags & ML_DONTPEGBOTTOM)
-			Z -= front->GetPlaneTexZ(sector_t::ceiling);
+			planez = front->GetPlaneTexZ(sector_t::ceiling);
 		else
-			Z -= back->GetPlaneTexZ(sector_t::floor);
+			planez = back->GetPlaneTexZ(sector_t::floor);
 		tex = wall->GetTexture(side_t::bottom);
 	}
-	else if (back->ceilingplane.ZatPoint (x, y) <= Z)
+	else if (back->ceilingplane.ZatPoint (x, y) <= z)
 	{
-		RenderFlags |= RF_RELUPPER|RF_CLIPUPPER;
+		renderflags = RF_RELUPPER|RF_CLIPUPPER;
 		if (line->flags & ML_DONTPEGTOP)
-			Z -= front->GetPlaneTexZ(sector_t::ceiling);
+			planez = front->GetPlaneTexZ(sector_t::ceiling);
 		else
-			Z -= back->GetPlaneTexZ(sector_t::ceiling);
+			planez = back->GetPlaneTexZ(sector_t::ceiling);
 		tex = wall->GetTexture(side_t::top);
 	}
 	else if (ffloor) // this is a 3d-floor segment - do this only if we know which one!
 	{
-		Sector=ffloor->model;
-		RenderFlags |= RF_RELMID|RF_CLIPMID;
+		sector = ffloor->model;
+		renderflags = RF_RELMID|RF_CLIPMID;
 		if (line->flags & ML_DONTPEGBOTTOM)
-			Z -= Sector->GetPlaneTexZ(sector_t::floor);
+			planez = sector->GetPlaneTexZ(sector_t::floor);
 		else
-			Z -= Sector->GetPlaneTexZ(sector_t::ceiling);
+			planez = sector->GetPlaneTexZ(sector_t::ceiling);
 
 		if (ffloor->flags & FF_UPPERTEXTURE)
 		{
@@ -328,7 +320,6 @@ FTextureID DBaseDecal::StickToWall (side_t *wall, double x, double y, F3DFloor *
 		}
 	}
 	else return FNullTextureID();
-	CalcFracPos (wall, x, y);
 
 	auto texture = TexMan.GetGameTexture(tex);
 
@@ -340,6 +331,39 @@ FTextureID DBaseDecal::StickToWall (side_t *wall, double x, double y, F3DFloor *
 	return tex;
 }
 
+//----------------------------------------------------------------------------
+//
+// Returns the texture the decal stuck to.
+//
+//----------------------------------------------------------------------------
+
+FTextureID DBaseDecal::StickToWall (side_t *wall, double x, double y, F3DFloor *ffloor)
+{
+	Side = wall;
+	WallPrev = wall->AttachedDecals;
+
+	while (WallPrev != nullptr && WallPrev->WallNext != nullptr)
+	{
+		WallPrev = WallPrev->WallNext;
+	}
+	if (WallPrev != nullptr) WallPrev->WallNext = this;
+	else wall->AttachedDecals = this;
+	WallNext = nullptr;
+
+	int renderflags = 0;
+	double planez = 0;
+	FTextureID tex = GetDecalWallPart(wall, x, y, Z, ffloor, renderflags, planez, Sector);
+	if (!tex.isValid())
+	{
+		return tex;
+	}
+
+	RenderFlags |= renderflags;
+	Z -= planez;
+	CalcFracPos (wall, x, y);
+	return tex;
+}
+
 //----------------------------------------------------------------------------
 //
 //
@@ -665,19 +689,82 @@ DBaseDecal *DBaseDecal::CloneSelf (const FDecalTemplate *tpl, double ix, double
 //
 //----------------------------------------------------------------------------
 
-void DImpactDecal::CheckMax ()
+DImpactDecal *DImpactDecal::Allocate(FLevelLocals *Level, side_t *wall, const DVector3 &pos, F3DFloor *ffloor, const DBaseDecal *keep)
 {
-	static int SpawnCounter;
+	DImpactDecal *oldest = nullptr;
+
+	// Check that the decal can stick to this spot before an older one gets
+	// pushed out for it. The result does not depend on the decal itself.
+	int renderflags;
+	double planez;
+	sector_t *sector = nullptr;
+	if (!GetDecalWallPart(wall, pos.X, pos.Y, pos.Z, ffloor, renderflags, planez, sector).isValid())
+	{
+		return nullptr;
+	}
 
-	if (++Level->ImpactDecalCount >= cl_maxdecals)
+	// Enforce the per-wall budget first so that busy walls replace their own
+	// decals instead of pushing out the ones on the rest of the level.
+	if (cl_maxwalldecals > 0)
 	{
-		DThinker *thinker = Level->FirstThinker (STAT_AUTODECAL);
-		if (thinker != NULL)
+		int count = 0;
+		for (DBaseDecal *node = wall->AttachedDecals; node != nullptr; node = node->WallNext)
 		{
-			thinker->Destroy();
-			Level->ImpactDecalCount--;
+			auto impact = dyn_cast<DImpactDecal>(node);
+			if (impact != nullptr && impact != keep)
+			{
+				if (oldest == nullptr) oldest = impact;
+				count++;
+			}
+		}
+		if (count < cl_maxwalldecals) oldest = nullptr;
+	}
+
+	if (oldest == nullptr && Level->ImpactDecalCount + 1 >= cl_maxdecals)
+	{
+		oldest = dyn_cast<DImpactDecal>(Level->FirstThinker(STAT_AUTODECAL));
+		if (oldest == keep) oldest = nullptr;
+	}
+
+	if (oldest != nullptr)
+	{
+		if (oldest->Recyclable)
+		{
+			// Reuse the evicted decal instead of destroying it and allocating a
+			// new one. The level's decal count stays the same.
+			oldest->Recycle(pos.Z);
+			return oldest;
 		}
+		oldest->Destroy();
+		Level->ImpactDecalCount--;
 	}
+
+	auto decal = Level->CreateThinker<DImpactDecal>(pos.Z);
+	Level->ImpactDecalCount++;
+	return decal;
+}
+
+//----------------------------------------------------------------------------
+//
+// Resets an evicted decal to the state of a newly created one and moves it
+// to the end of the eviction order.
+//
+//----------------------------------------------------------------------------
+
+void DImpactDecal::Recycle(double z)
+{
+	Remove();
+	Side = nullptr;
+	Sector = nullptr;
+	LeftDistance = 0;
+	ScaleX = ScaleY = 1;
+	Alpha = 1;
+	AlphaColor = 0;
+	Translation = NO_TRANSLATION;
+	RenderFlags = 0;
+	Recyclable = false;
+	Construct(z);
+	ChangeStatNum(STAT_AUTODECAL);
 }
 
 //----------------------------------------------------------------------------
@@ -734,7 +821,7 @@ DBaseDecal* DImpactDecal::StaticCreate (FLevelLocals *Level, const FDecalTemplat
 
 			StaticCreate (Level, tpl_low, pos, wall, ffloor, lowercolor, bloodTranslation, permanent);
 		}
-		if (!permanent) decal = Level->CreateThinker<DImpactDecal>(pos.Z);
+		if (!permanent) decal = Allocate(Level, wall, pos, ffloor);
 		else decal = Level->CreateThinker<DBaseDecal>(pos.Z);
 		if (decal == NULL)
 		{
@@ -743,12 +830,13 @@ DBaseDecal* DImpactDecal::StaticCreate (FLevelLocals *Level, const FDecalTemplat
 
 		if (!decal->StickToWall (wall, pos.X, pos.Y, ffloor).isValid())
 		{
+			if (!permanent) Level->ImpactDecalCount--;
 			decal->Destroy();
 			return NULL;
 		}
-		if (!permanent) static_cast<DImpactDecal*>(decal)->CheckMax();
 
 		tpl->ApplyToDecal (decal, wall);
+		if (!permanent) static_cast<DImpactDecal*>(decal)->Recyclable = tpl->Animator == nullptr;
 		if (color != 0)
 		{
 			decal->SetShade (color.r, color.g, color.b);
@@ -785,13 +873,13 @@ DBaseDecal *DImpactDecal::CloneSelf (const FDecalTemplate *tpl, double ix, doubl
 		return NULL;
 	}
 
-	DImpactDecal *decal = Level->CreateThinker<DImpactDecal>(iz);
+	DImpactDecal *decal = Allocate(Level, wall, DVector3(ix, iy, iz), ffloor, this);
 	if (decal != NULL)
 	{
 		if (decal->StickToWall (wall, ix, iy, ffloor).isValid())
 		{
-			decal->CheckMax();
 			tpl->ApplyToDecal (decal, wall);
+			decal->Recyclable = tpl->Animator == nullptr;
 			decal->AlphaColor = AlphaColor;
 
 			// [Nash] opaque blood
@@ -806,6 +894,7 @@ DBaseDecal *DImpactDecal::CloneSelf (const FDecalTemplate *tpl, double ix, doubl
 		}
 		else
 		{
+			Level->ImpactDecalCount--;
 			decal->Destroy();
 			return NULL;
 		}
@@ -64,11 +64,20 @@
 #include "a_dynlight.h"
 #include "actorinlines.h"
 #include "memarena.h"
+#include "workerpool.h"
+
+CVAR(Bool, r_dynlights_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
+static FMemArena LightNodeArena(sizeof(FLightNode) * 1000);
+static TArray<FLightNode*> FreeNodes;
 static FRandom randLight;
 
+// While this is set, UpdateLocation queues lights that need relinking in PendingLinks instead of linking them right away.
+static bool DeferLinking;
+static TArray<FDynamicLight*> PendingLinks;
+
 extern TArray<FLightDefaults *> StateLights;
 
 
@@ -404,10 +413,18 @@ void FDynamicLight::UpdateLocation()
 		radius = intensity * 2.0f;
 		if (radius < m_currentRadius * 2) radius = m_currentRadius * 2;
 
+		// Sector lights follow the flickering of their sector, which would relink them all the time without moving.
+		// Links made for a somewhat larger radius still cover the smaller light, so keep them until it has shrunk noticeably.
+		if (X() == oldx && Y() == oldy && radius < oldradius && radius >= oldradius * 0.75f)
+		{
+			radius = oldradius;
+		}
+
 		if (X() != oldx || Y() != oldy || radius != oldradius)
 		{
 			//Update the light lists
-			LinkLight();
+			if (DeferLinking) PendingLinks.Push(this);
+			else LinkLight();
 		}
 	}
 }
@@ -441,7 +458,11 @@ FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * l
 	// Couldn't find an existing node for this sector. Add one at the head
 	// of the list.
 	
-	node = new FLightNode;
+	if (FreeNodes.Size())
+	{
+		FreeNodes.Pop(node);
+	}
+	else node = (FLightNode*)LightNodeArena.Alloc(sizeof(FLightNode));
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -484,7 +505,7 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		
 		// Return this node to the freelist
 		tn=node->nextTarget;
-		delete node;
+		FreeNodes.Push(node);
 		return(tn);
 	}
 	return(nullptr);
@@ -522,143 +543,238 @@ double FDynamicLight::DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *
 
 //==========================================================================
 //
-// Collect all touched sidedefs and subsectors
-// to sidedefs and sector parts.
+// Per-thread state for collecting light links.
+// The visited stamps are kept here instead of in the sections and lines
+// so that several lights can be collected at the same time.
 //
 //==========================================================================
+
 struct LightLinkEntry
 {
 	FSection *sect;
 	DVector3 pos;
 };
-static TArray<LightLinkEntry> collected_ss;
 
-void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius)
+struct FLightLinkResult
+{
+	FDynamicLight *light;
+	unsigned firstSection, numSections;
+	unsigned firstSide, numSides;
+	bool collected;
+	bool hitonesidedback;
+};
+
+struct FLightLinkContext
 {
-	if (!section) return;
-	collected_ss.Clear();
-	collected_ss.Push({ section, opos });
-	section->validcount = dl_validcount;
+	FLevelLocals *Level = nullptr;
+	TArray<unsigned> SectionStamps;
+	TArray<unsigned> LineStamps;
+	unsigned Stamp = 0;
+
+	TArray<LightLinkEntry> Queue;
+	TArray<FSection *> Sections;
+	TArray<side_t *> Sides;
+	TArray<FLightLinkResult> Results;
+
+	void Begin(FLevelLocals *level)
+	{
+		if (level != Level || SectionStamps.Size() != level->sections.allSections.Size() || LineStamps.Size() != level->lines.Size())
+		{
+			Level = level;
+			SectionStamps.Resize(level->sections.allSections.Size());
+			LineStamps.Resize(level->lines.Size());
+			memset(SectionStamps.Data(), 0, SectionStamps.Size() * sizeof(unsigned));
+			memset(LineStamps.Data(), 0, LineStamps.Size() * sizeof(unsigned));
+			Stamp = 0;
+		}
+		Sections.Clear();
+		Sides.Clear();
+		Results.Clear();
+	}
 
-	bool hitonesidedback = false;
-	for (unsigned i = 0; i < collected_ss.Size(); i++)
+	void NextStamp()
 	{
-		auto pos = collected_ss[i].pos;
-		section = collected_ss[i].sect;
+		// Stamps wrap around to 0, which is what the arrays get cleared to.
+		if (++Stamp == 0)
+		{
+			memset(SectionStamps.Data(), 0, SectionStamps.Size() * sizeof(unsigned));
+			memset(LineStamps.Data(), 0, LineStamps.Size() * sizeof(unsigned));
+			Stamp = 1;
+		}
+	}
 
-		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+	bool MarkSection(FSection *sect)
+	{
+		unsigned &stamp = SectionStamps[Level->sections.SectionIndex(sect)];
+		if (stamp == Stamp) return false;
+		stamp = Stamp;
+		return true;
+	}
+
+	bool LineChecked(const line_t *line) const
+	{
+		return LineStamps[line->Index()] == Stamp;
+	}
 
+	void MarkLine(const line_t *line)
+	{
+		LineStamps[line->Index()] = Stamp;
+	}
+};
 
-		auto processSide = [&](side_t *sidedef, const vertex_t *v1, const vertex_t *v2)
+static FLightLinkContext MainLinkContext;
+static TArray<FLightLinkContext> WorkerLinkContexts;
+
+//==========================================================================
+//
+// Collect all touched sidedefs and subsectors
+// to sidedefs and sector parts.
+// This may not write to anything but the context because it runs
+// on worker threads.
+//
+//==========================================================================
+
+void FDynamicLight::CollectLinks(FLightLinkContext &ctx)
+{
+	FLightLinkResult &result = ctx.Results[ctx.Results.Reserve(1)];
+	result.light = this;
+	result.firstSection = ctx.Sections.Size();
+	result.firstSide = ctx.Sides.Size();
+	result.collected = false;
+	result.hitonesidedback = false;
+
+	FSection *section = radius > 0 ? Level->PointInRenderSubsector(Pos)->section : nullptr;
+	if (section)
+	{
+		// passing in radius*radius allows us to do a distance check without any calls to sqrt
+		float radius = this->radius * this->radius;
+		auto &collected_ss = ctx.Queue;
+
+		ctx.NextStamp();
+		collected_ss.Clear();
+		collected_ss.Push({ section, Pos });
+		ctx.MarkSection(section);
+
+		bool hitonesidedback = false;
+		for (unsigned i = 0; i < collected_ss.Size(); i++)
 		{
-			auto linedef = sidedef->linedef;
-			if (linedef && linedef->validcount != ::validcount)
+			auto pos = collected_ss[i].pos;
+			section = collected_ss[i].sect;
+
+			ctx.Sections.Push(section);
+
+			auto processSide = [&](side_t *sidedef, const vertex_t *v1, const vertex_t *v2)
 			{
-				// light is in front of the seg
-				if ((pos.Y - v1->fY()) * (v2->fX() - v1->fX()) + (v1->fX() - pos.X) * (v2->fY() - v1->fY()) <= 0)
+				auto linedef = sidedef->linedef;
+				if (linedef && !ctx.LineChecked(linedef))
 				{
-					linedef->validcount = ::validcount;
-					touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
-				}
-				else if (linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
-				{
-					hitonesidedback = true;
+					// light is in front of the seg
+					if ((pos.Y - v1->fY()) * (v2->fX() - v1->fX()) + (v1->fX() - pos.X) * (v2->fY() - v1->fY()) <= 0)
+					{
+						ctx.MarkLine(linedef);
+						ctx.Sides.Push(sidedef);
+					}
+					else if (linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
+					{
+						hitonesidedback = true;
+					}
 				}
-			}
-			if (linedef)
-			{
-				FLinePortal *port = linedef->getPortal();
-				if (port && port->mType == PORTT_LINKED)
+				if (linedef)
 				{
-					line_t *other = port->mDestination;
-					if (other->validcount != ::validcount)
+					FLinePortal *port = linedef->getPortal();
+					if (port && port->mType == PORTT_LINKED)
 					{
-						subsector_t *othersub = Level->PointInRenderSubsector(other->v1->fPos() + other->Delta() / 2);
-						FSection *othersect = othersub->section;
-						if (othersect->validcount != ::validcount)
+						line_t *other = port->mDestination;
+						if (!ctx.LineChecked(other))
 						{
-							othersect->validcount = ::validcount;
-							collected_ss.Push({ othersect, PosRelative(other->frontsector->PortalGroup) });
+							subsector_t *othersub = Level->PointInRenderSubsector(other->v1->fPos() + other->Delta() / 2);
+							FSection *othersect = othersub->section;
+							if (ctx.MarkSection(othersect))
+							{
+								collected_ss.Push({ othersect, PosRelative(other->frontsector->PortalGroup) });
+							}
 						}
 					}
 				}
-			}
-		};
+			};
 
-		for (auto &segment : section->segments)
-		{
-			// check distance from x/y to seg and if within radius add this seg and, if present the opposing subsector (lather/rinse/repeat)
-			// If out of range we do not need to bother with this seg.
-			if (DistToSeg(pos, segment.start, segment.end) <= radius)
+			for (auto &segment : section->segments)
 			{
-				auto sidedef = segment.sidedef;
-				if (sidedef)
+				// check distance from x/y to seg and if within radius add this seg and, if present the opposing subsector (lather/rinse/repeat)
+				// If out of range we do not need to bother with this seg.
+				if (DistToSeg(pos, segment.start, segment.end) <= radius)
 				{
-					processSide(sidedef, segment.start, segment.end);
-				}
+					auto sidedef = segment.sidedef;
+					if (sidedef)
+					{
+						processSide(sidedef, segment.start, segment.end);
+					}
 
-				auto partner = segment.partner;
-				if (partner)
-				{
-					FSection *sect = partner->section;
-					if (sect != nullptr && sect->validcount != dl_validcount)
+					auto partner = segment.partner;
+					if (partner)
 					{
-						sect->validcount = dl_validcount;
-						collected_ss.Push({ sect, pos });
+						FSection *sect = partner->section;
+						if (sect != nullptr && ctx.MarkSection(sect))
+						{
+							collected_ss.Push({ sect, pos });
+						}
 					}
 				}
 			}
-		}
-		for (auto side : section->sides)
-		{
-			auto v1 = side->V1(), v2 = side->V2();
-			if (DistToSeg(pos, v1, v2) <= radius)
+			for (auto side : section->sides)
 			{
-				processSide(side, v1, v2);
+				auto v1 = side->V1(), v2 = side->V2();
+				if (DistToSeg(pos, v1, v2) <= radius)
+				{
+					processSide(side, v1, v2);
+				}
 			}
-		}
-		sector_t *sec = section->sector;
-		if (!sec->PortalBlocksSight(sector_t::ceiling))
-		{
-			line_t *other = section->segments[0].sidedef->linedef;
-			if (sec->GetPortalPlaneZ(sector_t::ceiling) < Z() + radius)
+			sector_t *sec = section->sector;
+			if (!sec->PortalBlocksSight(sector_t::ceiling))
 			{
-				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling);
-				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
-				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				line_t *other = section->segments[0].sidedef->linedef;
+				if (sec->GetPortalPlaneZ(sector_t::ceiling) < Z() + radius)
 				{
-					othersect->validcount = dl_validcount;
-					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
+					DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling);
+					subsector_t *othersub = Level->PointInRenderSubsector(refpos);
+					FSection *othersect = othersub->section;
+					if (ctx.MarkSection(othersect))
+					{
+						collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
+					}
 				}
 			}
-		}
-		if (!sec->PortalBlocksSight(sector_t::floor))
-		{
-			line_t *other = section->segments[0].sidedef->linedef;
-			if (sec->GetPortalPlaneZ(sector_t::floor) > Z() - radius)
+			if (!sec->PortalBlocksSight(sector_t::floor))
 			{
-				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor);
-				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
-				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				line_t *other = section->segments[0].sidedef->linedef;
+				if (sec->GetPortalPlaneZ(sector_t::floor) > Z() - radius)
 				{
-					othersect->validcount = dl_validcount;
-					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
+					DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor);
+					subsector_t *othersub = Level->PointInRenderSubsector(refpos);
+					FSection *othersect = othersub->section;
+					if (ctx.MarkSection(othersect))
+					{
+						collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
+					}
 				}
 			}
 		}
+		result.collected = true;
+		result.hitonesidedback = hitonesidedback;
 	}
-	shadowmapped = hitonesidedback && !DontShadowmap();
+	result.numSections = ctx.Sections.Size() - result.firstSection;
+	result.numSides = ctx.Sides.Size() - result.firstSide;
 }
 
 //==========================================================================
 //
-// Link the light into the world
+// Replaces the light's node lists with the collected ones.
+// This writes to the shared section and side light lists so it
+// must run on the main thread.
 //
 //==========================================================================
 
-void FDynamicLight::LinkLight()
+void FDynamicLight::ApplyLinks(const FLightLinkContext &ctx, const FLightLinkResult &result)
 {
 	// mark the old light nodes
 	FLightNode * node;
@@ -676,15 +792,19 @@ void FDynamicLight::LinkLight()
 		node = node->nextTarget;
 	}
 
-	if (radius>0)
+	for (unsigned i = 0; i < result.numSections; i++)
 	{
-		// passing in radius*radius allows us to do a distance check without any calls to sqrt
-		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
-
-		dl_validcount++;
-		::validcount++;
-		CollectWithinRadius(Pos, sect, float(radius*radius));
-
+		FSection *section = ctx.Sections[result.firstSection + i];
+		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+	}
+	for (unsigned i = 0; i < result.numSides; i++)
+	{
+		side_t *sidedef = ctx.Sides[result.firstSide + i];
+		touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+	}
+	if (result.collected)
+	{
+		shadowmapped = result.hitonesidedback && !DontShadowmap();
 	}
 		
 	// Now delete any nodes that won't be used. These are the ones where
@@ -713,6 +833,85 @@ void FDynamicLight::LinkLight()
 	}
 }
 
+//==========================================================================
+//
+// Link the light into the world
+//
+//==========================================================================
+
+void FDynamicLight::LinkLight()
+{
+	MainLinkContext.Begin(Level);
+	CollectLinks(MainLinkContext);
+	ApplyLinks(MainLinkContext, MainLinkContext.Results[0]);
+}
+
+//==========================================================================
+//
+// Ticks all lights of a level. Relinking the lights that moved is the
+// expensive part, so with enough of them the collection work is
+// spread over worker threads.
+//
+//==========================================================================
+
+static void LinkPendingLights(FLevelLocals *Level)
+{
+	enum { MinLightsPerJob = 32 };
+
+	unsigned count = PendingLinks.Size();
+	unsigned numJobs = min<unsigned>(WorkerPoolSize() + 1, count / MinLightsPerJob);
+
+	if (numJobs <= 1)
+	{
+		for (auto light : PendingLinks) light->LinkLight();
+		PendingLinks.Clear();
+		return;
+	}
+
+	if (WorkerLinkContexts.Size() < numJobs) WorkerLinkContexts.Resize(numJobs);
+
+	RunOnWorkerPool(numJobs, [=](int j)
+	{
+		unsigned first = count * j / numJobs;
+		unsigned last = count * (j + 1) / numJobs;
+		auto &ctx = WorkerLinkContexts[j];
+		ctx.Begin(Level);
+		for (unsigned i = first; i < last; i++)
+		{
+			PendingLinks[i]->CollectLinks(ctx);
+		}
+	});
+
+	// Apply in the original light order so that the node lists come out the same as when linking serially.
+	for (unsigned j = 0; j < numJobs; j++)
+	{
+		auto &ctx = WorkerLinkContexts[j];
+		for (auto &result : ctx.Results)
+		{
+			result.light->ApplyLinks(ctx, result);
+		}
+	}
+	PendingLinks.Clear();
+}
+
+int TickDynamicLights(FLevelLocals *Level)
+{
+	int count = 0;
+
+	PendingLinks.Clear();
+	DeferLinking = r_dynlights_multithread;
+	for (auto light = Level->lights; light;)
+	{
+		count++;
+		auto next = light->next;
+		light->Tick();
+		light = next;
+	}
+	DeferLinking = false;
+	LinkPendingLights(Level);
+	return count;
+}
+
 
 //==========================================================================
 //
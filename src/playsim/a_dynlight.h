@@ -197,6 +197,9 @@ struct FLightNode
 	};
 };
 
+struct FLightLinkContext;
+struct FLightLinkResult;
+
 struct FDynamicLight
 {
 	friend class FLightDefaults;
@@ -250,11 +253,15 @@ struct FDynamicLight
 	void UpdateLocation();
 	void LinkLight();
 	void UnlinkLight();
+
+	// LinkLight split in two: collecting the touched sections and sides only reads the map and can run on a worker thread,
+	// linking the nodes into the shared section and side lists must happen on the main thread.
+	void CollectLinks(FLightLinkContext &ctx);
+	void ApplyLinks(const FLightLinkContext &ctx, const FLightLinkResult &result);
 	void ReleaseLight();
 
 private:
 	double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
-	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius);
 
 public:
 	FCycler m_cycler;
@@ -291,4 +298,5 @@ public:
 
 };
 
-
+// Ticks all dynamic lights of a level. Returns the number of lights ticked.
+int TickDynamicLights(FLevelLocals *Level);
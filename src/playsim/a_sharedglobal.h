@@ -81,7 +81,10 @@ public:
 
 protected:
 	DBaseDecal *CloneSelf(const FDecalTemplate *tpl, double x, double y, double z, side_t *wall, F3DFloor * ffloor) const;
-	void CheckMax ();
+	static DImpactDecal *Allocate(FLevelLocals *Level, side_t *wall, const DVector3 &pos, F3DFloor *ffloor, const DBaseDecal *keep = nullptr);
+	void Recycle(double z);
+
+	bool Recyclable = false;	// Not serialized. Only set when no animator references this decal.
 };
 
 class DFlashFader : public DThinker
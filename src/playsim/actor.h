@@ -1280,6 +1280,9 @@ public:
 	struct msecnode_t	*touching_sectorportallist;		// same for cross-sectorportal rendering
 	struct portnode_t	*touching_lineportallist;		// and for cross-lineportal
 	struct msecnode_t	*touching_rendersectors; // this is the list of sectors that this thing interesects with it's max(radius, renderradius).
+	DVector2		SectorListCenter;	// While the actor's box stays inside this square, which no line crosses,
+	double			SectorListExtent;	// its sector lists only contain its own sector. 0 if not known.
+	double			OldRenderRadius;	// radius OldRenderPos' line portal list was built with
 	int validcount;
 
 
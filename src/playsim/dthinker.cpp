@@ -144,6 +144,8 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
+			// Players have moved by now, so this is where the monsters' sight checks get batched.
+			if (i == STAT_DEFAULT) P_BeginSightBatch(Level);
 			Thinkers[i].TickThinkers(nullptr);
 		}
 
@@ -156,16 +158,12 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 				count += FreshThinkers[i].TickThinkers(&Thinkers[i]);
 			}
 		} while (count != 0);
+		P_EndSightBatch();
 
 		recreateLights();
 		if (dolights)
 		{
-			for (auto light = Level->lights; light;)
-			{
-				auto next = light->next;
-				light->Tick();
-				light = next;
-			}
+			TickDynamicLights(Level);
 		}
 	}
 	else
@@ -174,6 +172,8 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
+			// Players have moved by now, so this is where the monsters' sight checks get batched.
+			if (i == STAT_DEFAULT) P_BeginSightBatch(Level);
 			Thinkers[i].ProfileThinkers(nullptr);
 		}
 
@@ -186,6 +186,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 				count += FreshThinkers[i].ProfileThinkers(&Thinkers[i]);
 			}
 		} while (count != 0);
+		P_EndSightBatch();
 
 		recreateLights();
 		if (dolights)
@@ -193,13 +194,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			// Also profile the internal dynamic lights, even though they are not implemented as thinkers.
 			auto &prof = Profiles[NAME_InternalDynamicLight];
 			prof.timer.Clock();
-			for (auto light = Level->lights; light;)
-			{
-				prof.numcalls++;
-				auto next = light->next;
-				light->Tick();
-				light = next;
-			}
+			prof.numcalls += TickDynamicLights(Level);
 			prof.timer.Unclock();
 		}
 
@@ -78,6 +78,7 @@
 #include "s_music.h"
 #include "v_video.h"
 #include "texturemanager.h"
+#include "vmbuilder.h"
 
 	// P-codes for ACS scripts
 	enum
@@ -676,6 +677,7 @@ public:
 		const int *args, int argcount, int flags);
 
 	void Serialize(FSerializer &arc);
+	bool UpdateWaitState();
 	int RunScript();
 	PClass *GetClassForIndex(int index) const;
 
@@ -3420,7 +3422,10 @@ void DACSThinker::Tick ()
 	while (script)
 	{
 		DLevelScript *next = script->next;
-		script->RunScript();
+		if (script->UpdateWaitState())
+		{
+			script->RunScript();
+		}
 		script = next;
 	}
 
@@ -6842,6 +6847,938 @@ inline int getshort (int *&pc)
 	return res;
 }
 
+//==========================================================================
+//
+// ACS to VM translation
+//
+// Hot runs of plain stack arithmetic, variable access and jumps are
+// translated into VM functions, which get JIT compiled on their first
+// call like any other script function. Everything else, in particular all
+// p-codes that can suspend a script, is left to the interpreter, so a
+// translated region always hands control back with the script in exactly
+// the state the interpreter would have left it in.
+//
+// A region maps the stack slots above the entry sp to VM registers. The
+// slot layout has to agree at every jump target inside the region; jumps
+// that would disagree, ops that reach below the entry sp and division by
+// zero all leave the region and let the interpreter handle them.
+//
+//==========================================================================
+
+CVAR(Bool, acs_translate, true, 0)
+
+enum
+{
+	REGION_HOT = 8,			// interpreter visits before a p-code offset gets translated
+	REGION_NONE = 254,
+	REGION_FOUND = 255,
+
+	REGION_MAXOPS = 1024,
+	REGION_MINOPS = 4,		// anything shorter is cheaper to interpret than to call
+	REGION_MAXDEPTH = 128,	// keeps the register count inside the JIT's limit
+	REGION_RUNAWAY = 2000000,
+};
+
+// Passed to a region's VM function. On exit the function stores where the
+// interpreter has to resume.
+struct FACSRegionState
+{
+	int32_t *Stack;			// first free stack slot on entry
+	int32_t *Locals;
+	int32_t **MapVars;
+	int32_t Pc;				// p-code offset to resume at
+	int32_t Depth;			// stack slots pushed above the entry sp
+	int32_t Runaway;
+};
+
+struct FACSRegion
+{
+	TArray<uint8_t> Code;	// the translated p-code, to tell hash collisions apart
+	uint32_t Start;
+	ACSFormat Format;
+	int MaxDepth;
+	int MaxLocal;
+	VMFunction *Func;
+	FACSRegion *Next;
+};
+
+// Regions are shared by every module with the same p-code at the same
+// offset, so reloading a map does not create new VM functions. Like the
+// functions themselves they live until the program exits, since
+// PClass::FunctionPtrList points into them.
+static TMap<uint32_t, FACSRegion *> ACSRegionCache;
+
+static const uint8_t ACSRegionRegTypes[] = { REGT_POINTER };
+
+class FACSTranslator
+{
+	enum EKind { RK_Nop, RK_Push, RK_PushBytes, RK_Dup, RK_Swap, RK_Drop, RK_Unary, RK_Binary, RK_Var, RK_Goto, RK_IfGoto, RK_IfNotGoto, RK_CaseGoto };
+	enum EScope { VS_Script, VS_Map, VS_World, VS_Global };
+	enum EVarOp { VO_Assign, VO_Push, VO_Inc, VO_Dec, VO_Binary };
+
+	struct FOp
+	{
+		uint32_t Ofs;
+		uint32_t Next;
+		uint32_t Target;
+		int Pcd;			// for RK_Binary, RK_Unary and VO_Binary this is the arithmetic p-code
+		int Arg;			// constant, variable index, byte count or case value
+		uint8_t Kind;
+		uint8_t Scope;
+		uint8_t VarOp;
+		int Depth = -1;
+		bool Exit = false;
+		bool FallExit = false;
+		bool JumpExit = false;
+		bool Leader = false;
+		size_t Addr = 0;
+	};
+
+	struct FJump
+	{
+		size_t Loc;
+		unsigned Op;
+	};
+
+	struct FExitJump
+	{
+		size_t Loc;
+		uint32_t Ofs;
+		int Depth;
+	};
+
+	const uint8_t *Data;
+	uint32_t DataSize;
+	ACSFormat Format;
+	TArray<FOp> Ops;
+	TMap<uint32_t, unsigned> OpIndex;
+	uint32_t End;
+	int MaxDepth = 0;
+	int MaxLocal = -1;
+
+	VMFunctionBuilder *Build = nullptr;
+	int Slot[REGION_MAXDEPTH];
+	int RegRun, RegTmp, RegCond;
+	int RegState, RegStack, RegLocals, RegMapVars, RegVar;
+	int Pending = 0;
+	TArray<FJump> Forward;
+	TArray<FJump> BackEdges;
+	TArray<FExitJump> Exits;
+
+public:
+	FACSTranslator(const uint8_t *data, uint32_t datasize, ACSFormat fmt)
+		: Data(data), DataSize(datasize), Format(fmt)
+	{
+	}
+
+	FACSRegion *Translate(uint32_t start);
+
+private:
+	int ReadLong(uint32_t ofs) const
+	{
+		const uint8_t *p = Data + ofs;
+		return int(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+	}
+	bool Decode(uint32_t ofs, FOp &op);
+	void Analyze();
+	bool Propagate(unsigned to, int depth);
+	VMFunction *Emit();
+
+	static int Need(const FOp &op);
+	static int Grow(const FOp &op);
+	static int FallDelta(const FOp &op);
+
+	void Flush();
+	void EmitExit(uint32_t ofs, int depth);
+	void EmitJump(unsigned from);
+	void EmitCond(int opcode, int b, int c, int dst, bool invert);
+	void EmitBinary(int pcd, int dst, int a, int b);
+	void EmitZeroCheck(unsigned op, int reg);
+	int VarAddress(const FOp &op, int &offset);
+	void EmitOp(unsigned index);
+};
+
+//==========================================================================
+//
+// FACSTranslator :: Decode
+//
+// Reads one p-code exactly the way the interpreter would and returns
+// false for anything that cannot be translated.
+//
+//==========================================================================
+
+bool FACSTranslator::Decode(uint32_t ofs, FOp &op)
+{
+	auto avail = [&](uint32_t n) { return ofs + n <= DataSize; };
+	auto readbyte = [&](int &val)
+	{
+		if (Format == ACS_LittleEnhanced)
+		{
+			if (!avail(1)) return false;
+			val = Data[ofs++];
+		}
+		else
+		{
+			if (!avail(4)) return false;
+			val = ReadLong(ofs);
+			ofs += 4;
+		}
+		return true;
+	};
+
+	op.Ofs = ofs;
+	if (Format == ACS_LittleEnhanced)
+	{
+		if (!avail(1)) return false;
+		op.Pcd = Data[ofs++];
+		if (op.Pcd >= 256-16)
+		{
+			if (!avail(1)) return false;
+			op.Pcd = (256-16) + ((op.Pcd - (256-16)) << 8) + Data[ofs++];
+		}
+	}
+	else
+	{
+		if (!avail(4)) return false;
+		op.Pcd = ReadLong(ofs);
+		ofs += 4;
+	}
+
+#define VAROP(name, vop, bin) \
+	case PCD_##name##SCRIPTVAR:	op.Scope = VS_Script; op.VarOp = vop; op.Pcd = bin; break; \
+	case PCD_##name##MAPVAR:	op.Scope = VS_Map; op.VarOp = vop; op.Pcd = bin; break; \
+	case PCD_##name##WORLDVAR:	op.Scope = VS_World; op.VarOp = vop; op.Pcd = bin; break; \
+	case PCD_##name##GLOBALVAR:	op.Scope = VS_Global; op.VarOp = vop; op.Pcd = bin; break;
+
+	op.Kind = RK_Var;
+	switch (op.Pcd)
+	{
+	VAROP(ASSIGN, VO_Assign, 0)
+	VAROP(PUSH, VO_Push, 0)
+	VAROP(INC, VO_Inc, 0)
+	VAROP(DEC, VO_Dec, 0)
+	VAROP(ADD, VO_Binary, PCD_ADD)
+	VAROP(SUB, VO_Binary, PCD_SUBTRACT)
+	VAROP(MUL, VO_Binary, PCD_MULTIPLY)
+	VAROP(DIV, VO_Binary, PCD_DIVIDE)
+	VAROP(MOD, VO_Binary, PCD_MODULUS)
+	VAROP(AND, VO_Binary, PCD_ANDBITWISE)
+	VAROP(OR, VO_Binary, PCD_ORBITWISE)
+	VAROP(EOR, VO_Binary, PCD_EORBITWISE)
+	VAROP(LS, VO_Binary, PCD_LSHIFT)
+	VAROP(RS, VO_Binary, PCD_RSHIFT)
+
+	case PCD_NOP:
+		op.Kind = RK_Nop;
+		break;
+
+	case PCD_PUSHNUMBER:
+		if (!avail(4)) return false;
+		op.Kind = RK_Push;
+		op.Arg = ReadLong(ofs);
+		ofs += 4;
+		break;
+
+	case PCD_PUSHBYTE:
+		if (!avail(1)) return false;
+		op.Kind = RK_Push;
+		op.Arg = Data[ofs++];
+		break;
+
+	case PCD_PUSH2BYTES:
+	case PCD_PUSH3BYTES:
+	case PCD_PUSH4BYTES:
+	case PCD_PUSH5BYTES:
+		op.Kind = RK_PushBytes;
+		op.Arg = op.Pcd - PCD_PUSH2BYTES + 2;
+		op.Target = ofs;
+		if (!avail(op.Arg)) return false;
+		ofs += op.Arg;
+		break;
+
+	case PCD_PUSHBYTES:
+		if (!avail(1)) return false;
+		op.Kind = RK_PushBytes;
+		op.Arg = Data[ofs++];
+		op.Target = ofs;
+		if (!avail(op.Arg)) return false;
+		ofs += op.Arg;
+		break;
+
+	case PCD_DUP:
+		op.Kind = RK_Dup;
+		break;
+
+	case PCD_SWAP:
+		op.Kind = RK_Swap;
+		break;
+
+	case PCD_DROP:
+		op.Kind = RK_Drop;
+		break;
+
+	case PCD_UNARYMINUS:
+	case PCD_NEGATEBINARY:
+	case PCD_NEGATELOGICAL:
+		op.Kind = RK_Unary;
+		break;
+
+	case PCD_ADD:
+	case PCD_SUBTRACT:
+	case PCD_MULTIPLY:
+	case PCD_DIVIDE:
+	case PCD_MODULUS:
+	case PCD_EQ:
+	case PCD_NE:
+	case PCD_LT:
+	case PCD_GT:
+	case PCD_LE:
+	case PCD_GE:
+	case PCD_ANDLOGICAL:
+	case PCD_ORLOGICAL:
+	case PCD_ANDBITWISE:
+	case PCD_ORBITWISE:
+	case PCD_EORBITWISE:
+	case PCD_LSHIFT:
+	case PCD_RSHIFT:
+		op.Kind = RK_Binary;
+		break;
+
+	case PCD_GOTO:
+	case PCD_IFGOTO:
+	case PCD_IFNOTGOTO:
+		if (!avail(4)) return false;
+		op.Kind = op.Pcd == PCD_GOTO ? RK_Goto : op.Pcd == PCD_IFGOTO ? RK_IfGoto : RK_IfNotGoto;
+		op.Target = ReadLong(ofs);
+		ofs += 4;
+		break;
+
+	case PCD_CASEGOTO:
+		if (!avail(8)) return false;
+		op.Kind = RK_CaseGoto;
+		op.Arg = ReadLong(ofs);
+		op.Target = ReadLong(ofs + 4);
+		ofs += 8;
+		break;
+
+	default:
+		return false;
+	}
+#undef VAROP
+
+	if (op.Kind == RK_Var)
+	{
+		static const unsigned limits[] = { 256, NUM_MAPVARS, NUM_WORLDVARS, NUM_GLOBALVARS };
+		if (!readbyte(op.Arg) || (unsigned)op.Arg >= limits[op.Scope])
+		{
+			return false;
+		}
+	}
+	op.Next = ofs;
+	return true;
+}
+
+//==========================================================================
+//
+// Stack effect of an op: how many slots it needs on entry, how far it
+// grows the stack and the depth change on the fall-through edge.
+//
+//==========================================================================
+
+int FACSTranslator::Need(const FOp &op)
+{
+	switch (op.Kind)
+	{
+	case RK_Dup: case RK_Drop: case RK_Unary:
+	case RK_IfGoto: case RK_IfNotGoto: case RK_CaseGoto:
+		return 1;
+	case RK_Swap: case RK_Binary:
+		return 2;
+	case RK_Var:
+		return op.VarOp == VO_Assign || op.VarOp == VO_Binary;
+	default:
+		return 0;
+	}
+}
+
+int FACSTranslator::Grow(const FOp &op)
+{
+	switch (op.Kind)
+	{
+	case RK_Push: case RK_Dup:
+		return 1;
+	case RK_PushBytes:
+		return op.Arg;
+	case RK_Var:
+		return op.VarOp == VO_Push;
+	default:
+		return 0;
+	}
+}
+
+int FACSTranslator::FallDelta(const FOp &op)
+{
+	switch (op.Kind)
+	{
+	case RK_Drop: case RK_Binary: case RK_IfGoto: case RK_IfNotGoto:
+		return -1;
+	case RK_Var:
+		return op.VarOp == VO_Push ? 1 : op.VarOp == VO_Assign || op.VarOp == VO_Binary ? -1 : 0;
+	default:
+		return Grow(op);
+	}
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Analyze
+//
+// Assigns a stack depth to every reachable op. Edges into an op that
+// already has a different depth become region exits.
+//
+//==========================================================================
+
+bool FACSTranslator::Propagate(unsigned to, int depth)
+{
+	if (to >= Ops.Size())
+	{
+		return false;
+	}
+	if (Ops[to].Depth < 0)
+	{
+		Ops[to].Depth = depth;
+		return true;
+	}
+	return Ops[to].Depth == depth;
+}
+
+void FACSTranslator::Analyze()
+{
+	TArray<unsigned> work;
+
+	Ops[0].Depth = 0;
+	Ops[0].Leader = true;
+	work.Push(0);
+	while (work.Size() > 0)
+	{
+		unsigned i;
+		work.Pop(i);
+		FOp &op = Ops[i];
+		int depth = op.Depth;
+
+		if (depth < Need(op) || depth + Grow(op) > REGION_MAXDEPTH)
+		{
+			op.Exit = true;
+			continue;
+		}
+		MaxDepth = std::max(MaxDepth, depth + Grow(op));
+		if (op.Kind == RK_Var && op.Scope == VS_Script)
+		{
+			MaxLocal = std::max(MaxLocal, op.Arg);
+		}
+
+		if (op.Kind != RK_Goto)
+		{
+			bool fresh = i + 1 < Ops.Size() && Ops[i + 1].Depth < 0;
+			op.FallExit = !Propagate(i + 1, depth + FallDelta(op));
+			if (fresh && !op.FallExit) work.Push(i + 1);
+		}
+		if (op.Kind == RK_Goto || op.Kind == RK_IfGoto || op.Kind == RK_IfNotGoto || op.Kind == RK_CaseGoto)
+		{
+			unsigned *target = OpIndex.CheckKey(op.Target);
+			int jumpdepth = op.Kind == RK_Goto ? depth : depth - 1;
+			if (target == nullptr)
+			{
+				op.JumpExit = true;
+			}
+			else
+			{
+				bool fresh = Ops[*target].Depth < 0;
+				op.JumpExit = !Propagate(*target, jumpdepth);
+				if (!op.JumpExit)
+				{
+					Ops[*target].Leader = true;
+					if (fresh) work.Push(*target);
+				}
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Code generation helpers
+//
+//==========================================================================
+
+// Adds the p-codes executed since the last flush to the runaway counter.
+void FACSTranslator::Flush()
+{
+	if (Pending > 0)
+	{
+		Build->Emit(OP_ADD_RK, RegRun, RegRun, Build->GetConstantInt(Pending));
+		Pending = 0;
+	}
+}
+
+void FACSTranslator::EmitExit(uint32_t ofs, int depth)
+{
+	for (int i = 0; i < depth; i++)
+	{
+		Build->Emit(OP_SW, RegStack, Slot[i], Build->GetConstantInt(i * sizeof(int32_t)));
+	}
+	Build->EmitLoadInt(RegTmp, ofs);
+	Build->Emit(OP_SW, RegState, RegTmp, Build->GetConstantInt(offsetof(FACSRegionState, Pc)));
+	Build->EmitLoadInt(RegTmp, depth);
+	Build->Emit(OP_SW, RegState, RegTmp, Build->GetConstantInt(offsetof(FACSRegionState, Depth)));
+	Build->Emit(OP_SW, RegState, RegRun, Build->GetConstantInt(offsetof(FACSRegionState, Runaway)));
+	Build->Emit(OP_RET, RET_FINAL, REGT_NIL, 0);
+}
+
+// Emits the JMP for the jump edge of an op. Backward jumps go through a
+// stub that checks the runaway counter.
+void FACSTranslator::EmitJump(unsigned from)
+{
+	const FOp &op = Ops[from];
+	size_t loc = Build->Emit(OP_JMP, 0);
+
+	if (op.JumpExit)
+	{
+		Exits.Push({ loc, op.Target, op.Kind == RK_Goto ? op.Depth : op.Depth - 1 });
+	}
+	else
+	{
+		unsigned target = *OpIndex.CheckKey(op.Target);
+		if (target <= from) BackEdges.Push({ loc, target });
+		else Forward.Push({ loc, target });
+	}
+}
+
+// dst = invert ? !(b <op> c) : (b <op> c)
+void FACSTranslator::EmitCond(int opcode, int b, int c, int dst, bool invert)
+{
+	Build->Emit(opcode, 1, b, c);
+	Build->Emit(OP_JMP, 2);
+	Build->Emit(OP_LI, dst, invert);
+	Build->Emit(OP_JMP, 1);
+	Build->Emit(OP_LI, dst, !invert);
+}
+
+void FACSTranslator::EmitBinary(int pcd, int dst, int a, int b)
+{
+	switch (pcd)
+	{
+	case PCD_ADD:			Build->Emit(OP_ADD_RR, dst, a, b); break;
+	case PCD_SUBTRACT:		Build->Emit(OP_SUB_RR, dst, a, b); break;
+	case PCD_MULTIPLY:		Build->Emit(OP_MUL_RR, dst, a, b); break;
+	case PCD_DIVIDE:		Build->Emit(OP_DIV_RR, dst, a, b); break;
+	case PCD_MODULUS:		Build->Emit(OP_MOD_RR, dst, a, b); break;
+	case PCD_ANDBITWISE:	Build->Emit(OP_AND_RR, dst, a, b); break;
+	case PCD_ORBITWISE:		Build->Emit(OP_OR_RR, dst, a, b); break;
+	case PCD_EORBITWISE:	Build->Emit(OP_XOR_RR, dst, a, b); break;
+	case PCD_LSHIFT:		Build->Emit(OP_SLL_RR, dst, a, b); break;
+	case PCD_RSHIFT:		Build->Emit(OP_SRA_RR, dst, a, b); break;
+	case PCD_EQ:			EmitCond(OP_EQ_R, a, b, dst, false); break;
+	case PCD_NE:			EmitCond(OP_EQ_R, a, b, dst, true); break;
+	case PCD_LT:			EmitCond(OP_LT_RR, a, b, dst, false); break;
+	case PCD_GT:			EmitCond(OP_LT_RR, b, a, dst, false); break;
+	case PCD_LE:			EmitCond(OP_LE_RR, a, b, dst, false); break;
+	case PCD_GE:			EmitCond(OP_LE_RR, b, a, dst, false); break;
+
+	case PCD_ANDLOGICAL:
+		EmitCond(OP_EQ_K, a, Build->GetConstantInt(0), RegCond, true);
+		EmitCond(OP_EQ_K, b, Build->GetConstantInt(0), dst, true);
+		Build->Emit(OP_AND_RR, dst, dst, RegCond);
+		break;
+
+	case PCD_ORLOGICAL:
+		Build->Emit(OP_OR_RR, RegCond, a, b);
+		EmitCond(OP_EQ_K, RegCond, Build->GetConstantInt(0), dst, true);
+		break;
+	}
+}
+
+// Division by zero stops the script, so leave that to the interpreter.
+void FACSTranslator::EmitZeroCheck(unsigned index, int reg)
+{
+	Flush();
+	Build->Emit(OP_EQ_K, 1, reg, Build->GetConstantInt(0));
+	Exits.Push({ Build->Emit(OP_JMP, 0), Ops[index].Ofs, Ops[index].Depth });
+}
+
+// Returns the pointer register to access a variable through.
+int FACSTranslator::VarAddress(const FOp &op, int &offset)
+{
+	offset = 0;
+	switch (op.Scope)
+	{
+	case VS_Script:
+		offset = op.Arg * sizeof(int32_t);
+		return RegLocals;
+
+	case VS_Map:
+		Build->Emit(OP_LP, RegVar, RegMapVars, Build->GetConstantInt(op.Arg * sizeof(int32_t *)));
+		return RegVar;
+
+	case VS_World:
+		Build->Emit(OP_LKP, RegVar, Build->GetConstantAddress(&ACS_WorldVars.Pointer()[op.Arg]));
+		return RegVar;
+
+	default:
+		Build->Emit(OP_LKP, RegVar, Build->GetConstantAddress(&ACS_GlobalVars.Pointer()[op.Arg]));
+		return RegVar;
+	}
+}
+
+//==========================================================================
+//
+// FACSTranslator :: EmitOp
+//
+//==========================================================================
+
+void FACSTranslator::EmitOp(unsigned index)
+{
+	const FOp &op = Ops[index];
+	const int d = op.Depth;
+	const int top = d > 0 ? Slot[d - 1] : -1;
+	const int below = d > 1 ? Slot[d - 2] : -1;
+
+	if ((op.Kind == RK_Binary || (op.Kind == RK_Var && op.VarOp == VO_Binary)) && (op.Pcd == PCD_DIVIDE || op.Pcd == PCD_MODULUS))
+	{
+		EmitZeroCheck(index, top);
+	}
+	Pending++;
+
+	switch (op.Kind)
+	{
+	case RK_Nop:
+	case RK_Drop:
+		break;
+
+	case RK_Push:
+		Build->EmitLoadInt(Slot[d], op.Arg);
+		break;
+
+	case RK_PushBytes:
+		for (int i = 0; i < op.Arg; i++)
+		{
+			Build->EmitLoadInt(Slot[d + i], Data[op.Target + i]);
+		}
+		break;
+
+	case RK_Dup:
+		Build->Emit(OP_MOVE, Slot[d], top);
+		break;
+
+	case RK_Swap:
+		Build->Emit(OP_MOVE, RegTmp, below);
+		Build->Emit(OP_MOVE, below, top);
+		Build->Emit(OP_MOVE, top, RegTmp);
+		break;
+
+	case RK_Unary:
+		if (op.Pcd == PCD_UNARYMINUS) Build->Emit(OP_NEG, top, top);
+		else if (op.Pcd == PCD_NEGATEBINARY) Build->Emit(OP_NOT, top, top);
+		else EmitCond(OP_EQ_K, top, Build->GetConstantInt(0), top, false);
+		break;
+
+	case RK_Binary:
+		EmitBinary(op.Pcd, below, below, top);
+		break;
+
+	case RK_Var:
+	{
+		int offset;
+		int addr = VarAddress(op, offset);
+		int konst = Build->GetConstantInt(offset);
+		switch (op.VarOp)
+		{
+		case VO_Assign:
+			Build->Emit(OP_SW, addr, top, konst);
+			break;
+
+		case VO_Push:
+			Build->Emit(OP_LW, Slot[d], addr, konst);
+			break;
+
+		case VO_Inc:
+		case VO_Dec:
+			Build->Emit(OP_LW, RegTmp, addr, konst);
+			Build->Emit(OP_ADD_RK, RegTmp, RegTmp, Build->GetConstantInt(op.VarOp == VO_Inc ? 1 : -1));
+			Build->Emit(OP_SW, addr, RegTmp, konst);
+			break;
+
+		default:
+			Build->Emit(OP_LW, RegTmp, addr, konst);
+			EmitBinary(op.Pcd, RegTmp, RegTmp, top);
+			Build->Emit(OP_SW, addr, RegTmp, konst);
+			break;
+		}
+		break;
+	}
+
+	case RK_Goto:
+		Flush();
+		EmitJump(index);
+		return;
+
+	case RK_IfGoto:
+	case RK_IfNotGoto:
+	case RK_CaseGoto:
+		Flush();
+		if (op.Kind == RK_CaseGoto)
+		{
+			Build->Emit(OP_EQ_K, 1, top, Build->GetConstantInt(op.Arg));
+		}
+		else
+		{
+			Build->Emit(OP_EQ_K, op.Kind == RK_IfNotGoto, top, Build->GetConstantInt(0));
+		}
+		EmitJump(index);
+		break;
+	}
+
+	if (op.FallExit)
+	{
+		Flush();
+		EmitExit(op.Next, d + FallDelta(op));
+	}
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Emit
+//
+//==========================================================================
+
+VMFunction *FACSTranslator::Emit()
+{
+	VMFunctionBuilder build(0);
+	Build = &build;
+
+	// The state pointer is the only argument, so it lands in the first
+	// pointer register.
+	RegState = build.Registers[REGT_POINTER].Get(1);
+	RegStack = build.Registers[REGT_POINTER].Get(1);
+	RegLocals = build.Registers[REGT_POINTER].Get(1);
+	RegMapVars = build.Registers[REGT_POINTER].Get(1);
+	RegVar = build.Registers[REGT_POINTER].Get(1);
+	for (int i = 0; i < MaxDepth; i++)
+	{
+		Slot[i] = build.Registers[REGT_INT].Get(1);
+	}
+	RegRun = build.Registers[REGT_INT].Get(1);
+	RegTmp = build.Registers[REGT_INT].Get(1);
+	RegCond = build.Registers[REGT_INT].Get(1);
+
+	build.Emit(OP_LP, RegStack, RegState, build.GetConstantInt(offsetof(FACSRegionState, Stack)));
+	build.Emit(OP_LP, RegLocals, RegState, build.GetConstantInt(offsetof(FACSRegionState, Locals)));
+	build.Emit(OP_LP, RegMapVars, RegState, build.GetConstantInt(offsetof(FACSRegionState, MapVars)));
+	build.Emit(OP_LW, RegRun, RegState, build.GetConstantInt(offsetof(FACSRegionState, Runaway)));
+
+	for (unsigned i = 0; i < Ops.Size(); i++)
+	{
+		FOp &op = Ops[i];
+		if (op.Depth < 0)
+		{
+			continue;
+		}
+		if (op.Leader)
+		{
+			Flush();
+		}
+		op.Addr = build.GetAddress();
+		if (op.Exit)
+		{
+			Flush();
+			EmitExit(op.Ofs, op.Depth);
+		}
+		else
+		{
+			EmitOp(i);
+		}
+	}
+	assert(Pending == 0);
+
+	for (auto &jump : Forward)
+	{
+		build.Backpatch(jump.Loc, Ops[jump.Op].Addr);
+	}
+	for (auto &jump : BackEdges)
+	{
+		build.BackpatchToHere(jump.Loc);
+		build.Emit(OP_LE_RK, 1, RegRun, build.GetConstantInt(REGION_RUNAWAY));
+		build.Backpatch(build.Emit(OP_JMP, 0), Ops[jump.Op].Addr);
+		EmitExit(Ops[jump.Op].Ofs, Ops[jump.Op].Depth);
+	}
+	for (auto &exit : Exits)
+	{
+		build.BackpatchToHere(exit.Loc);
+		EmitExit(exit.Ofs, exit.Depth);
+	}
+
+	TArray<PType *> rets, args;
+	args.Push(TypeVoidPtr);
+
+	auto func = new VMScriptFunction;
+	build.MakeFunction(func);
+	func->QualifiedName = func->PrintableName = "ACS code";
+	func->Proto = NewPrototype(rets, args);
+	func->ArgFlags.Push(0);
+	func->NumArgs = 1;
+	func->RegTypes = ACSRegionRegTypes;
+	Build = nullptr;
+	return func;
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Translate
+//
+// Returns nullptr if the code at start is not worth translating.
+//
+//==========================================================================
+
+FACSRegion *FACSTranslator::Translate(uint32_t start)
+{
+	End = start;
+	while (Ops.Size() < REGION_MAXOPS)
+	{
+		FOp op;
+		if (!Decode(End, op))
+		{
+			break;
+		}
+		OpIndex[End] = Ops.Size();
+		Ops.Push(op);
+		End = op.Next;
+	}
+	if (Ops.Size() < REGION_MINOPS)
+	{
+		return nullptr;
+	}
+
+	Analyze();
+
+	unsigned count = 0;
+	for (auto &op : Ops)
+	{
+		if (op.Depth >= 0 && !op.Exit && op.Kind != RK_Nop) count++;
+	}
+	if (count < REGION_MINOPS)
+	{
+		return nullptr;
+	}
+
+	uint32_t hash = SuperFastHash((const char *)Data + start, End - start) ^ (start * 31) ^ Format;
+	FACSRegion **chain = &ACSRegionCache[hash];
+	FACSRegion *region;
+	for (region = *chain; region != nullptr; region = region->Next)
+	{
+		if (region->Start == start && region->Format == Format && region->Code.Size() == End - start &&
+			!memcmp(region->Code.Data(), Data + start, End - start))
+		{
+			break;
+		}
+	}
+	if (region == nullptr)
+	{
+		region = new FACSRegion;
+		region->Code.Resize(End - start);
+		memcpy(region->Code.Data(), Data + start, End - start);
+		region->Start = start;
+		region->Format = Format;
+		region->MaxDepth = MaxDepth;
+		region->MaxLocal = MaxLocal;
+		region->Func = nullptr;
+		region->Next = *chain;
+		*chain = region;
+	}
+	if (region->Func == nullptr)
+	{
+		// The pointer is cleared when the VM shuts down and all functions get deleted.
+		region->Func = Emit();
+		PClass::FunctionPtrList.Push(&region->Func);
+	}
+	return region;
+}
+
+//==========================================================================
+//
+// FBehavior :: FindRegion
+//
+// Returns the translated region starting at pc, translating it once the
+// interpreter has come by often enough.
+//
+//==========================================================================
+
+FACSRegion *FBehavior::FindRegion(int *pc)
+{
+	uint32_t ofs = PC2Ofs(pc);
+	if (ofs >= (uint32_t)DataSize)
+	{
+		return nullptr;
+	}
+	if (RegionVisits.Size() == 0)
+	{
+		RegionVisits.Resize(DataSize);
+		memset(RegionVisits.Data(), 0, DataSize);
+	}
+
+	uint8_t &visits = RegionVisits[ofs];
+	if (visits == REGION_FOUND)
+	{
+		return Regions[ofs];
+	}
+	if (visits == REGION_NONE || ++visits < REGION_HOT)
+	{
+		return nullptr;
+	}
+
+	FACSRegion *region = FACSTranslator(Data, DataSize, Format).Translate(ofs);
+	if (region == nullptr)
+	{
+		visits = REGION_NONE;
+		return nullptr;
+	}
+	Regions[ofs] = region;
+	visits = REGION_FOUND;
+	return region;
+}
+
+//==========================================================================
+//
+// ACS_RunRegion
+//
+// Runs the translated code at pc, if there is any. Returns false if the
+// interpreter has to execute the p-code at pc itself.
+//
+//==========================================================================
+
+static bool ACS_RunRegion(FBehavior *module, int *&pc, FACSStackMemory &Stack, int &sp, ACSLocalVariables &locals, unsigned int &runaway)
+{
+	FACSRegion *region = module->FindRegion(pc);
+	if (region == nullptr || region->Func == nullptr ||
+		sp + region->MaxDepth > STACK_SIZE || region->MaxLocal >= (int)locals.GetCount())
+	{
+		return false;
+	}
+
+	FACSRegionState state = { Stack.Pointer() + sp, const_cast<int32_t *>(locals.GetPointer()), module->MapVars.Pointer(), 0, 0, (int32_t)runaway };
+	VMValue param = &state;
+	VMCall(region->Func, &param, 1, nullptr, 0);
+
+	if ((unsigned int)state.Runaway == runaway)
+	{
+		// Nothing got executed, e.g. a division by zero right at the start.
+		return false;
+	}
+	pc = module->Ofs2PC(state.Pc);
+	sp += state.Depth;
+	runaway = state.Runaway;
+	return true;
+}
+
 static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory& Stack, int &sp, bool ranged)
 {
 	if (ranged)
@@ -6871,29 +7808,20 @@ PClass *DLevelScript::GetClassForIndex(int index) const
 	return PClass::FindActor(Level->Behaviors.LookupString(index));
 }
 
-int DLevelScript::RunScript()
+//==========================================================================
+//
+// DLevelScript :: UpdateWaitState
+//
+// Advances the state of a script that is waiting for something. Returns
+// true if the script has to enter the interpreter this tic. Scripts that
+// are delayed, suspended or still waiting can be skipped without setting
+// up an interpreter frame.
+//
+//==========================================================================
+
+bool DLevelScript::UpdateWaitState()
 {
 	DACSThinker *controller = Level->ACSThinker;
-	ACSLocalVariables locals(Localvars);
-	ACSLocalArrays noarrays;
-	ACSLocalArrays *localarrays = &noarrays;
-	ScriptFunction *activeFunction = NULL;
-	FRemapTable *translation = 0;
-	int resultValue = 1;
-	int transi = -1;
-
-	if (InModuleScriptNumber >= 0)
-	{
-		ScriptPtr *ptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
-		assert(ptr != NULL);
-		if (ptr != NULL)
-		{
-			localarrays = &ptr->LocalArrays;
-		}
-	}
-
-	// Hexen truncates all special arguments to bytes (only when using an old MAPINFO and old ACS format
-	const int specialargmask = ((Level->flags2 & LEVEL2_HEXENHACK) && activeBehavior->GetFormat() == ACS_Old) ? 255 : ~0;
 
 	switch (state)
 	{
@@ -6913,7 +7841,7 @@ int DLevelScript::RunScript()
 		while ((secnum = it.Next()) >= 0)
 		{
 			if (Level->sectors[secnum].floordata || Level->sectors[secnum].ceilingdata)
-				return resultValue;
+				return false;
 		}
 
 		// If we got here, none of the tagged sectors were busy
@@ -6938,7 +7866,7 @@ int DLevelScript::RunScript()
 	case SCRIPT_ScriptWait:
 		// Wait for a script to stop running, then enter state running
 		if (controller->RunningScripts.CheckKey(statedata) != NULL)
-			return resultValue;
+			return false;
 
 		state = SCRIPT_Running;
 		PutFirst ();
@@ -6948,6 +7876,36 @@ int DLevelScript::RunScript()
 		break;
 	}
 
+	return state == SCRIPT_Running || state == SCRIPT_PleaseRemove;
+}
+
+int DLevelScript::RunScript()
+{
+	DACSThinker *controller = Level->ACSThinker;
+	ACSLocalVariables locals(Localvars);
+	ACSLocalArrays noarrays;
+	ACSLocalArrays *localarrays = &noarrays;
+	ScriptFunction *activeFunction = NULL;
+	FRemapTable *translation = 0;
+	int resultValue = 1;
+	int transi = -1;
+
+	if (!UpdateWaitState())
+		return resultValue;
+
+	if (InModuleScriptNumber >= 0)
+	{
+		ScriptPtr *ptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
+		assert(ptr != NULL);
+		if (ptr != NULL)
+		{
+			localarrays = &ptr->LocalArrays;
+		}
+	}
+
+	// Hexen truncates all special arguments to bytes (only when using an old MAPINFO and old ACS format
+	const int specialargmask = ((Level->flags2 & LEVEL2_HEXENHACK) && activeBehavior->GetFormat() == ACS_Old) ? 255 : ~0;
+
 	FACSStack stackobj;
 	FACSStackMemory& Stack = stackobj.buffer;
 	int &sp = stackobj.sp;
@@ -6971,6 +7929,11 @@ int DLevelScript::RunScript()
 			break;
 		}
 
+		if (acs_translate && ACS_RunRegion(activeBehavior, pc, Stack, sp, locals, runaway))
+		{
+			continue;
+		}
+
 		if (fmt == ACS_LittleEnhanced)
 		{
 			pcd = getbyte(pc);
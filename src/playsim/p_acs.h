@@ -200,6 +200,11 @@ public:
 		return memory;
 	}
 
+	size_t GetCount() const
+	{
+		return count;
+	}
+
 private:
 	int32_t *memory;
 	size_t count;
@@ -344,6 +349,8 @@ enum
 
 enum ACSFormat { ACS_Old, ACS_Enhanced, ACS_LittleEnhanced, ACS_Unknown };
 
+struct FACSRegion;
+
 
 class FBehavior
 {
@@ -379,6 +386,7 @@ public:
 	ACSProfileInfo *GetFunctionProfileData(int index) { return index >= 0 && index < NumFunctions ? &FunctionProfileData[index] : NULL; }
 	ACSProfileInfo *GetFunctionProfileData(ScriptFunction *func) { return GetFunctionProfileData((int)(func - (ScriptFunction *)Functions)); }
 	const char *LookupString (uint32_t index, bool forprint = false) const;
+	FACSRegion *FindRegion (int *pc);
 
 	BoundsCheckingArray<int32_t *, NUM_MAPVARS> MapVars;
 
@@ -410,6 +418,8 @@ private:
 	TArray<FBehavior *> Imports;
 	char ModuleName[9];
 	TArray<int> JumpPoints;
+	TArray<uint8_t> RegionVisits;				// per p-code offset: visit count or REGION_NONE/REGION_FOUND
+	TMap<uint32_t, FACSRegion *> Regions;		// translated code, owned by the global region cache
 
 	void LoadScriptsDirectory ();
 
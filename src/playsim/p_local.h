@@ -280,6 +280,8 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_BeginSightBatch (FLevelLocals *Level);
+void	P_EndSightBatch ();
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
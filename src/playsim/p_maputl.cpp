@@ -61,6 +61,7 @@
 
 
 #include <stdlib.h>
+#include <algorithm>
 
 
 #include "m_bbox.h"
@@ -433,6 +434,74 @@ bool AActor::FixMapthingPos()
 	return success;
 }
 
+//==========================================================================
+//
+// Sector list caching
+//
+// Rebuilding an actor's sector lists means checking all lines around it,
+// even if it only moved a tiny bit. In the common case of an actor in open
+// space the lists only contain its own sector. For those a square region
+// around the actor is checked once. As long as the actor's box stays inside
+// it and no line leading to another sector crosses it, the lists cannot
+// change and are kept as they are. Lines that only border the actor's own
+// sector, like the walls it is standing against, do not matter, because a
+// rebuild would only add that same sector again.
+//
+//==========================================================================
+
+static const double SECLIST_MARGIN = 32.;
+
+static double SectorListRadius(AActor *thing)
+{
+	return thing->renderradius >= 0 ? thing->RenderRadius() : thing->radius;
+}
+
+static bool IsSingleSectorList(msecnode_t *list, sector_t *sector)
+{
+	return list != nullptr && list->m_sector == sector && list->m_tnext == nullptr;
+}
+
+static bool P_CanKeepSectorLists(AActor *thing, FLinkContext *ctx, sector_t *sector)
+{
+	if (thing->SectorListExtent <= 0)
+		return false;
+
+	double radius = SectorListRadius(thing);
+	if (fabs(thing->X() - thing->SectorListCenter.X) + radius > thing->SectorListExtent ||
+		fabs(thing->Y() - thing->SectorListCenter.Y) + radius > thing->SectorListExtent)
+		return false;
+
+	if (!IsSingleSectorList(ctx->sector_list, sector))
+		return false;
+	return thing->renderradius >= 0 ? IsSingleSectorList(ctx->render_list, sector) : ctx->render_list == nullptr;
+}
+
+static void P_UpdateSectorListExtent(AActor *thing, sector_t *sector)
+{
+	thing->SectorListExtent = 0;
+
+	// Polyobject lines move, so the region could not be trusted.
+	if (thing->Level->Polyobjects.Size() > 0 || !IsSingleSectorList(thing->touching_sectorlist, sector))
+		return;
+	if (thing->renderradius >= 0 && !IsSingleSectorList(thing->touching_rendersectors, sector))
+		return;
+
+	double extent = SectorListRadius(thing) + SECLIST_MARGIN;
+	FBoundingBox box(thing->X(), thing->Y(), extent);
+	FBlockLinesIterator it(thing->Level, box);
+	line_t *ld;
+
+	while ((ld = it.Next()))
+	{
+		if (ld->frontsector == sector && (ld->backsector == nullptr || ld->backsector == sector))
+			continue;
+		if (inRange(box, ld) && BoxOnLineSide(box, ld) == -1)
+			return;
+	}
+	thing->SectorListCenter = thing->Pos().XY();
+	thing->SectorListExtent = extent;
+}
+
 //==========================================================================
 //
 // P_SetThingPosition
@@ -494,12 +563,23 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 		// When a node is deleted, its sector links (the links starting
 		// at sector_t->touching_thinglist) are broken. When a node is
 		// added, new sector links are created.
-		touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist);	// Attach to thing
-		if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings);
+		if (ctx != nullptr && P_CanKeepSectorLists(this, ctx, sector))
+		{
+			// A rebuild would have bumped validcount, so do the same in case a caller relies on it.
+			validcount++;
+			touching_sectorlist = ctx->sector_list;
+			touching_rendersectors = ctx->render_list;
+		}
 		else
 		{
-			touching_rendersectors = nullptr;
-			if (ctx != nullptr) P_DelSeclist(ctx->render_list, &sector_t::touching_renderthings);
+			touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist);	// Attach to thing
+			if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings);
+			else
+			{
+				touching_rendersectors = nullptr;
+				if (ctx != nullptr) P_DelSeclist(ctx->render_list, &sector_t::touching_renderthings);
+			}
+			P_UpdateSectorListExtent(this, sector);
 		}
 	}
 
@@ -1395,22 +1475,25 @@ void FPathTraverse::AddThingIntercepts (int bx, int by, FBlockThingsIterator &it
 
 intercept_t *FPathTraverse::Next()
 {
-	intercept_t *in = NULL;
+	// Sort this trace's intercepts once, instead of searching the whole list for
+	// the closest one on every call. The sort is stable so intercepts at the same
+	// distance are returned in the order they were found, like the search did.
+	if (!intercepts_sorted)
+	{
+		std::stable_sort(intercepts.Data() + intercept_index, intercepts.Data() + intercepts.Size(),
+			[](const intercept_t &a, const intercept_t &b) { return a.frac < b.frac; });
+		intercepts_sorted = true;
+	}
 
-	double dist = FLT_MAX;
-	for (unsigned scanpos = intercept_index; scanpos < intercepts.Size (); scanpos++)
+	while (intercept_next < intercepts.Size())
 	{
-		intercept_t *scan = &intercepts[scanpos];
-		if (scan->frac < dist && !scan->done)
-		{
-			dist = scan->frac;
-			in = scan;
-		}
+		intercept_t *in = &intercepts[intercept_next++];
+		if (in->done) continue;
+		if (in->frac > 1.) return NULL;	// checked everything in range
+		in->done = true;
+		return in;
 	}
-	
-	if (dist > 1. || in == NULL) return NULL;	// checked everything in range			
-	in->done = true;
-	return in;
+	return NULL;
 }
 
 //===========================================================================
@@ -1461,6 +1544,8 @@ void FPathTraverse::init(double x1, double y1, double x2, double y2, int flags,
 
 	validcount++;
 	intercept_index = intercepts.Size();
+	intercept_next = intercept_index;
+	intercepts_sorted = false;
 	Startfrac = startfrac;
 
 	if (flags & PT_DELTA)
@@ -374,7 +374,9 @@ protected:
 	double Startfrac;
 	unsigned int intercept_index;
 	unsigned int intercept_count;
+	unsigned int intercept_next;
 	unsigned int count;
+	bool intercepts_sorted;
 
 	virtual void AddLineIntercepts(int bx, int by);
 	virtual void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible);
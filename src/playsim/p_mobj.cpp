@@ -392,6 +392,8 @@ void AActor::PostSerialize()
 {
 	touching_sectorlist = nullptr;
 	touching_rendersectors = nullptr;
+	SectorListExtent = 0;
+	OldRenderPos = { FLT_MAX, FLT_MAX, FLT_MAX };
 	LinkToWorld(nullptr, false, Sector);
 
 	AddToHash();
@@ -3702,6 +3704,109 @@ DEFINE_ACTION_FUNCTION(AActor, CheckPortalTransition)
 	return 0;
 }
 
+//==========================================================================
+//
+// P_IsIdleTick
+//
+// Returns true if running the full movement code on this actor this tic
+// would not change anything. This is only the case for an actor with no
+// velocity resting on a flat, static floor without any water, portals,
+// scrollers, effects or pending state changes. Such actors only need their
+// state timer advanced, which keeps the result identical to the full path.
+//
+//==========================================================================
+
+CVAR(Bool, sv_fastidleactors, true, CVAR_SERVERINFO)
+
+static bool P_IsIdleTick(AActor *mo)
+{
+	if (!sv_fastidleactors || mo->player != nullptr || mo->Inventory != nullptr)
+		return false;
+
+	if ((mo->flags & (MF_UNMORPHED | MF_MISSILE | MF_SKULLFLY | MF_STEALTH)) ||
+		(mo->flags2 & (MF2_WINDTHRUST | MF2_BLASTED)) ||
+		(mo->flags4 & (MF4_VFRICTION | MF4_SCROLLMOVE)) ||
+		(mo->flags5 & MF5_NOINTERACTION) ||
+		(mo->flags7 & MF7_HANDLENODELAY) ||
+		(mo->flags8 & MF8_INSCROLLSEC) ||
+		(mo->effects & (FX_ROCKET | FX_GRENADE | FX_VISIBILITYPULSE)))
+		return false;
+
+	// Unarmed mines get armed when they come to rest
+	if ((mo->flags6 & MF6_TOUCHY) && !(mo->flags6 & MF6_ARMED))
+		return false;
+
+	// The next state change has to happen in the full path
+	if (mo->tics != -1 && mo->tics <= 1)
+		return false;
+
+	if (!mo->Vel.isZero() || mo->Z() != mo->floorz || mo->PoisonDurationReceived != 0)
+		return false;
+
+	// Resting on the floor calls Crash, which must already have happened
+	if (!(mo->flags6 & MF6_DONTCORPSE) && ((mo->flags & MF_CORPSE) || (mo->flags6 & MF6_KILLED)) &&
+		!(mo->flags3 & MF3_CRASHED) && !(mo->flags & MF_ICECORPSE))
+		return false;
+
+	if (mo->isFrozen() || (mo->Level->BotInfo.botnum && !demoplayback))
+		return false;
+
+	sector_t *sec = mo->Sector;
+	if ((sec->Flags & SECF_KILLMONSTERS) || (sec->MoreFlags & SECMF_UNDERWATER) || sec->GetHeightSec() != nullptr ||
+		sec->e->XFloor.ffloors.Size() > 0 || !sec->PortalBlocksMovement(sector_t::ceiling) || !sec->PortalBlocksMovement(sector_t::floor))
+		return false;
+
+	if (mo->waterlevel != 0 || mo->waterdepth != 0 || mo->boomwaterlevel != 0)
+		return false;
+
+	// Solid actors slide down steep slopes
+	if ((mo->flags & MF_SOLID) && !(mo->flags & (MF_NOCLIP | MF_NOGRAVITY | MF_NOBLOCKMAP)))
+	{
+		sector_t *floorsec = mo->floorsector;
+		if (floorsec->floorplane.isSlope() || floorsec->e->XFloor.ffloors.Size() > 0)
+			return false;
+	}
+
+	return true;
+}
+
+//==========================================================================
+//
+// P_CheckNightmareRespawn
+//
+//==========================================================================
+
+static void P_CheckNightmareRespawn(AActor *mo)
+{
+	if (mo->tics == -1 || mo->state->GetCanRaise())
+	{
+		int respawn_monsters = G_SkillProperty(SKILLP_Respawn);
+		// check for nightmare respawn
+		if (!(mo->flags5 & MF5_ALWAYSRESPAWN))
+		{
+			if (!respawn_monsters || !(mo->flags3 & MF3_ISMONSTER) || (mo->flags2 & MF2_DORMANT) || (mo->flags5 & MF5_NEVERRESPAWN))
+				return;
+
+			int limit = G_SkillProperty (SKILLP_RespawnLimit);
+			if (limit > 0 && mo->skillrespawncount >= limit)
+				return;
+		}
+
+		mo->movecount++;
+
+		if (mo->movecount < respawn_monsters)
+			return;
+
+		if (mo->Level->time & 31)
+			return;
+
+		if (pr_nightmarerespawn() > 4)
+			return;
+
+		P_NightmareRespawn (mo);
+	}
+}
+
 //
 // P_MobjThinker
 //
@@ -3740,6 +3845,21 @@ void AActor::Tick ()
 		return;
 	}
 
+	if (P_IsIdleTick(this))
+	{
+		// Only do what the full path below does for an actor at rest.
+		BlockingMobj = nullptr;
+		MovementBlockingLine = nullptr;
+		Blocking3DFloor = nullptr;
+		BlockingFloor = nullptr;
+		BlockingCeiling = nullptr;
+
+		UpdateRenderSectorList();
+		if (tics != -1) tics--;
+		P_CheckNightmareRespawn(this);
+		return;
+	}
+
 	if (flags5 & MF5_NOINTERACTION)
 	{
 		// only do the minimally necessary things here to save time:
@@ -4266,33 +4386,7 @@ void AActor::Tick ()
 		}
 	}
 
-	if (tics == -1 || state->GetCanRaise())
-	{
-		int respawn_monsters = G_SkillProperty(SKILLP_Respawn);
-		// check for nightmare respawn
-		if (!(flags5 & MF5_ALWAYSRESPAWN))
-		{
-			if (!respawn_monsters || !(flags3 & MF3_ISMONSTER) || (flags2 & MF2_DORMANT) || (flags5 & MF5_NEVERRESPAWN))
-				return;
-
-			int limit = G_SkillProperty (SKILLP_RespawnLimit);
-			if (limit > 0 && skillrespawncount >= limit)
-				return;
-		}
-
-		movecount++;
-
-		if (movecount < respawn_monsters)
-			return;
-
-		if (Level->time & 31)
-			return;
-
-		if (pr_nightmarerespawn() > 4)
-			return;
-
-		P_NightmareRespawn (this);
-	}
+	P_CheckNightmareRespawn(this);
 }
 
 //==========================================================================
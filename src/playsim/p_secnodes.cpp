@@ -382,15 +382,20 @@ portnode_t *P_AddPortalnode(FLinePortal *s, AActor *thing, portnode_t *nextnode)
 void AActor::UpdateRenderSectorList()
 {
 	static const double SPRITE_SPACE = 64.;
-	if (Pos() != OldRenderPos && !(flags & MF_NOSECTOR))
+	if (flags & MF_NOSECTOR)
+		return;
+
+	// The line portal list only depends on the horizontal position, so it is kept until the actor moves.
+	double portalradius = min(radius*1.5, 128.);	// Don't go further than 128 map units, even for large actors
+	if (Pos().XY() != OldRenderPos.XY() || portalradius != OldRenderRadius)
 	{
-		// Only check if the map contains line portals
 		ClearRenderLineList();
-		if (Level->PortalBlockmap.containsLines && Pos().XY() != OldRenderPos.XY())
+		// Only check if the map contains line portals
+		if (Level->PortalBlockmap.containsLines)
 		{
 			int bx = Level->blockmap.GetBlockX(X());
 			int by = Level->blockmap.GetBlockY(Y());
-			FBoundingBox bb(X(), Y(), min(radius*1.5, 128.));	// Don't go further than 128 map units, even for large actors
+			FBoundingBox bb(X(), Y(), portalradius);
 			// Are there any portals near the actor's position?
 			if (Level->blockmap.isValidBlock(bx, by) && Level->PortalBlockmap(bx, by).neighborContainsLines)
 			{
@@ -405,30 +410,60 @@ void AActor::UpdateRenderSectorList()
 				}
 			}
 		}
-		sector_t *sec = Sector;
-		double lasth = -FLT_MAX;
+		OldRenderPos = Pos();
+		OldRenderRadius = portalradius;
+	}
+
+	// Sector portal planes can move, so this list is always checked. Nodes for
+	// sectors that are still touched are kept, like P_CreateSecNodeList does.
+	if (Sector->PortalBlocksMovement(sector_t::ceiling) && Sector->PortalBlocksMovement(sector_t::floor))
+	{
 		ClearRenderSectorList();
-		while (!sec->PortalBlocksMovement(sector_t::ceiling))
+		return;
+	}
+
+	for (msecnode_t *node = touching_sectorportallist; node; node = node->m_tnext)
+	{
+		node->m_thing = nullptr;
+	}
+
+	sector_t *sec = Sector;
+	double lasth = -FLT_MAX;
+	while (!sec->PortalBlocksMovement(sector_t::ceiling))
+	{
+		double planeh = sec->GetPortalPlaneZ(sector_t::ceiling);
+		if (planeh <= lasth) break;	// broken setup.
+		if (Top() + SPRITE_SPACE < planeh) break;
+		lasth = planeh;
+		DVector2 newpos = Pos().XY() + sec->GetPortalDisplacement(sector_t::ceiling);
+		sec = sec->Level->PointInSector(newpos);
+		touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
+	}
+	sec = Sector;
+	lasth = FLT_MAX;
+	while (!sec->PortalBlocksMovement(sector_t::floor))
+	{
+		double planeh = sec->GetPortalPlaneZ(sector_t::floor);
+		if (planeh >= lasth) break;	// broken setup.
+		if (Z() - SPRITE_SPACE > planeh) break;
+		lasth = planeh;
+		DVector2 newpos = Pos().XY() + sec->GetPortalDisplacement(sector_t::floor);
+		sec = sec->Level->PointInSector(newpos);
+		touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
+	}
+
+	msecnode_t *node = touching_sectorportallist;
+	while (node)
+	{
+		if (node->m_thing == nullptr)
 		{
-			double planeh = sec->GetPortalPlaneZ(sector_t::ceiling);
-			if (planeh <= lasth) break;	// broken setup.
-			if (Top() + SPRITE_SPACE < planeh) break;
-			lasth = planeh;
-			DVector2 newpos = Pos().XY() + sec->GetPortalDisplacement(sector_t::ceiling);
-			sec = sec->Level->PointInSector(newpos);
-			touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
+			if (node == touching_sectorportallist)
+				touching_sectorportallist = node->m_tnext;
+			node = P_DelSecnode(node, &sector_t::sectorportal_thinglist);
 		}
-		sec = Sector;
-		lasth = FLT_MAX;
-		while (!sec->PortalBlocksMovement(sector_t::floor))
+		else
 		{
-			double planeh = sec->GetPortalPlaneZ(sector_t::floor);
-			if (planeh >= lasth) break;	// broken setup.
-			if (Z() - SPRITE_SPACE > planeh) break;
-			lasth = planeh;
-			DVector2 newpos = Pos().XY() + sec->GetPortalDisplacement(sector_t::floor);
-			sec = sec->Level->PointInSector(newpos);
-			touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
+			node = node->m_tnext;
 		}
 	}
 }
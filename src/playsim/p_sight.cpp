@@ -21,6 +21,7 @@
 //-----------------------------------------------------------------------------
 //
 #include <assert.h>
+#include <memory>
 
 #include "doomdef.h"
 
@@ -36,10 +37,16 @@
 
 #include "g_levellocals.h"
 #include "actorinlines.h"
+#include "c_cvars.h"
+#include "workerpool.h"
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
 
+// This is part of the game rules: a batched check may see a slightly older
+// world than a serial one, so all peers and demos must agree on it.
+CVAR(Bool, sv_parallelsight, true, CVAR_SERVERINFO)
+
 /*
 ==============================================================================
 
@@ -87,12 +94,47 @@ struct SightTask
 };
 
 
-static TArray<intercept_t> intercepts (128);
-static TArray<SightTask> portals(32);
+//==========================================================================
+//
+// Scratch state of a sight check. The playsim thread uses MainSight, which
+// marks lines through validcount like all other map iterators. Contexts of
+// worker threads keep their own marks instead, since they must not write
+// to the level.
+//
+//==========================================================================
+
+struct SightContext
+{
+	TArray<intercept_t> intercepts;
+	TArray<SightTask> portals;
+	int *counts;
+
+	bool Threaded = false;
+	int MarkCount = 0;
+	TArray<int> LineMarks;
+	TArray<int> PolyMarks;
+	int LocalCounts[6] = {};
+
+	SightContext(int *c) : intercepts(128), portals(32), counts(c) {}
+
+	SightContext(FLevelLocals *Level) : intercepts(128), portals(32), counts(LocalCounts), Threaded(true)
+	{
+		Prepare(Level);
+	}
+
+	void Prepare(FLevelLocals *Level)
+	{
+		if (LineMarks.Size() < Level->lines.Size()) LineMarks.AppendFill(0, Level->lines.Size() - LineMarks.Size());
+		if (PolyMarks.Size() < Level->Polyobjects.Size()) PolyMarks.AppendFill(0, Level->Polyobjects.Size() - PolyMarks.Size());
+	}
+};
+
+static SightContext MainSight(sightcounts);
 
 class SightCheck
 {
 	FLevelLocals *Level;
+	SightContext &ctx;
 	DVector3 sightstart;
 	DVector2 sightend;
 	double Startfrac;
@@ -117,7 +159,7 @@ class SightCheck
 	bool LineBlocksSight(line_t *ld);
 
 public:
-	SightCheck(FLevelLocals *l)
+	SightCheck(FLevelLocals *l, SightContext &c) : ctx(c)
 	{
 		Level = l;
 	}
@@ -279,16 +321,16 @@ bool SightCheck::PTR_SightTraverse (intercept_t *in)
 
 		if (portaldir != sector_t::floor && (open.portalflags & SO_TOPBACK) && !(open.portalflags & SO_TOPFRONT))
 		{
-			portals.Push({ in->frac, topslope, bottomslope, sector_t::ceiling, backsec->GetOppositePortalGroup(sector_t::ceiling) });
+			ctx.portals.Push({ in->frac, topslope, bottomslope, sector_t::ceiling, backsec->GetOppositePortalGroup(sector_t::ceiling) });
 		}
 		if (portaldir != sector_t::ceiling && (open.portalflags & SO_BOTTOMBACK) && !(open.portalflags & SO_BOTTOMFRONT))
 		{
-			portals.Push({ in->frac, topslope, bottomslope, sector_t::floor, backsec->GetOppositePortalGroup(sector_t::floor) });
+			ctx.portals.Push({ in->frac, topslope, bottomslope, sector_t::floor, backsec->GetOppositePortalGroup(sector_t::floor) });
 		}
 	}
 	if (lport != nullptr && lport->mDestination != nullptr)
 	{
-		portals.Push({ in->frac, topslope, bottomslope, portaldir, lport->mDestination->frontsector->PortalGroup });
+		ctx.portals.Push({ in->frac, topslope, bottomslope, portaldir, lport->mDestination->frontsector->PortalGroup });
 		return false;
 	}
 
@@ -434,11 +476,23 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 {
 	divline_t dl;
 
-	if (ld->validcount == validcount)
+	if (ctx.Threaded)
 	{
-		return true;
+		int &mark = ctx.LineMarks[ld->Index()];
+		if (mark == ctx.MarkCount)
+		{
+			return true;
+		}
+		mark = ctx.MarkCount;
+	}
+	else
+	{
+		if (ld->validcount == validcount)
+		{
+			return true;
+		}
+		ld->validcount = validcount;
 	}
-	ld->validcount = validcount;
 	if (P_PointOnDivlineSide (ld->v1->fPos(), &Trace) ==
 		P_PointOnDivlineSide (ld->v2->fPos(), &Trace))
 	{
@@ -456,12 +510,12 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 		if (LineBlocksSight(ld)) return false;
 	}
 
-	sightcounts[3]++;
+	ctx.counts[3]++;
 	// store the line for later intersection testing
 	intercept_t newintercept;
 	newintercept.isaline = true;
 	newintercept.d.line = ld;
-	intercepts.Push (newintercept);
+	ctx.intercepts.Push (newintercept);
 
 	return true;
 }
@@ -495,9 +549,20 @@ int SightCheck::P_SightBlockLinesIterator (int x, int y)
 	{
 		if (polyLink->polyobj)
 		{ // only check non-empty links
-			if (polyLink->polyobj->validcount != validcount)
+			bool checked;
+			if (ctx.Threaded)
 			{
+				int &mark = ctx.PolyMarks[unsigned(polyLink->polyobj - &Level->Polyobjects[0])];
+				checked = mark == ctx.MarkCount;
+				mark = ctx.MarkCount;
+			}
+			else
+			{
+				checked = polyLink->polyobj->validcount == validcount;
 				polyLink->polyobj->validcount = validcount;
+			}
+			if (!checked)
+			{
 				for (i = 0; i < polyLink->polyobj->Linedefs.Size(); i++)
 				{
 					if (!P_SightCheckLine(polyLink->polyobj->Linedefs[i]))
@@ -540,6 +605,7 @@ bool SightCheck::P_SightTraverseIntercepts ()
 	unsigned scanpos;
 	divline_t dl;
 
+	auto &intercepts = ctx.intercepts;
 	count = intercepts.Size ();
 //
 // calculate intercept distance
@@ -627,8 +693,9 @@ bool SightCheck::P_SightPathTraverse ()
 	int mapx, mapy, mapxstep, mapystep;
 	int count;
 
-	validcount++;
-	intercepts.Clear ();
+	if (ctx.Threaded) ctx.MarkCount++;
+	else validcount++;
+	ctx.intercepts.Clear ();
 	x1 = sightstart.X + Startfrac * Trace.dx;
 	y1 = sightstart.Y + Startfrac * Trace.dy;
 	x2 = sightend.X;
@@ -660,11 +727,11 @@ bool SightCheck::P_SightPathTraverse ()
 	// We also must check if the starting sector contains  portals, and start sight checks in those as well.
 	if (portaldir != sector_t::floor && checkceiling && !lastsector->PortalBlocksSight(sector_t::ceiling))
 	{
-		portals.Push({ 0, topslope, bottomslope, sector_t::ceiling, lastsector->GetOppositePortalGroup(sector_t::ceiling) });
+		ctx.portals.Push({ 0, topslope, bottomslope, sector_t::ceiling, lastsector->GetOppositePortalGroup(sector_t::ceiling) });
 	}
 	if (portaldir != sector_t::ceiling && checkfloor && !lastsector->PortalBlocksSight(sector_t::floor))
 	{
-		portals.Push({ 0, topslope, bottomslope, sector_t::floor, lastsector->GetOppositePortalGroup(sector_t::floor) });
+		ctx.portals.Push({ 0, topslope, bottomslope, sector_t::floor, lastsector->GetOppositePortalGroup(sector_t::floor) });
 	}
 
 	x1 -= Level->blockmap.bmaporgx;
@@ -760,7 +827,7 @@ bool SightCheck::P_SightPathTraverse ()
 		itres = P_SightBlockLinesIterator(mapx, mapy);
 		if (itres == 0)
 		{
-			sightcounts[1]++;
+			ctx.counts[1]++;
 			return false;	// early out
 		}
 
@@ -771,7 +838,7 @@ bool SightCheck::P_SightPathTraverse ()
 		switch (((xs_FloorToInt(yintercept) == mapy) << 1) | (xs_FloorToInt(xintercept) == mapx))
 		{
 		case 0:		// neither xintercept nor yintercept match!
-sightcounts[5]++;
+ctx.counts[5]++;
 			// Continuing won't make things any better, so we might as well stop right here
 			return false;
 
@@ -790,7 +857,7 @@ sightcounts[5]++;
 			break;
 
 		case 3:		// xintercept and yintercept both match
-			sightcounts[4]++;
+			ctx.counts[4]++;
 			// The trace is exiting a block through its corner. Not only does the block
 			// being entered need to be checked (which will happen when this loop
 			// continues), but the other two blocks adjacent to the corner also need to
@@ -798,7 +865,7 @@ sightcounts[5]++;
 			if (!P_SightBlockLinesIterator (mapx + mapxstep, mapy) ||
 				!P_SightBlockLinesIterator (mapx, mapy + mapystep))
 			{
-sightcounts[1]++;
+ctx.counts[1]++;
 				return false;
 			}
 			xintercept += xstep;
@@ -817,7 +884,7 @@ sightcounts[1]++;
 //
 // couldn't early out, so go through the sorted list
 //
-sightcounts[2]++;
+ctx.counts[2]++;
 
 	bool traverseres = P_SightTraverseIntercepts ( );
 	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
@@ -825,45 +892,58 @@ sightcounts[2]++;
 	return traverseres;
 }
 
-/*
-=====================
-=
-= P_CheckSight
-=
-= Returns true if a straight line between t1 and t2 is unobstructed
-= look from eyes of t1 to any part of t2
-=
-= killough 4/20/98: cleaned up, made to use new LOS struct
-=
-=====================
-*/
+//==========================================================================
+//
+// Fake floors and ceilings block monster view
+//
+//==========================================================================
 
-int P_CheckSight (AActor *t1, AActor *t2, int flags)
+static bool P_SightBlockedByWaterBoundary(AActor *t1, AActor *t2, int flags)
 {
-	SightCycles.Clock();
-
-	bool res;
-
-	if (t1 == nullptr || t2 == nullptr)
+	if (flags & SF_IGNOREWATERBOUNDARY)
 	{
 		return false;
 	}
 
+	auto s1 = t1->Sector;
+	auto s2 = t2->Sector;
+	return (s1->GetHeightSec() &&
+			((t1->Top() <= s1->heightsec->floorplane.ZatPoint(t1) &&
+			  t2->Z() >= s1->heightsec->floorplane.ZatPoint(t2)) ||
+			 (t1->Z() >= s1->heightsec->ceilingplane.ZatPoint(t1) &&
+			  t2->Top() <= s1->heightsec->ceilingplane.ZatPoint(t2))))
+			||
+			(s2->GetHeightSec() &&
+			 ((t2->Top() <= s2->heightsec->floorplane.ZatPoint(t2) &&
+			   t1->Z() >= s2->heightsec->floorplane.ZatPoint(t1)) ||
+			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
+			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1))));
+}
+
+//==========================================================================
+//
+// P_SightPrecheck
+//
+// The part of P_CheckSight that runs before the trace. It may call the RNG,
+// so it always runs on the playsim thread in call order.
+// Returns false if t2 cannot be seen, -1 if a trace is needed.
+//
+//==========================================================================
+
+static int P_SightPrecheck(AActor *t1, AActor *t2, int flags)
+{
 	if ((t2->flags8 & MF8_MVISBLOCKED) && !(flags & SF_IGNOREVISIBILITY))
 	{
 		return false;
 	}
 
-	auto s1 = t1->Sector;
-	auto s2 = t2->Sector;
 	//
 	// check for trivial rejection
 	//
-	if (!t1->Level->CheckReject(s1, s2))
+	if (!t1->Level->CheckReject(t1->Sector, t2->Sector))
 	{
 sightcounts[0]++;
-		res = false;			// can't possibly be connected
-		goto done;
+		return false;			// can't possibly be connected
 	}
 
 //
@@ -878,67 +958,287 @@ sightcounts[0]++;
 	{ // small chance of an attack being made anyway
 		if ((t1->Level->BotInfo.m_Thinking ? pr_botchecksight() : pr_checksight()) > 50)
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
 	// killough 4/19/98: make fake floors and ceilings block monster view
+	if (P_SightBlockedByWaterBoundary(t1, t2, flags))
+	{
+		return false;
+	}
+	return -1;
+}
+
+//==========================================================================
+//
+// P_SightTrace
+//
+// Looks from the eyes of t1 to any part of t2. This only reads the level,
+// so it can run on a worker thread with a context of its own.
+//
+//==========================================================================
+
+static bool P_SightTrace(AActor *t1, AActor *t2, int flags, SightContext &ctx)
+{
+	bool res;
+	auto &portals = ctx.portals;
+
+	portals.Clear();
+	sector_t *sec;
+	double lookheight = t1->Z() + t1->Height*0.75;
+	t1->GetPortalTransition(lookheight, &sec);
+
+	double bottomslope = t2->Z() - lookheight;
+	double topslope = bottomslope + t2->Height;
+	SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
 
-	if (!(flags & SF_IGNOREWATERBOUNDARY))
+
+	SightCheck s(t1->Level, ctx);
+	s.init(t1, t2, sec, &task, flags);
+	res = s.P_SightPathTraverse ();
+	if (!res)
 	{
-		if ((s1->GetHeightSec() &&
-			((t1->Top() <= s1->heightsec->floorplane.ZatPoint(t1) &&
-			  t2->Z() >= s1->heightsec->floorplane.ZatPoint(t2)) ||
-			 (t1->Z() >= s1->heightsec->ceilingplane.ZatPoint(t1) &&
-			  t2->Top() <= s1->heightsec->ceilingplane.ZatPoint(t2))))
-			||
-			(s2->GetHeightSec() &&
-			 ((t2->Top() <= s2->heightsec->floorplane.ZatPoint(t2) &&
-			   t1->Z() >= s2->heightsec->floorplane.ZatPoint(t1)) ||
-			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
-			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1)))))
+		double dist = t1->Distance2D(t2);
+		for (unsigned i = 0; i < portals.Size(); i++)
 		{
-			res = false;
-			goto done;
+			portals[i].Frac += 1 / dist;
+			s.init(t1, t2, NULL, &portals[i], flags);
+			if (s.P_SightPathTraverse())
+			{
+				res = true;
+				break;
+			}
 		}
 	}
+	return res;
+}
 
-	// An unobstructed LOS is possible.
-	// Now look from eyes of t1 to any part of t2.
+//==========================================================================
+//
+// Batched sight checks
+//
+// Monsters that enter an A_Look or A_Chase state this tic are collected
+// before the default thinkers run, and the sight checks those actions are
+// going to make are traced on the worker pool against the world as it is
+// at that point. P_CheckSight then answers these queries from the batch
+// until P_EndSightBatch is called. Everything that can call the RNG still
+// runs on the playsim thread in the original call order.
+//
+// Which queries are batched only depends on the game state and on
+// sv_parallelsight, never on the number of threads, so every peer and
+// every demo playback makes the same checks against the same world.
+//
+//==========================================================================
 
-	validcount++;
-	portals.Clear();
+struct SightQuery
+{
+	AActor *t1, *t2;
+	int Flags;
+	bool Result;
+};
+
+static TArray<SightQuery> SightQueries;
+static TMap<AActor *, unsigned> SightQueryIndex;	// first query of each looker. The queries of one looker are contiguous.
+static TArray<std::unique_ptr<SightContext>> SightContexts;
+
+static void P_QueueSightCheck(AActor *t1, AActor *t2, int flags)
+{
+	// Queries that are rejected without a trace are not worth tracing.
+	if (t2 == nullptr || t2 == t1 || ((t2->flags8 & MF8_MVISBLOCKED) && !(flags & SF_IGNOREVISIBILITY)) ||
+		!t1->Level->CheckReject(t1->Sector, t2->Sector))
+	{
+		return;
+	}
+	if (SightQueries.Size() == 0 || SightQueries.Last().t1 != t1)
 	{
-		sector_t *sec;
-		double lookheight = t1->Z() + t1->Height*0.75;
-		t1->GetPortalTransition(lookheight, &sec);
+		SightQueryIndex[t1] = SightQueries.Size();
+	}
+	SightQueries.Push({ t1, t2, flags, false });
+}
+
+void P_BeginSightBatch(FLevelLocals *Level)
+{
+	const unsigned minBatchSize = 16;
+	const unsigned chunkSize = 8;
 
-		double bottomslope = t2->Z() - lookheight;
-		double topslope = bottomslope + t2->Height;
-		SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+	P_EndSightBatch();
+	if (!sv_parallelsight)
+	{
+		return;
+	}
+
+	static VMFunction *lookfunc, *chasefunc;
+	if (lookfunc == nullptr) PClass::FindFunction(&lookfunc, NAME_Actor, NAME_A_Look);
+	if (chasefunc == nullptr) PClass::FindFunction(&chasefunc, NAME_Actor, NAME_A_Chase);
+
+	SightCycles.Clock();
+
+	AActor *targets[MAXPLAYERS];
+	int numtargets = 0;
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!Level->PlayerInGame(i)) continue;
+		auto player = Level->Players[i];
+		if (player->mo != nullptr && (player->mo->flags & MF_SHOOTABLE) && !(player->cheats & CF_NOTARGET) && player->health > 0)
+		{
+			targets[numtargets++] = player->mo;
+		}
+	}
 
+	auto it = Level->GetThinkerIterator<AActor>(NAME_None, STAT_DEFAULT);
+	AActor *actor;
+	while ((actor = it.Next()))
+	{
+		// Only actors whose next state is entered this tic.
+		if (actor->tics != 1 || actor->state == nullptr || actor->health <= 0) continue;
+		FState *next = actor->state->GetNextState();
+		if (next == nullptr) continue;
 
-		SightCheck s(t1->Level);
-		s.init(t1, t2, sec, &task, flags);
-		res = s.P_SightPathTraverse ();
-		if (!res)
+		if (next->ActionFunc == lookfunc && lookfunc != nullptr)
 		{
-			double dist = t1->Distance2D(t2);
-			for (unsigned i = 0; i < portals.Size(); i++)
+			// P_LookForPlayers through P_IsVisible. Friends and haters look for other things.
+			if ((actor->flags & MF_FRIENDLY) || actor->TIDtoHate != 0) continue;
+			for (int i = 0; i < numtargets; i++)
 			{
-				portals[i].Frac += 1 / dist;
-				s.init(t1, t2, NULL, &portals[i], flags);
-				if (s.P_SightPathTraverse())
+				AActor *other = targets[i];
+				if (actor->IsFriend(other)) continue;
+				if (!(actor->flags4 & MF4_LOOKALLAROUND) && absangle(actor->AngleTo(other), actor->Angles.Yaw) > DAngle::fromDeg(90.) &&
+					actor->Distance2D(other) > actor->meleerange + actor->radius)
 				{
-					res = true;
-					break;
+					continue;
 				}
+				P_QueueSightCheck(actor, other, SF_SEEPASTSHOOTABLELINES);
+			}
+		}
+		else if (next->ActionFunc == chasefunc && chasefunc != nullptr)
+		{
+			// P_CheckMissileRange
+			if (actor->target != nullptr && actor->MissileState != nullptr && (actor->movecount == 0 || actor->isFast()))
+			{
+				P_QueueSightCheck(actor, actor->target, SF_SEEPASTBLOCKEVERYTHING);
 			}
 		}
 	}
 
-done:
+	// Small batches are traced on demand.
+	if (SightQueries.Size() < minBatchSize)
+	{
+		SightQueries.Clear();
+		SightQueryIndex.Clear();
+		SightCycles.Unclock();
+		return;
+	}
+
+	int numchunks = int((SightQueries.Size() + chunkSize - 1) / chunkSize);
+	int numcontexts = min(numchunks, WorkerPoolSize() + 1);
+	while (SightContexts.Size() < unsigned(numcontexts))
+	{
+		SightContexts.Push(std::make_unique<SightContext>(Level));
+	}
+	for (int i = 0; i < numcontexts; i++)
+	{
+		SightContexts[i]->Prepare(Level);
+	}
+
+	// Each context works on an interleaved set of chunks, so that no two threads share one.
+	RunOnWorkerPool(numcontexts, [=](int index)
+	{
+		SightContext &ctx = *SightContexts[index];
+		for (int chunk = index; chunk < numchunks; chunk += numcontexts)
+		{
+			unsigned end = min((chunk + 1) * chunkSize, SightQueries.Size());
+			for (unsigned i = chunk * chunkSize; i < end; i++)
+			{
+				auto &query = SightQueries[i];
+				query.Result = P_SightTrace(query.t1, query.t2, query.Flags, ctx);
+			}
+		}
+	});
+
+	for (int i = 0; i < numcontexts; i++)
+	{
+		for (int j = 0; j < 6; j++)
+		{
+			sightcounts[j] += SightContexts[i]->LocalCounts[j];
+			SightContexts[i]->LocalCounts[j] = 0;
+		}
+	}
+	SightCycles.Unclock();
+}
+
+void P_EndSightBatch()
+{
+	if (SightQueries.Size() > 0)
+	{
+		SightQueries.Clear();
+		SightQueryIndex.Clear();
+	}
+}
+
+static bool P_FindBatchedSight(AActor *t1, AActor *t2, int flags, bool &result)
+{
+	if (SightQueries.Size() == 0)
+	{
+		return false;
+	}
+	auto index = SightQueryIndex.CheckKey(t1);
+	if (index == nullptr)
+	{
+		return false;
+	}
+	for (unsigned i = *index; i < SightQueries.Size() && SightQueries[i].t1 == t1; i++)
+	{
+		if (SightQueries[i].t2 == t2 && SightQueries[i].Flags == flags)
+		{
+			result = SightQueries[i].Result;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+=====================
+=
+= P_CheckSight
+=
+= Returns true if a straight line between t1 and t2 is unobstructed
+= look from eyes of t1 to any part of t2
+=
+= killough 4/20/98: cleaned up, made to use new LOS struct
+=
+=====================
+*/
+
+int P_CheckSight (AActor *t1, AActor *t2, int flags)
+{
+	SightCycles.Clock();
+
+	int res;
+
+	if (t1 == nullptr || t2 == nullptr)
+	{
+		return false;
+	}
+
+	res = P_SightPrecheck(t1, t2, flags);
+	if (res < 0)
+	{
+		// An unobstructed LOS is possible.
+		// Now look from eyes of t1 to any part of t2.
+		bool batched;
+		if (P_FindBatchedSight(t1, t2, flags, batched))
+		{
+			res = batched;
+		}
+		else
+		{
+			validcount++;
+			res = P_SightTrace(t1, t2, flags, MainSight);
+		}
+	}
+
 	SightCycles.Unclock();
 	return res;
 }
@@ -330,6 +330,26 @@ void FLevelLocals::FinalizePortals()
 	CollectLinkedPortals();
 	BuildPortalBlockmap();
 	CreateLinkedPortals();
+	InvalidateActorSectorLists();
+}
+
+//============================================================================
+//
+// Actors keep their sector and portal lists while they do not move.
+// Make them all rebuild these after the portal setup changed.
+//
+//============================================================================
+
+void FLevelLocals::InvalidateActorSectorLists()
+{
+	auto it = GetThinkerIterator<AActor>();
+	AActor *ac;
+
+	while ((ac = it.Next()))
+	{
+		ac->SectorListExtent = 0;
+		ac->OldRenderPos = { FLT_MAX, FLT_MAX, FLT_MAX };
+	}
 }
 
 //============================================================================
@@ -383,13 +403,20 @@ bool FLevelLocals::ChangePortal(line_t *ln, int thisid, int destid)
 {
 	int lineno;
 
-	if (thisid == 0) return ChangePortalLine(ln, destid);
-	auto it = GetLineIdIterator(thisid);
 	bool res = false;
-	while ((lineno = it.Next()) >= 0)
+	if (thisid == 0)
+	{
+		res = ChangePortalLine(ln, destid);
+	}
+	else
 	{
-		res |= ChangePortalLine(&lines[lineno], destid);
+		auto it = GetLineIdIterator(thisid);
+		while ((lineno = it.Next()) >= 0)
+		{
+			res |= ChangePortalLine(&lines[lineno], destid);
+		}
 	}
+	if (res) InvalidateActorSectorLists();
 	return res;
 }
 
@@ -52,18 +52,16 @@ class DSectorPlaneInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DSectorPlaneInterpolation, DInterpolation)
 
-	sector_t *sector;
-	double oldheight, oldtexz;
-	double bakheight, baktexz;
-	bool ceiling;
 	TArray<DInterpolation *> attached;
 
+	FSectorPlaneInterpolationState &State() { return Level->interpolator.SectorPlanes[Slot]; }
 
 public:
 
 	DSectorPlaneInterpolation() {}
 	DSectorPlaneInterpolation(sector_t *sector, bool plane, bool attach);
 	void UnlinkFromMap() override;
+	void FreeSlot() override;
 	void UpdateInterpolation();
 	void Restore();
 	void Interpolate(double smoothratio);
@@ -82,16 +80,14 @@ class DSectorScrollInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DSectorScrollInterpolation, DInterpolation)
 
-	sector_t *sector;
-	double oldx, oldy;
-	double bakx, baky;
-	bool ceiling;
+	FSectorScrollInterpolationState &State() { return Level->interpolator.SectorScrolls[Slot]; }
 
 public:
 
 	DSectorScrollInterpolation() {}
 	DSectorScrollInterpolation(sector_t *sector, bool plane);
 	void UnlinkFromMap() override;
+	void FreeSlot() override;
 	void UpdateInterpolation();
 	void Restore();
 	void Interpolate(double smoothratio);
@@ -110,16 +106,14 @@ class DWallScrollInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DWallScrollInterpolation, DInterpolation)
 
-	side_t *side;
-	int part;
-	double oldx, oldy;
-	double bakx, baky;
+	FWallScrollInterpolationState &State() { return Level->interpolator.WallScrolls[Slot]; }
 
 public:
 
 	DWallScrollInterpolation() {}
 	DWallScrollInterpolation(side_t *side, int part);
 	void UnlinkFromMap() override;
+	void FreeSlot() override;
 	void UpdateInterpolation();
 	void Restore();
 	void Interpolate(double smoothratio);
@@ -147,6 +141,7 @@ public:
 	DPolyobjInterpolation() {}
 	DPolyobjInterpolation(FPolyObj *poly);
 	void UnlinkFromMap() override;
+	void FreeSlot() override;
 	void UpdateInterpolation();
 	void Restore();
 	void Interpolate(double smoothratio);
@@ -173,6 +168,112 @@ IMPLEMENT_CLASS(DSectorScrollInterpolation, false, false)
 IMPLEMENT_CLASS(DWallScrollInterpolation, false, false)
 IMPLEMENT_CLASS(DPolyobjInterpolation, false, false)
 
+//==========================================================================
+//
+// The actual interpolation work on the flat state arrays.
+// The Interpolate functions return false once the interpolation
+// has nothing left to do and may be discarded.
+//
+//==========================================================================
+
+static void UpdatePlane(FSectorPlaneInterpolationState &state)
+{
+	sector_t *sector = state.Sector;
+	int pos = state.Ceiling ? sector_t::ceiling : sector_t::floor;
+
+	state.OldHeight = (state.Ceiling ? sector->ceilingplane : sector->floorplane).fD();
+	state.OldTexZ = sector->GetPlaneTexZ(pos);
+}
+
+static void RestorePlane(FSectorPlaneInterpolationState &state)
+{
+	sector_t *sector = state.Sector;
+	int pos = state.Ceiling ? sector_t::ceiling : sector_t::floor;
+
+	(state.Ceiling ? sector->ceilingplane : sector->floorplane).setD(state.BakHeight);
+	sector->SetPlaneTexZ(pos, state.BakTexZ, true);
+	P_RecalculateAttached3DFloors(sector);
+	sector->CheckPortalPlane(pos);
+}
+
+static bool InterpolatePlane(FSectorPlaneInterpolationState &state, int refcount, double smoothratio)
+{
+	sector_t *sector = state.Sector;
+	int pos = state.Ceiling ? sector_t::ceiling : sector_t::floor;
+	secplane_t &plane = state.Ceiling ? sector->ceilingplane : sector->floorplane;
+
+	state.BakHeight = plane.fD();
+	state.BakTexZ = sector->GetPlaneTexZ(pos);
+
+	if (refcount == 0 && state.OldHeight == state.BakHeight)
+	{
+		return false;
+	}
+	plane.setD(state.OldHeight + (state.BakHeight - state.OldHeight) * smoothratio);
+	sector->SetPlaneTexZ(pos, state.OldTexZ + (state.BakTexZ - state.OldTexZ) * smoothratio, true);
+	P_RecalculateAttached3DFloors(sector);
+	sector->CheckPortalPlane(pos);
+	return true;
+}
+
+static void UpdateSectorScroll(FSectorScrollInterpolationState &state)
+{
+	state.OldX = state.Sector->GetXOffset(state.Ceiling);
+	state.OldY = state.Sector->GetYOffset(state.Ceiling, false);
+}
+
+static void RestoreSectorScroll(FSectorScrollInterpolationState &state)
+{
+	state.Sector->SetXOffset(state.Ceiling, state.BakX);
+	state.Sector->SetYOffset(state.Ceiling, state.BakY);
+}
+
+static bool InterpolateSectorScroll(FSectorScrollInterpolationState &state, int refcount, double smoothratio)
+{
+	state.BakX = state.Sector->GetXOffset(state.Ceiling);
+	state.BakY = state.Sector->GetYOffset(state.Ceiling, false);
+
+	if (refcount == 0 && state.OldX == state.BakX && state.OldY == state.BakY)
+	{
+		return false;
+	}
+	state.Sector->SetXOffset(state.Ceiling, state.OldX + (state.BakX - state.OldX) * smoothratio);
+	state.Sector->SetYOffset(state.Ceiling, state.OldY + (state.BakY - state.OldY) * smoothratio);
+	return true;
+}
+
+static void UpdateWallScroll(FWallScrollInterpolationState &state)
+{
+	state.OldX = state.Side->GetTextureXOffset(state.Part);
+	state.OldY = state.Side->GetTextureYOffset(state.Part);
+}
+
+static void RestoreWallScroll(FWallScrollInterpolationState &state)
+{
+	state.Side->SetTextureXOffset(state.Part, state.BakX);
+	state.Side->SetTextureYOffset(state.Part, state.BakY);
+}
+
+static bool InterpolateWallScroll(FWallScrollInterpolationState &state, int refcount, double smoothratio)
+{
+	state.BakX = state.Side->GetTextureXOffset(state.Part);
+	state.BakY = state.Side->GetTextureYOffset(state.Part);
+
+	if (refcount == 0 && state.OldX == state.BakX && state.OldY == state.BakY)
+	{
+		return false;
+	}
+	state.Side->SetTextureXOffset(state.Part, state.OldX + (state.BakX - state.OldX) * smoothratio);
+	state.Side->SetTextureYOffset(state.Part, state.OldY + (state.BakY - state.OldY) * smoothratio);
+	return true;
+}
+
+static void DiscardInterpolation(DInterpolation *interp)
+{
+	interp->UnlinkFromMap();
+	interp->Destroy();
+}
+
 //==========================================================================
 //
 //
@@ -197,10 +298,10 @@ int FInterpolator::CountInterpolations ()
 
 void FInterpolator::UpdateInterpolations()
 {
-	for (DInterpolation *probe = Head; probe != nullptr; probe = probe->Next)
-	{
-		probe->UpdateInterpolation ();
-	}
+	for (auto &state : SectorPlanes) UpdatePlane(state);
+	for (auto &state : SectorScrolls) UpdateSectorScroll(state);
+	for (auto &state : WallScrolls) UpdateWallScroll(state);
+	for (auto &state : Polyobjs) state.Owner->UpdateInterpolation();
 }
 
 //==========================================================================
@@ -255,12 +356,25 @@ void FInterpolator::DoInterpolations(double smoothratio)
 
 	didInterp = true;
 
-	DInterpolation *probe = Head;
-	while (probe != nullptr)
+	// Iterate backwards so that finished interpolations can be removed from the arrays along the way.
+	for (int i = SectorPlanes.Size() - 1; i >= 0; i--)
 	{
-		DInterpolation *next = probe->Next;
-		probe->Interpolate(smoothratio);
-		probe = next;
+		if (!InterpolatePlane(SectorPlanes[i], SectorPlanes[i].Owner->refcount, smoothratio))
+			DiscardInterpolation(SectorPlanes[i].Owner);
+	}
+	for (int i = SectorScrolls.Size() - 1; i >= 0; i--)
+	{
+		if (!InterpolateSectorScroll(SectorScrolls[i], SectorScrolls[i].Owner->refcount, smoothratio))
+			DiscardInterpolation(SectorScrolls[i].Owner);
+	}
+	for (int i = WallScrolls.Size() - 1; i >= 0; i--)
+	{
+		if (!InterpolateWallScroll(WallScrolls[i], WallScrolls[i].Owner->refcount, smoothratio))
+			DiscardInterpolation(WallScrolls[i].Owner);
+	}
+	for (int i = Polyobjs.Size() - 1; i >= 0; i--)
+	{
+		Polyobjs[i].Owner->Interpolate(smoothratio);
 	}
 }
 
@@ -275,10 +389,10 @@ void FInterpolator::RestoreInterpolations()
 	if (didInterp)
 	{
 		didInterp = false;
-		for (DInterpolation *probe = Head; probe != nullptr; probe = probe->Next)
-		{
-			probe->Restore();
-		}
+		for (auto &state : SectorPlanes) RestorePlane(state);
+		for (auto &state : SectorScrolls) RestoreSectorScroll(state);
+		for (auto &state : WallScrolls) RestoreWallScroll(state);
+		for (auto &state : Polyobjs) state.Owner->Restore();
 	}
 }
 
@@ -302,6 +416,15 @@ void FInterpolator::ClearInterpolations()
 		probe = next;
 	}
 
+	// Everything should be gone by now, but make sure that no stale state remains.
+	for (auto &state : SectorPlanes) state.Owner->Slot = -1;
+	for (auto &state : SectorScrolls) state.Owner->Slot = -1;
+	for (auto &state : WallScrolls) state.Owner->Slot = -1;
+	for (auto &state : Polyobjs) state.Owner->Slot = -1;
+	SectorPlanes.Clear();
+	SectorScrolls.Clear();
+	WallScrolls.Clear();
+	Polyobjs.Clear();
 }
 
 FSerializer &Serialize(FSerializer &arc, const char *key, FInterpolator &rs, FInterpolator *def)
@@ -367,6 +490,18 @@ void DInterpolation::UnlinkFromMap()
 //
 //==========================================================================
 
+void DInterpolation::OnDestroy()
+{
+	FreeSlot();
+	Super::OnDestroy();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
@@ -391,16 +526,15 @@ void DInterpolation::Serialize(FSerializer &arc)
 DSectorPlaneInterpolation::DSectorPlaneInterpolation(sector_t *_sector, bool _plane, bool attach)
 : DInterpolation(_sector->Level)
 {
-	sector = _sector;
-	ceiling = _plane;
+	Slot = Level->interpolator.SectorPlanes.Push({ this, _sector, _plane });
 	UpdateInterpolation ();
 
 	if (attach)
 	{
-		P_Start3dMidtexInterpolations(attached, sector, ceiling);
-		P_StartLinkedSectorInterpolations(attached, sector, ceiling);
+		P_Start3dMidtexInterpolations(attached, _sector, _plane);
+		P_StartLinkedSectorInterpolations(attached, _sector, _plane);
 	}
-	sector->Level->interpolator.AddInterpolation(this);
+	Level->interpolator.AddInterpolation(this);
 }
 
 //==========================================================================
@@ -411,17 +545,11 @@ DSectorPlaneInterpolation::DSectorPlaneInterpolation(sector_t *_sector, bool _pl
 
 void DSectorPlaneInterpolation::UnlinkFromMap()
 {
-	if (sector != nullptr)
+	if (Slot >= 0)
 	{
-		if (ceiling)
-		{
-			sector->interpolations[sector_t::CeilingMove] = nullptr;
-		}
-		else
-		{
-			sector->interpolations[sector_t::FloorMove] = nullptr;
-		}
-		sector = nullptr;
+		auto &state = State();
+		state.Sector->interpolations[state.Ceiling ? sector_t::CeilingMove : sector_t::FloorMove] = nullptr;
+		FreeSlot();
 	}
 	for (unsigned i = 0; i < attached.Size(); i++)
 	{
@@ -431,6 +559,15 @@ void DSectorPlaneInterpolation::UnlinkFromMap()
 	Super::UnlinkFromMap();
 }
 
+void DSectorPlaneInterpolation::FreeSlot()
+{
+	if (Slot >= 0)
+	{
+		Level->interpolator.RemoveState(Level->interpolator.SectorPlanes, Slot);
+		Slot = -1;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -439,16 +576,7 @@ void DSectorPlaneInterpolation::UnlinkFromMap()
 
 void DSectorPlaneInterpolation::UpdateInterpolation()
 {
-	if (!ceiling)
-	{
-		oldheight = sector->floorplane.fD();
-		oldtexz = sector->GetPlaneTexZ(sector_t::floor);
-	}
-	else
-	{
-		oldheight = sector->ceilingplane.fD();
-		oldtexz = sector->GetPlaneTexZ(sector_t::ceiling);
-	}
+	UpdatePlane(State());
 }
 
 //==========================================================================
@@ -459,18 +587,7 @@ void DSectorPlaneInterpolation::UpdateInterpolation()
 
 void DSectorPlaneInterpolation::Restore()
 {
-	if (!ceiling)
-	{
-		sector->floorplane.setD(bakheight);
-		sector->SetPlaneTexZ(sector_t::floor, baktexz, true);
-	}
-	else
-	{
-		sector->ceilingplane.setD(bakheight);
-		sector->SetPlaneTexZ(sector_t::ceiling, baktexz, true);
-	}
-	P_RecalculateAttached3DFloors(sector);
-	sector->CheckPortalPlane(ceiling? sector_t::ceiling : sector_t::floor);
+	RestorePlane(State());
 }
 
 //==========================================================================
@@ -481,34 +598,9 @@ void DSectorPlaneInterpolation::Restore()
 
 void DSectorPlaneInterpolation::Interpolate(double smoothratio)
 {
-	secplane_t *pplane;
-	int pos;
-
-	if (!ceiling)
-	{
-		pplane = &sector->floorplane;
-		pos = sector_t::floor;
-	}
-	else
-	{
-		pplane = &sector->ceilingplane;
-		pos = sector_t::ceiling;
-	}
-
-	bakheight = pplane->fD();
-	baktexz = sector->GetPlaneTexZ(pos);
-
-	if (refcount == 0 && oldheight == bakheight)
+	if (!InterpolatePlane(State(), refcount, smoothratio))
 	{
-		UnlinkFromMap();
-		Destroy();
-	}
-	else
-	{
-		pplane->setD(oldheight + (bakheight - oldheight) * smoothratio);
-		sector->SetPlaneTexZ(pos, oldtexz + (baktexz - oldtexz) * smoothratio, true);
-		P_RecalculateAttached3DFloors(sector);
-		sector->CheckPortalPlane(pos);
+		DiscardInterpolation(this);
 	}
 }
 
@@ -521,11 +613,19 @@ void DSectorPlaneInterpolation::Interpolate(double smoothratio)
 void DSectorPlaneInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("sector", sector)
-		("ceiling", ceiling)
-		("oldheight", oldheight)
-		("oldtexz", oldtexz)
+	FSectorPlaneInterpolationState state = {};
+	if (Slot >= 0) state = State();
+	arc("sector", state.Sector)
+		("ceiling", state.Ceiling)
+		("oldheight", state.OldHeight)
+		("oldtexz", state.OldTexZ)
 		("attached", attached);
+	if (arc.isReading())
+	{
+		state.Owner = this;
+		if (Slot >= 0) State() = state;
+		else Slot = Level->interpolator.SectorPlanes.Push(state);
+	}
 }
 
 
@@ -559,10 +659,9 @@ size_t DSectorPlaneInterpolation::PropagateMark()
 DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _plane)
 : DInterpolation(_sector->Level)
 {
-	sector = _sector;
-	ceiling = _plane;
+	Slot = Level->interpolator.SectorScrolls.Push({ this, _sector, _plane });
 	UpdateInterpolation ();
-	sector->Level->interpolator.AddInterpolation(this);
+	Level->interpolator.AddInterpolation(this);
 }
 
 //==========================================================================
@@ -573,21 +672,24 @@ DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _
 
 void DSectorScrollInterpolation::UnlinkFromMap()
 {
-	if (sector != nullptr)
+	if (Slot >= 0)
 	{
-		if (ceiling)
-		{
-			sector->interpolations[sector_t::CeilingScroll] = nullptr;
-		}
-		else
-		{
-			sector->interpolations[sector_t::FloorScroll] = nullptr;
-		}
-		sector = nullptr;
+		auto &state = State();
+		state.Sector->interpolations[state.Ceiling ? sector_t::CeilingScroll : sector_t::FloorScroll] = nullptr;
+		FreeSlot();
 	}
 	Super::UnlinkFromMap();
 }
 
+void DSectorScrollInterpolation::FreeSlot()
+{
+	if (Slot >= 0)
+	{
+		Level->interpolator.RemoveState(Level->interpolator.SectorScrolls, Slot);
+		Slot = -1;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -596,8 +698,7 @@ void DSectorScrollInterpolation::UnlinkFromMap()
 
 void DSectorScrollInterpolation::UpdateInterpolation()
 {
-	oldx = sector->GetXOffset(ceiling);
-	oldy = sector->GetYOffset(ceiling, false);
+	UpdateSectorScroll(State());
 }
 
 //==========================================================================
@@ -608,8 +709,7 @@ void DSectorScrollInterpolation::UpdateInterpolation()
 
 void DSectorScrollInterpolation::Restore()
 {
-	sector->SetXOffset(ceiling, bakx);
-	sector->SetYOffset(ceiling, baky);
+	RestoreSectorScroll(State());
 }
 
 //==========================================================================
@@ -620,18 +720,9 @@ void DSectorScrollInterpolation::Restore()
 
 void DSectorScrollInterpolation::Interpolate(double smoothratio)
 {
-	bakx = sector->GetXOffset(ceiling);
-	baky = sector->GetYOffset(ceiling, false);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
+	if (!InterpolateSectorScroll(State(), refcount, smoothratio))
 	{
-		UnlinkFromMap();
-		Destroy();
-	}
-	else
-	{
-		sector->SetXOffset(ceiling, oldx + (bakx - oldx) * smoothratio);
-		sector->SetYOffset(ceiling, oldy + (baky - oldy) * smoothratio);
+		DiscardInterpolation(this);
 	}
 }
 
@@ -644,10 +735,18 @@ void DSectorScrollInterpolation::Interpolate(double smoothratio)
 void DSectorScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("sector", sector)
-		("ceiling", ceiling)
-		("oldx", oldx)
-		("oldy", oldy);
+	FSectorScrollInterpolationState state = {};
+	if (Slot >= 0) state = State();
+	arc("sector", state.Sector)
+		("ceiling", state.Ceiling)
+		("oldx", state.OldX)
+		("oldy", state.OldY);
+	if (arc.isReading())
+	{
+		state.Owner = this;
+		if (Slot >= 0) State() = state;
+		else Slot = Level->interpolator.SectorScrolls.Push(state);
+	}
 }
 
 
@@ -666,10 +765,9 @@ void DSectorScrollInterpolation::Serialize(FSerializer &arc)
 DWallScrollInterpolation::DWallScrollInterpolation(side_t *_side, int _part)
 : DInterpolation(_side->GetLevel())
 {
-	side = _side;
-	part = _part;
+	Slot = Level->interpolator.WallScrolls.Push({ this, _side, _part });
 	UpdateInterpolation ();
-	side->GetLevel()->interpolator.AddInterpolation(this);
+	Level->interpolator.AddInterpolation(this);
 }
 
 //==========================================================================
@@ -680,14 +778,24 @@ DWallScrollInterpolation::DWallScrollInterpolation(side_t *_side, int _part)
 
 void DWallScrollInterpolation::UnlinkFromMap()
 {
-	if (side != nullptr)
+	if (Slot >= 0)
 	{
-		side->textures[part].interpolation = nullptr;
-		side = nullptr;
+		auto &state = State();
+		state.Side->textures[state.Part].interpolation = nullptr;
+		FreeSlot();
 	}
 	Super::UnlinkFromMap();
 }
 
+void DWallScrollInterpolation::FreeSlot()
+{
+	if (Slot >= 0)
+	{
+		Level->interpolator.RemoveState(Level->interpolator.WallScrolls, Slot);
+		Slot = -1;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -696,8 +804,7 @@ void DWallScrollInterpolation::UnlinkFromMap()
 
 void DWallScrollInterpolation::UpdateInterpolation()
 {
-	oldx = side->GetTextureXOffset(part);
-	oldy = side->GetTextureYOffset(part);
+	UpdateWallScroll(State());
 }
 
 //==========================================================================
@@ -708,8 +815,7 @@ void DWallScrollInterpolation::UpdateInterpolation()
 
 void DWallScrollInterpolation::Restore()
 {
-	side->SetTextureXOffset(part, bakx);
-	side->SetTextureYOffset(part, baky);
+	RestoreWallScroll(State());
 }
 
 //==========================================================================
@@ -720,18 +826,9 @@ void DWallScrollInterpolation::Restore()
 
 void DWallScrollInterpolation::Interpolate(double smoothratio)
 {
-	bakx = side->GetTextureXOffset(part);
-	baky = side->GetTextureYOffset(part);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		UnlinkFromMap();
-		Destroy();
-	}
-	else
+	if (!InterpolateWallScroll(State(), refcount, smoothratio))
 	{
-		side->SetTextureXOffset(part, oldx + (bakx - oldx) * smoothratio);
-		side->SetTextureYOffset(part, oldy + (baky - oldy) * smoothratio);
+		DiscardInterpolation(this);
 	}
 }
 
@@ -744,10 +841,18 @@ void DWallScrollInterpolation::Interpolate(double smoothratio)
 void DWallScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("side", side)
-		("part", part)
-		("oldx", oldx)
-		("oldy", oldy);
+	FWallScrollInterpolationState state = {};
+	if (Slot >= 0) state = State();
+	arc("side", state.Side)
+		("part", state.Part)
+		("oldx", state.OldX)
+		("oldy", state.OldY);
+	if (arc.isReading())
+	{
+		state.Owner = this;
+		if (Slot >= 0) State() = state;
+		else Slot = Level->interpolator.WallScrolls.Push(state);
+	}
 }
 
 //==========================================================================
@@ -769,6 +874,7 @@ DPolyobjInterpolation::DPolyobjInterpolation(FPolyObj *po)
 	oldverts.Resize(po->Vertices.Size() << 1);
 	bakverts.Resize(po->Vertices.Size() << 1);
 	UpdateInterpolation ();
+	Slot = Level->interpolator.Polyobjs.Push({ this });
 	po->Level->interpolator.AddInterpolation(this);
 }
 
@@ -784,9 +890,19 @@ void DPolyobjInterpolation::UnlinkFromMap()
 	{
 		poly->interpolation = nullptr;
 	}
+	FreeSlot();
 	Super::UnlinkFromMap();
 }
 
+void DPolyobjInterpolation::FreeSlot()
+{
+	if (Slot >= 0)
+	{
+		Level->interpolator.RemoveState(Level->interpolator.Polyobjs, Slot);
+		Slot = -1;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -872,7 +988,11 @@ void DPolyobjInterpolation::Serialize(FSerializer &arc)
 		("oldverts", oldverts)
 		("oldcx", oldcx)
 		("oldcy", oldcy);
-	if (arc.isReading()) bakverts.Resize(oldverts.Size());
+	if (arc.isReading())
+	{
+		bakverts.Resize(oldverts.Size());
+		if (Slot < 0) Slot = Level->interpolator.Polyobjs.Push({ this });
+	}
 }
 
 
@@ -4,6 +4,51 @@
 #include "dobject.h"
 
 struct FLevelLocals;
+struct sector_t;
+struct side_t;
+class DInterpolation;
+
+//==========================================================================
+//
+// The per-frame state of the interpolations is kept in flat arrays in
+// FInterpolator, so that rendering a frame is a tight loop per kind instead
+// of a virtual call per DObject. The DInterpolation objects only own a slot
+// in these arrays and remain for reference counting and serialization.
+//
+//==========================================================================
+
+struct FSectorPlaneInterpolationState
+{
+	DInterpolation *Owner;
+	sector_t *Sector;
+	bool Ceiling;
+	double OldHeight, OldTexZ;
+	double BakHeight, BakTexZ;
+};
+
+struct FSectorScrollInterpolationState
+{
+	DInterpolation *Owner;
+	sector_t *Sector;
+	bool Ceiling;
+	double OldX, OldY;
+	double BakX, BakY;
+};
+
+struct FWallScrollInterpolationState
+{
+	DInterpolation *Owner;
+	side_t *Side;
+	int Part;
+	double OldX, OldY;
+	double BakX, BakY;
+};
+
+struct FPolyobjInterpolationState
+{
+	DInterpolation *Owner;
+};
+
 //==========================================================================
 //
 //
@@ -23,8 +68,11 @@ class DInterpolation : public DObject
 protected:
 	FLevelLocals *Level;
 	int refcount = 0;
+	int Slot = -1;		// Index of this interpolation's state in the FInterpolator arrays.
 
 	DInterpolation(FLevelLocals *l = nullptr) : Level(l) {}
+	virtual void FreeSlot() {}
+	void OnDestroy() override;
 
 public:
 	int AddRef();
@@ -50,8 +98,15 @@ struct FInterpolator
 	bool didInterp = false;
 	int count = 0;
 
+	TArray<FSectorPlaneInterpolationState> SectorPlanes;
+	TArray<FSectorScrollInterpolationState> SectorScrolls;
+	TArray<FWallScrollInterpolationState> WallScrolls;
+	TArray<FPolyobjInterpolationState> Polyobjs;
+
 	int CountInterpolations ();
 
+	template<class T> void RemoveState(TArray<T> &states, int slot);
+
 public:
 	void UpdateInterpolations();
 	void AddInterpolation(DInterpolation *);
@@ -61,6 +116,13 @@ public:
 	void ClearInterpolations();
 };
 
+template<class T> void FInterpolator::RemoveState(TArray<T> &states, int slot)
+{
+	states[slot] = states.Last();
+	states[slot].Owner->Slot = slot;
+	states.Pop();
+}
+
 
 #endif
 
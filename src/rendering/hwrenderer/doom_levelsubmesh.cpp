@@ -15,6 +15,7 @@
 #include "hwrenderer/scene/hw_walldispatcher.h"
 #include "hwrenderer/scene/hw_flatdispatcher.h"
 #include "common/rendering/hwrenderer/data/hw_meshbuilder.h"
+#include "workerpool.h"
 #include <unordered_map>
 
 EXTERN_CVAR(Float, lm_scale);
@@ -31,9 +32,12 @@ DoomLevelSubmesh::DoomLevelSubmesh(DoomLevelMesh* mesh, FLevelLocals& doomMap, b
 
 		SortIndexes();
 		BuildTileSurfaceLists();
-		UpdateCollision();
+
+		// The collision BVH only reads vertex positions while the atlas packing only writes the lightmap coordinates, so both can run at once.
+		TWorkerTask<void> collision = WorkerPool().push([this](int) { UpdateCollision(); });
 		if (doomMap.lightmaps)
 			PackLightmapAtlas(doomMap, 0);
+		collision.Get();
 	}
 }
 
@@ -83,10 +87,23 @@ void DoomLevelSubmesh::CreateStaticSurfaces(FLevelLocals& doomMap)
 		}
 	}
 
-	MeshBuilder state;
-	std::map<LightmapTileBinding, int> bindings;
+	struct WallJob
+	{
+		side_t* side;
+		subsector_t* sub;
+		seg_t* seg;
+		HWMeshHelper result;
+	};
 
-	// Create surface objects for all sides
+	struct FlatJob
+	{
+		sector_t* sector;
+		FSection* section;
+		HWFlatMeshHelper result;
+	};
+
+	std::vector<WallJob> wallJobs;
+	wallJobs.reserve(doomMap.sides.Size());
 	for (unsigned int i = 0; i < doomMap.sides.Size(); i++)
 	{
 		side_t* side = &doomMap.sides[i];
@@ -99,14 +116,70 @@ void DoomLevelSubmesh::CreateStaticSurfaces(FLevelLocals& doomMap)
 		if (!seg)
 			continue;
 
-		sector_t* front = side->sector;
-		sector_t* back = (side->linedef->frontsector == front) ? side->linedef->backsector : side->linedef->frontsector;
+		wallJobs.push_back({ side, sub, seg });
+	}
 
-		HWMeshHelper result;
-		HWWallDispatcher disp(&doomMap, &result, getRealLightmode(&doomMap, true));
-		HWWall wall;
-		wall.sub = sub;
-		wall.Process(&disp, state, seg, front, back);
+	std::vector<FlatJob> flatJobs;
+	flatJobs.reserve(doomMap.sections.allSections.Size());
+	for (unsigned int i = 0; i < doomMap.sectors.Size(); i++)
+	{
+		sector_t* sector = &doomMap.sectors[i];
+		if (sector->subsectors[0]->flags & SSECF_POLYORG)
+			continue;
+		for (FSection& section : doomMap.sections.SectionsForSector(i))
+		{
+			flatJobs.push_back({ sector, &section });
+		}
+	}
+
+	// Splitting the sides and sections into wall and flat parts only reads the level, so it runs on worker threads in chunks.
+	// Turning the parts into mesh surfaces allocates materials, pipelines and lightmap tiles, so that stays on this thread and
+	// goes through the parts in their original order afterwards. This keeps the mesh identical to a serial build.
+	ELightMode lightmode = getRealLightmode(&doomMap, true);
+	const size_t chunkSize = 256;
+	int wallChunks = int((wallJobs.size() + chunkSize - 1) / chunkSize);
+	int flatChunks = int((flatJobs.size() + chunkSize - 1) / chunkSize);
+
+	RunOnWorkerPool(wallChunks + flatChunks, [&](int chunk)
+	{
+		MeshBuilder chunkState;
+		if (chunk < wallChunks)
+		{
+			for (size_t i = chunk * chunkSize, end = min(i + chunkSize, wallJobs.size()); i < end; i++)
+			{
+				WallJob& job = wallJobs[i];
+				sector_t* front = job.side->sector;
+				sector_t* back = (job.side->linedef->frontsector == front) ? job.side->linedef->backsector : job.side->linedef->frontsector;
+
+				HWWallDispatcher disp(&doomMap, &job.result, lightmode);
+				HWWall wall;
+				wall.sub = job.sub;
+				wall.Process(&disp, chunkState, job.seg, front, back);
+			}
+		}
+		else
+		{
+			chunk -= wallChunks;
+			for (size_t i = chunk * chunkSize, end = min(i + chunkSize, flatJobs.size()); i < end; i++)
+			{
+				FlatJob& job = flatJobs[i];
+				HWFlatDispatcher disp(&doomMap, &job.result, lightmode);
+				HWFlat flat;
+				flat.section = job.section;
+				flat.ProcessSector(&disp, chunkState, job.sector);
+			}
+		}
+	});
+
+	MeshBuilder state;
+	LightmapTileBindingMap bindings;
+
+	// Create surface objects for all sides
+	for (size_t i = 0; i < wallJobs.size(); i++)
+	{
+		side_t* side = wallJobs[i].side;
+		HWMeshHelper& result = wallJobs[i].result;
+		HWWallDispatcher disp(&doomMap, &result, lightmode);
 
 		// Part 1: solid geometry. This is set up so that there are no transparent parts
 		state.SetDepthFunc(DF_LEqual);
@@ -131,44 +204,36 @@ void DoomLevelSubmesh::CreateStaticSurfaces(FLevelLocals& doomMap)
 		state.AlphaFunc(Alpha_GEqual, 0.f);
 		state.SetRenderStyle(STYLE_Normal);
 		*/
+
+		result = {};
 	}
 
 	// Create surfaces for all flats
-	for (unsigned int i = 0; i < doomMap.sectors.Size(); i++)
+	for (size_t i = 0; i < flatJobs.size(); i++)
 	{
-		sector_t* sector = &doomMap.sectors[i];
-		if (sector->subsectors[0]->flags & SSECF_POLYORG)
-			continue;
-		for (FSection& section : doomMap.sections.SectionsForSector(i))
-		{
-			int sectionIndex = doomMap.sections.SectionIndex(&section);
+		HWFlatMeshHelper& result = flatJobs[i].result;
+		HWFlatDispatcher disp(&doomMap, &result, lightmode);
 
-			HWFlatMeshHelper result;
-			HWFlatDispatcher disp(&doomMap, &result, getRealLightmode(&doomMap, true));
+		// Part 1: solid geometry. This is set up so that there are no transparent parts
+		state.SetDepthFunc(DF_LEqual);
+		state.ClearDepthBias();
+		state.EnableTexture(true);
+		state.EnableBrightmap(true);
+		CreateFlatSurface(disp, state, bindings, result.list);
 
-			HWFlat flat;
-			flat.section = &section;
-			flat.ProcessSector(&disp, state, sector);
+		CreateFlatSurface(disp, state, bindings, result.portals, true);
 
-			// Part 1: solid geometry. This is set up so that there are no transparent parts
-			state.SetDepthFunc(DF_LEqual);
-			state.ClearDepthBias();
-			state.EnableTexture(true);
-			state.EnableBrightmap(true);
-			CreateFlatSurface(disp, state, bindings, result.list);
-
-			CreateFlatSurface(disp, state, bindings, result.portals, true);
-
-			// final pass: translucent stuff
-			state.AlphaFunc(Alpha_GEqual, gl_mask_sprite_threshold);
-			state.SetRenderStyle(STYLE_Translucent);
-			CreateFlatSurface(disp, state, bindings, result.translucentborder);
-			state.SetDepthMask(false);
-			CreateFlatSurface(disp, state, bindings, result.translucent);
-			state.AlphaFunc(Alpha_GEqual, 0.f);
-			state.SetDepthMask(true);
-			state.SetRenderStyle(STYLE_Normal);
-		}
+		// final pass: translucent stuff
+		state.AlphaFunc(Alpha_GEqual, gl_mask_sprite_threshold);
+		state.SetRenderStyle(STYLE_Translucent);
+		CreateFlatSurface(disp, state, bindings, result.translucentborder);
+		state.SetDepthMask(false);
+		CreateFlatSurface(disp, state, bindings, result.translucent);
+		state.AlphaFunc(Alpha_GEqual, 0.f);
+		state.SetDepthMask(true);
+		state.SetRenderStyle(STYLE_Normal);
+
+		result = {};
 	}
 
 	for (auto& tile : LightmapTiles)
@@ -177,7 +242,7 @@ void DoomLevelSubmesh::CreateStaticSurfaces(FLevelLocals& doomMap)
 	}
 }
 
-void DoomLevelSubmesh::CreateWallSurface(side_t* side, HWWallDispatcher& disp, MeshBuilder& state, std::map<LightmapTileBinding, int>& bindings, TArray<HWWall>& list, bool isSky, bool translucent)
+void DoomLevelSubmesh::CreateWallSurface(side_t* side, HWWallDispatcher& disp, MeshBuilder& state, LightmapTileBindingMap& bindings, TArray<HWWall>& list, bool isSky, bool translucent)
 {
 	for (HWWall& wallpart : list)
 	{
@@ -275,7 +340,7 @@ void DoomLevelSubmesh::CreateWallSurface(side_t* side, HWWallDispatcher& disp, M
 	}
 }
 
-int DoomLevelSubmesh::AddSurfaceToTile(const DoomLevelMeshSurface& surf, std::map<LightmapTileBinding, int>& bindings)
+int DoomLevelSubmesh::AddSurfaceToTile(const DoomLevelMeshSurface& surf, LightmapTileBindingMap& bindings)
 {
 	if (surf.IsSky)
 		return -1;
@@ -339,7 +404,7 @@ int DoomLevelSubmesh::GetSampleDimension(const DoomLevelMeshSurface& surf)
 	return sampleDimension;
 }
 
-void DoomLevelSubmesh::CreateFlatSurface(HWFlatDispatcher& disp, MeshBuilder& state, std::map<LightmapTileBinding, int>& bindings, TArray<HWFlat>& list, bool isSky)
+void DoomLevelSubmesh::CreateFlatSurface(HWFlatDispatcher& disp, MeshBuilder& state, LightmapTileBindingMap& bindings, TArray<HWFlat>& list, bool isSky)
 {
 	for (HWFlat& flatpart : list)
 	{
@@ -680,8 +745,8 @@ void DoomLevelSubmesh::PackLightmapAtlas(FLevelLocals& doomMap, int lightmapStar
 		0.0f, 0.5f, 0.5f,
 		0.5f, 0.0f, 0.5f
 	};
-	LMTextureData.Resize(LMTextureSize * LMTextureSize * LMTextureCount * 3);
-	uint16_t* pixels = LMTextureData.Data();
+	LMBakedTiles.Clear();
+	LMTilePixels.Clear();
 	for (LightmapTile& tile : LightmapTiles)
 	{
 		tile.NeedsUpdate = false;
@@ -689,19 +754,27 @@ void DoomLevelSubmesh::PackLightmapAtlas(FLevelLocals& doomMap, int lightmapStar
 		int index = tile.Binding.TypeIndex;
 		float* color = colors + (index % 10) * 3;
 
-		int x = tile.AtlasLocation.X;
-		int y = tile.AtlasLocation.Y;
 		int w = tile.AtlasLocation.Width;
 		int h = tile.AtlasLocation.Height;
-		for (int yy = y; yy < y + h; yy++)
+
+		LightmapTileUpload upload;
+		upload.X = tile.AtlasLocation.X;
+		upload.Y = tile.AtlasLocation.Y;
+		upload.Width = w;
+		upload.Height = h;
+		upload.ArrayIndex = tile.AtlasLocation.ArrayIndex;
+		upload.PixelsOffset = LMTilePixels.Size();
+		LMBakedTiles.Push(upload);
+
+		uint16_t* pixels = &LMTilePixels[LMTilePixels.Reserve(w * h * 3)];
+		for (int yy = 0; yy < h; yy++)
 		{
-			uint16_t* line = pixels + tile.AtlasLocation.ArrayIndex * LMTextureSize * LMTextureSize + yy * LMTextureSize * 3;
-			for (int xx = x; xx < x + w; xx++)
+			float gray = yy / (float)h;
+			for (int xx = 0; xx < w; xx++)
 			{
-				float gray = (yy - y) / (float)h;
-				line[xx * 3] = floatToHalf(color[0] * gray);
-				line[xx * 3 + 1] = floatToHalf(color[1] * gray);
-				line[xx * 3 + 2] = floatToHalf(color[2] * gray);
+				*(pixels++) = floatToHalf(color[0] * gray);
+				*(pixels++) = floatToHalf(color[1] * gray);
+				*(pixels++) = floatToHalf(color[2] * gray);
 			}
 		}
 	}
@@ -10,9 +10,20 @@
 #include <dp_rect_pack.h>
 #include <set>
 #include <map>
+#include <unordered_map>
 
 typedef dp::rect_pack::RectPacker<int> RectPacker;
 
+struct LightmapTileBindingHash
+{
+	size_t operator()(const LightmapTileBinding& binding) const
+	{
+		return (size_t(binding.TypeIndex) * 0x9e3779b1u) ^ (size_t(binding.ControlSector) << 8) ^ size_t(binding.Type);
+	}
+};
+
+typedef std::unordered_map<LightmapTileBinding, int, LightmapTileBindingHash> LightmapTileBindingMap;
+
 struct FLevelLocals;
 struct FPolyObj;
 struct HWWallDispatcher;
@@ -57,8 +68,8 @@ private:
 
 	void SortIndexes();
 
-	void CreateWallSurface(side_t* side, HWWallDispatcher& disp, MeshBuilder& state, std::map<LightmapTileBinding, int>& bindings, TArray<HWWall>& list, bool isSky, bool translucent);
-	void CreateFlatSurface(HWFlatDispatcher& disp, MeshBuilder& state, std::map<LightmapTileBinding, int>& bindings, TArray<HWFlat>& list, bool isSky = false);
+	void CreateWallSurface(side_t* side, HWWallDispatcher& disp, MeshBuilder& state, LightmapTileBindingMap& bindings, TArray<HWWall>& list, bool isSky, bool translucent);
+	void CreateFlatSurface(HWFlatDispatcher& disp, MeshBuilder& state, LightmapTileBindingMap& bindings, TArray<HWFlat>& list, bool isSky = false);
 
 	void LinkSurfaces(FLevelLocals& doomMap);
 	void PackLightmapAtlas(FLevelLocals& doomMap, int lightmapStartIndex);
@@ -74,7 +85,7 @@ private:
 	BBox GetBoundsFromSurface(const LevelMeshSurface& surface) const;
 
 	void SetupTileTransform(int lightMapTextureWidth, int lightMapTextureHeight, LightmapTile& tile);
-	int AddSurfaceToTile(const DoomLevelMeshSurface& surf, std::map<LightmapTileBinding, int>& bindings);
+	int AddSurfaceToTile(const DoomLevelMeshSurface& surf, LightmapTileBindingMap& bindings);
 	int GetSampleDimension(const DoomLevelMeshSurface& surf);
 
 	DoomLevelMesh* LevelMesh = nullptr;
@@ -49,7 +49,7 @@ EXTERN_CVAR(Bool, gl_precache)
 //
 //==========================================================================
 
-static void PrecacheTexture(FGameTexture *tex, int cache)
+static void PrecacheTexture(FGameTexture *tex, int cache, TArray<std::pair<FMaterial*, int>> &materials)
 {
 	if (cache & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky))
 	{
@@ -57,7 +57,7 @@ static void PrecacheTexture(FGameTexture *tex, int cache)
 		if (shouldUpscale(tex, UF_Texture)) scaleflags |= CTF_Upscale;
 
 		FMaterial * gltex = FMaterial::ValidateTexture(tex, scaleflags);
-		if (gltex) screen->PrecacheMaterial(gltex, 0);
+		if (gltex) materials.Push(std::make_pair(gltex, 0));
 	}
 }
 
@@ -66,11 +66,11 @@ static void PrecacheTexture(FGameTexture *tex, int cache)
 //
 //
 //===========================================================================
-static void PrecacheList(FMaterial *gltex, SpriteHits& translations)
+static void PrecacheList(FMaterial *gltex, SpriteHits& translations, TArray<std::pair<FMaterial*, int>> &materials)
 {
 	SpriteHits::Iterator it(translations);
 	SpriteHits::Pair* pair;
-	while (it.NextPair(pair)) screen->PrecacheMaterial(gltex, pair->Key);
+	while (it.NextPair(pair)) materials.Push(std::make_pair(gltex, pair->Key));
 }
 
 //==========================================================================
@@ -79,13 +79,13 @@ static void PrecacheList(FMaterial *gltex, SpriteHits& translations)
 //
 //==========================================================================
 
-static void PrecacheSprite(FGameTexture *tex, SpriteHits &hits)
+static void PrecacheSprite(FGameTexture *tex, SpriteHits &hits, TArray<std::pair<FMaterial*, int>> &materials)
 {
 	int scaleflags = CTF_Expand;
 	if (shouldUpscale(tex, UF_Sprite)) scaleflags |= CTF_Upscale;
 
 	FMaterial * gltex = FMaterial::ValidateTexture(tex, scaleflags);
-	if (gltex) PrecacheList(gltex, hits);
+	if (gltex) PrecacheList(gltex, hits, materials);
 }
 
 
@@ -298,25 +298,33 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
-		// cache all used textures
+		// cache all used textures. The backend gets the whole list at once so that it can prepare the images in parallel.
+		TArray<std::pair<FMaterial*, int>> materials;
 		for (int i = cnt - 1; i >= 0; i--)
 		{
 			auto gtex = TexMan.GameByIndex(i);
 			if (gtex != nullptr)
 			{
-				PrecacheTexture(gtex, texhitlist[i]);
+				PrecacheTexture(gtex, texhitlist[i], materials);
 				if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0)
 				{
-					PrecacheSprite(gtex, *spritehitlist[i]);
+					PrecacheSprite(gtex, *spritehitlist[i], materials);
 				}
 			}
 		}
-
+		screen->PrecacheMaterials(materials);
 
 		FImageSource::EndPrecaching();
 
 		// cache all used models
 		FModelRenderer* renderer = new FHWModelRenderer(nullptr, *screen->RenderState(), -1);
+		TArray<FModel*> meshlist;
+		for (unsigned i = 0; i < Models.Size(); i++)
+		{
+			if (modellist[i] && !Models[i]->GetVertexBuffer(renderer->GetType()))
+				meshlist.Push(Models[i]);
+		}
+		BuildModelMeshes(meshlist);
 		for (unsigned i = 0; i < Models.Size(); i++)
 		{
 			if (modellist[i]) 
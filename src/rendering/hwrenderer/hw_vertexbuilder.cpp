@@ -28,6 +28,7 @@
 #include "flatvertices.h"
 #include "earcut.hpp"
 #include "v_video.h"
+#include "hwrenderer/scene/hw_drawstructs.h"
 
 TArray<FFlatVertex> sector_vertices;
 TArray<uint32_t> sector_indexes;
@@ -500,4 +501,5 @@ void CreateVBO(FRenderState& renderstate, TArray<sector_t>& sectors)
 	sector_vertices.Clear();
 	CreateVertices(sectors);
 	renderstate.SetShadowData(sector_vertices, sector_indexes);
+	hw_ClearWallCache();
 }
@@ -174,7 +174,7 @@ void HWDrawInfo::WorkerThread()
 			HWWall wall;
 			SetupWall.Clock();
 			wall.sub = job->sub;
-			wall.Process(&disp, state, job->seg, front, back);
+			wall.ProcessCached(&disp, state, job->seg, front, back);
 			rendered_lines++;
 			SetupWall.Unclock();
 			break;
@@ -356,7 +356,7 @@ void HWDrawInfo::AddLine (seg_t *seg, bool portalclip, FRenderState& state)
 				HWWallDispatcher disp(this);
 				SetupWall.Clock();
 				wall.sub = seg->Subsector;
-				wall.Process(&disp, state, seg, currentsector, backsector);
+				wall.ProcessCached(&disp, state, seg, currentsector, backsector);
 				rendered_lines++;
 				SetupWall.Unclock();
 			}
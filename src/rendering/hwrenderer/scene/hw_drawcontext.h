@@ -7,6 +7,7 @@
 struct HWDrawInfo;
 struct SortNode;
 struct FDynamicLight;
+struct FSection;
 class HWDrawContext;
 
 class FDrawInfoList
@@ -52,4 +53,5 @@ public:
 	FPortalSceneState portalState;
 
 	TArray<FDynamicLight*> addedLightsArray;
+	TArray<FSection*> addedSectionsArray;
 };
@@ -401,6 +401,7 @@ void HWDrawList::SortWallIntoWall(HWDrawInfo *di, FRenderState& state, SortNode
 // 
 //
 //==========================================================================
+EXTERN_CVAR(Bool, gl_batchsprites)
 EXTERN_CVAR(Int, gl_billboard_mode)
 EXTERN_CVAR(Bool, gl_billboard_faces_camera)
 EXTERN_CVAR(Bool, hw_force_cambbpref)
@@ -747,6 +748,45 @@ void HWDrawList::DoDraw(HWDrawInfo *di, FRenderState &state, bool translucent, i
 	}
 }
 
+//==========================================================================
+//
+// Draws an item of an 'equal' chain, together with as many of the
+// following sprites as can share its draw call. Returns the next
+// node to draw.
+//
+//==========================================================================
+SortNode * HWDrawList::DoDrawBatch(HWDrawInfo *di, FRenderState &state, SortNode * node)
+{
+	static TArray<HWSprite*> batch;
+
+	if (!gl_batchsprites || drawitems[node->itemindex].rendertype != DrawType_SPRITE)
+	{
+		DoDraw(di, state, true, node->itemindex);
+		return node->equal;
+	}
+
+	HWSprite * s = sprites[drawitems[node->itemindex].index];
+	SortNode * next = node->equal;
+
+	batch.Clear();
+	batch.Push(s);
+	if (s->IsBatchable(di))
+	{
+		// The chain is sorted back to front so only consecutive sprites can be merged.
+		for (; next && drawitems[next->itemindex].rendertype == DrawType_SPRITE; next = next->equal)
+		{
+			HWSprite * n = sprites[drawitems[next->itemindex].index];
+			if (!n->IsBatchable(di) || !s->CanBatchWith(n)) break;
+			batch.Push(n);
+		}
+	}
+
+	RenderSprite.Clock();
+	s->DrawSprite(di, state, true, batch.Data(), batch.Size());
+	RenderSprite.Unclock();
+	return next;
+}
+
 //==========================================================================
 //
 //
@@ -826,15 +866,10 @@ void HWDrawList::DrawSorted(HWDrawInfo *di, FRenderState &state, SortNode * head
 		DrawSorted(di, state, head->left);
 		state.SetClipSplit(clipsplit);
 	}
-	DoDraw(di, state, true, head->itemindex);
-	if (head->equal)
+	SortNode * ehead = head;
+	while (ehead)
 	{
-		SortNode * ehead = head->equal;
-		while (ehead)
-		{
-			DoDraw(di, state, true, ehead->itemindex);
-			ehead = ehead->equal;
-		}
+		ehead = DoDrawBatch(di, state, ehead);
 	}
 	// right is closer, i.e. for stuff above viewz its z coordinate is lower, for stuff below viewz its z coordinate is higher
 	if (head->right)
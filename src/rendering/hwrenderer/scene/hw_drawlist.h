@@ -108,6 +108,7 @@ struct HWDrawList
 	void Sort(HWDrawInfo *di, FRenderState& state);
 
 	void DoDraw(HWDrawInfo *di, FRenderState &state, bool translucent, int i);
+	SortNode * DoDrawBatch(HWDrawInfo *di, FRenderState &state, SortNode * node);
 	void Draw(HWDrawInfo *di, FRenderState &state, bool translucent);
 	void DrawWalls(HWDrawInfo *di, FRenderState &state, bool translucent);
 	void DrawFlats(HWDrawInfo *di, FRenderState &state, bool translucent);
@@ -305,6 +305,7 @@ public:
 
 public:
 	void Process(HWWallDispatcher* di, FRenderState& state, seg_t* seg, sector_t* frontsector, sector_t* backsector);
+	void ProcessCached(HWWallDispatcher* di, FRenderState& state, seg_t* seg, sector_t* frontsector, sector_t* backsector);
 	void ProcessLowerMiniseg(HWWallDispatcher* di, FRenderState& state, seg_t* seg, sector_t* frontsector, sector_t* backsector);
 
 	float PointOnSide(float x, float y)
@@ -418,12 +419,15 @@ public:
 public:
 
 	void CreateVertices(HWDrawInfo *di, FRenderState& state);
+	void CreateBatchVertices(HWDrawInfo *di, FRenderState& state, HWSprite **batch, unsigned count);
 	void PutSprite(HWDrawInfo *di, FRenderState& state, bool translucent);
 	void Process(HWDrawInfo *di, FRenderState& state, AActor* thing,sector_t * sector, area_t in_area, int thruportal = false, bool isSpriteShadow = false);
 	void ProcessParticle (HWDrawInfo *di, FRenderState& state, particle_t *particle, sector_t *sector);//, int shade, int fakeside)
 	void AdjustVisualThinker(HWDrawInfo *di, DVisualThinker *spr, sector_t *sector);
 
-	void DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent);
+	bool IsBatchable(HWDrawInfo *di);
+	bool CanBatchWith(HWSprite *other);
+	void DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent, HWSprite **batch = nullptr, unsigned batchcount = 0);
 };
 
 
@@ -465,6 +469,8 @@ inline float Dist2(float x1,float y1,float x2,float y2)
 }
 
 void hw_GetDynModelLight(HWDrawContext* drawctx, AActor *self, FDynLightData &modellightdata);
+void hw_BuildLightGrid(FLevelLocals *Level);
+void hw_ClearWallCache();
 
 extern const float LARGE_VALUE;
 
@@ -39,6 +39,164 @@
 #include "hwrenderer/scene/hw_drawstructs.h"
 #include "models.h"
 #include <cmath>	// needed for std::floor on mac
+#include <cfloat>
+
+CVAR(Bool, gl_lightgrid, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+//==========================================================================
+//
+// Uniform 2D grid of all active dynamic lights, rebuilt once per view.
+// The grid is built from the section links of the lights, so it sees
+// the same walls as the section light lists: every light is stored once
+// for each section it is linked into, in the cells where that section
+// and the light's radius overlap. A lookup then only needs the entries
+// of its own cell that belong to its own section, instead of every light
+// linked into a possibly huge section.
+//
+// Linked portals need per-group offsets for the light positions, so maps
+// with displacements keep using the section light lists.
+//
+//==========================================================================
+
+struct FLightGrid
+{
+	enum
+	{
+		MinCellSize = 128,
+		MaxCells = 256
+	};
+
+	struct Entry
+	{
+		FDynamicLight *light;
+		FSection *section;
+	};
+
+	FLevelLocals *Level = nullptr;
+	float MinX = 0, MinY = 0;
+	float InvCellSize = 0;
+	int Width = 0, Height = 0;
+	TArray<unsigned> CellStart;		// Width * Height + 1 entries, indices into Entries.
+	TArray<unsigned> CellFill;
+	TArray<Entry> Entries;
+
+	void Build(FLevelLocals *lvl);
+
+	void GetCellRange(float x1, float y1, float x2, float y2, int &cx1, int &cy1, int &cx2, int &cy2) const
+	{
+		cx1 = clamp(int((x1 - MinX) * InvCellSize), 0, Width - 1);
+		cy1 = clamp(int((y1 - MinY) * InvCellSize), 0, Height - 1);
+		cx2 = clamp(int((x2 - MinX) * InvCellSize), 0, Width - 1);
+		cy2 = clamp(int((y2 - MinY) * InvCellSize), 0, Height - 1);
+	}
+
+	// The part of the light's square that lies within one of its sections.
+	// Returns false if they do not overlap.
+	static bool GetOverlap(FDynamicLight *light, FSection *section, float &x1, float &y1, float &x2, float &y2)
+	{
+		float radius = light->GetRadius();
+		x1 = max((float)light->X() - radius, (float)section->bounds.left);
+		y1 = max((float)light->Y() - radius, (float)section->bounds.top);
+		x2 = min((float)light->X() + radius, (float)section->bounds.right);
+		y2 = min((float)light->Y() + radius, (float)section->bounds.bottom);
+		return x1 <= x2 && y1 <= y2;
+	}
+
+	template<class Func> void ForCell(int cx, int cy, Func &&f) const
+	{
+		unsigned cell = cy * Width + cx;
+		for (unsigned i = CellStart[cell]; i < CellStart[cell + 1]; i++)
+		{
+			f(Entries[i]);
+		}
+	}
+};
+
+static FLightGrid LightGrid;
+
+void FLightGrid::Build(FLevelLocals *lvl)
+{
+	Level = nullptr;
+	Width = Height = 0;
+	Entries.Clear();
+
+	if (!gl_lightgrid || lvl->Displacements.size > 0 || !lvl->HasDynamicLights)
+		return;
+
+	float x1 = FLT_MAX, y1 = FLT_MAX, x2 = -FLT_MAX, y2 = -FLT_MAX;
+	for (auto light = lvl->lights; light; light = light->next)
+	{
+		if (light->GetRadius() <= 0) continue;
+		for (auto node = light->touching_sector; node; node = node->nextTarget)
+		{
+			float lx1, ly1, lx2, ly2;
+			if (!GetOverlap(light, (FSection *)node->targ, lx1, ly1, lx2, ly2)) continue;
+			x1 = min(x1, lx1);
+			y1 = min(y1, ly1);
+			x2 = max(x2, lx2);
+			y2 = max(y2, ly2);
+		}
+	}
+
+	Level = lvl;
+	if (x1 > x2) return;	// no active lights.
+
+	float cellsize = max((float)MinCellSize, max(x2 - x1, y2 - y1) / MaxCells);
+	MinX = x1;
+	MinY = y1;
+	InvCellSize = 1.f / cellsize;
+	Width = int((x2 - x1) * InvCellSize) + 1;
+	Height = int((y2 - y1) * InvCellSize) + 1;
+
+	// Counting sort: first count the entries per cell, then place them.
+	unsigned numcells = Width * Height;
+	CellStart.Resize(numcells + 1);
+	memset(CellStart.Data(), 0, CellStart.Size() * sizeof(unsigned));
+
+	for (auto light = lvl->lights; light; light = light->next)
+	{
+		if (light->GetRadius() <= 0) continue;
+		for (auto node = light->touching_sector; node; node = node->nextTarget)
+		{
+			float lx1, ly1, lx2, ly2;
+			if (!GetOverlap(light, (FSection *)node->targ, lx1, ly1, lx2, ly2)) continue;
+			int cx1, cy1, cx2, cy2;
+			GetCellRange(lx1, ly1, lx2, ly2, cx1, cy1, cx2, cy2);
+			for (int cy = cy1; cy <= cy2; cy++)
+				for (int cx = cx1; cx <= cx2; cx++)
+					CellStart[cy * Width + cx + 1]++;
+		}
+	}
+	for (unsigned i = 0; i < numcells; i++)
+	{
+		CellStart[i + 1] += CellStart[i];
+	}
+
+	CellFill.Resize(numcells);
+	memcpy(CellFill.Data(), CellStart.Data(), numcells * sizeof(unsigned));
+	Entries.Resize(CellStart[numcells]);
+
+	for (auto light = lvl->lights; light; light = light->next)
+	{
+		if (light->GetRadius() <= 0) continue;
+		for (auto node = light->touching_sector; node; node = node->nextTarget)
+		{
+			auto section = (FSection *)node->targ;
+			float lx1, ly1, lx2, ly2;
+			if (!GetOverlap(light, section, lx1, ly1, lx2, ly2)) continue;
+			int cx1, cy1, cx2, cy2;
+			GetCellRange(lx1, ly1, lx2, ly2, cx1, cy1, cx2, cy2);
+			for (int cy = cy1; cy <= cy2; cy++)
+				for (int cx = cx1; cx <= cx2; cx++)
+					Entries[CellFill[cy * Width + cx]++] = { light, section };
+		}
+	}
+}
+
+void hw_BuildLightGrid(FLevelLocals *Level)
+{
+	LightGrid.Build(Level);
+}
 
 template<class T>
 T smoothstep(const T edge0, const T edge1, const T x)
@@ -60,9 +218,8 @@ public:
 		}
 	}
 
-	bool TraceLightVisbility(FLightNode* node, const FVector3& L, float dist)
+	bool TraceLightVisbility(FDynamicLight* light, const FVector3& L, float dist)
 	{
-		FDynamicLight* light = node->lightsource;
 		if (!light->Trace() || !level.levelMesh || !Actor)
 			return true;
 
@@ -114,10 +271,6 @@ public:
 
 void HWDrawInfo::GetDynSpriteLight(AActor *self, float x, float y, float z, FLightNode *node, int portalgroup, float *out)
 {
-	FDynamicLight *light;
-	float frac, lr, lg, lb;
-	float radius;
-	
 	out[0] = out[1] = out[2] = 0.f;
 
 	ActorTraceStaticLight staticLight(self);
@@ -129,12 +282,12 @@ void HWDrawInfo::GetDynSpriteLight(AActor *self, float x, float y, float z, FLig
 		out[2] = Level->SunColor.Z;
 	}
 
-	// Go through both light lists
-	while (node)
+	auto addLight = [&](FDynamicLight *light)
 	{
-		light=node->lightsource;
 		if (light->ShouldLightActor(self))
 		{
+			float frac, lr, lg, lb;
+			float radius;
 			float dist;
 			FVector3 L;
 
@@ -165,7 +318,7 @@ void HWDrawInfo::GetDynSpriteLight(AActor *self, float x, float y, float z, FLig
 				if (light->IsSpot() || light->Trace())
 					L *= -1.0f / dist;
 
-				if (staticLight.TraceLightVisbility(node, L, dist))
+				if (staticLight.TraceLightVisbility(light, L, dist))
 				{
 					frac = 1.0f - (dist / radius);
 
@@ -202,7 +355,33 @@ void HWDrawInfo::GetDynSpriteLight(AActor *self, float x, float y, float z, FLig
 				}
 			}
 		}
-		node = node->nextLight;
+	};
+
+	if (LightGrid.Level == Level)
+	{
+		// The light list is the one of a section, so its nodes point back to it. Without nodes there is nothing to find.
+		auto section = node ? (FSection *)node->targ : nullptr;
+		if (section && LightGrid.Width > 0 && x >= LightGrid.MinX && y >= LightGrid.MinY)
+		{
+			int cx = int((x - LightGrid.MinX) * LightGrid.InvCellSize);
+			int cy = int((y - LightGrid.MinY) * LightGrid.InvCellSize);
+			if (cx < LightGrid.Width && cy < LightGrid.Height)
+			{
+				LightGrid.ForCell(cx, cy, [&](const FLightGrid::Entry &entry)
+				{
+					if (entry.section == section) addLight(entry.light);
+				});
+			}
+		}
+	}
+	else
+	{
+		// Go through both light lists
+		while (node)
+		{
+			addLight(node->lightsource);
+			node = node->nextLight;
+		}
 	}
 }
 
@@ -243,41 +422,73 @@ void hw_GetDynModelLight(HWDrawContext* drawctx, AActor *self, FDynLightData &mo
 			AddSunLightToList(modellightdata, x, y, z, self->Level->SunDirection, self->Level->SunColor);
 		}
 
-		BSPWalkCircle(self->Level, x, y, radiusSquared, [&](subsector_t *subsector) // Iterate through all subsectors potentially touched by actor
+		auto checkLight = [&](FDynamicLight *light, int group)
 		{
-			auto section = subsector->section;
-			if (section->validcount == dl_validcount) return;	// already done from a previous subsector.
-			FLightNode * node = section->lighthead;
-			while (node) // check all lights touching a subsector
+			if (light->ShouldLightActor(self))
 			{
-				FDynamicLight *light = node->lightsource;
-				if (light->ShouldLightActor(self))
+				DVector3 pos = light->PosRelative(group);
+				float radius = (float)(light->GetRadius() + actorradius);
+				double dx = pos.X - x;
+				double dy = pos.Y - y;
+				double dz = pos.Z - z;
+				double distSquared = dx * dx + dy * dy + dz * dz;
+				if (distSquared < radius * radius) // Light and actor touches
 				{
-					int group = subsector->sector->PortalGroup;
-					DVector3 pos = light->PosRelative(group);
-					float radius = (float)(light->GetRadius() + actorradius);
-					double dx = pos.X - x;
-					double dy = pos.Y - y;
-					double dz = pos.Z - z;
-					double distSquared = dx * dx + dy * dy + dz * dz;
-					if (distSquared < radius * radius) // Light and actor touches
+					if (std::find(addedLights.begin(), addedLights.end(), light) == addedLights.end()) // Check if we already added this light from a different subsector
 					{
-						if (std::find(addedLights.begin(), addedLights.end(), light) == addedLights.end()) // Check if we already added this light from a different subsector
-						{
-							FVector3 L(dx, dy, dz);
-							float dist = sqrtf(distSquared);
-							if (light->Trace())
-								L *= 1.0f / dist;
-
-							if (staticLight.TraceLightVisbility(node, L, dist))
-							{
-								AddLightToList(modellightdata, group, light, true);
-							}
+						FVector3 L(dx, dy, dz);
+						float dist = sqrtf(distSquared);
+						if (light->Trace())
+							L *= 1.0f / dist;
 
-							addedLights.Push(light);
+						if (staticLight.TraceLightVisbility(light, L, dist))
+						{
+							AddLightToList(modellightdata, group, light, true);
 						}
+
+						addedLights.Push(light);
 					}
 				}
+			}
+		};
+
+		if (LightGrid.Level == self->Level)
+		{
+			if (LightGrid.Width > 0)
+			{
+				// Only lights linked into the sections under the model can reach it, just like below.
+				auto &sections = drawctx->addedSectionsArray;
+				sections.Clear();
+				BSPWalkCircle(self->Level, x, y, radiusSquared, [&](subsector_t *subsector)
+				{
+					if (subsector->section->lighthead && std::find(sections.begin(), sections.end(), subsector->section) == sections.end())
+					{
+						sections.Push(subsector->section);
+					}
+				});
+				if (sections.Size() == 0) return;
+
+				int group = self->Sector->PortalGroup;
+				int cx1, cy1, cx2, cy2;
+				LightGrid.GetCellRange(x - actorradius, y - actorradius, x + actorradius, y + actorradius, cx1, cy1, cx2, cy2);
+				for (int cy = cy1; cy <= cy2; cy++)
+					for (int cx = cx1; cx <= cx2; cx++)
+						LightGrid.ForCell(cx, cy, [&](const FLightGrid::Entry &entry)
+						{
+							if (std::find(sections.begin(), sections.end(), entry.section) != sections.end()) checkLight(entry.light, group);
+						});
+			}
+			return;
+		}
+
+		BSPWalkCircle(self->Level, x, y, radiusSquared, [&](subsector_t *subsector) // Iterate through all subsectors potentially touched by actor
+		{
+			auto section = subsector->section;
+			if (section->validcount == dl_validcount) return;	// already done from a previous subsector.
+			FLightNode * node = section->lighthead;
+			while (node) // check all lights touching a subsector
+			{
+				checkLight(node->lightsource, subsector->sector->PortalGroup);
 				node = node->nextLight;
 			}
 		});
@@ -87,6 +87,7 @@ CVAR(Int, gl_billboard_mode, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 CVAR(Bool, gl_billboard_faces_camera, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 CVAR(Bool, hw_force_cambbpref, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 CVAR(Bool, gl_billboard_particles, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Bool, gl_batchsprites, true, 0)
 CUSTOM_CVAR(Int, gl_fuzztype, 8, CVAR_ARCHIVE)
 {
 	if (self < 0 || self > 8) self = 0;
@@ -101,7 +102,7 @@ CVARD(Bool, r_showhitbox, false, CVAR_GLOBALCONFIG | CVAR_CHEAT, "show actor hit
 //
 //==========================================================================
 
-void HWSprite::DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent)
+void HWSprite::DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent, HWSprite **batch, unsigned batchcount)
 {
 	bool additivefog = false;
 	bool foglayer = false;
@@ -274,14 +275,16 @@ void HWSprite::DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent)
 		{
 			state.SetNormal(0, 0, 0);
 
-			CreateVertices(di, state);
+			if (batchcount > 1) CreateBatchVertices(di, state, batch, batchcount);
+			else CreateVertices(di, state);
 
 			if (polyoffset)
 			{
 				state.SetDepthBias(-1, -128);
 			}
 			state.SetLightIndex(-1);
-			state.Draw(DT_TriangleStrip, vertexindex, 4);
+			if (batchcount > 1) state.Draw(DT_Triangles, vertexindex, batchcount * 6);
+			else state.Draw(DT_TriangleStrip, vertexindex, 4);
 
 			if (foglayer)
 			{
@@ -596,6 +599,81 @@ void HWSprite::CreateVertices(HWDrawInfo *di, FRenderState& state)
 }
 
 
+//==========================================================================
+//
+// Puts the quads of a whole batch of sprites into one vertex range,
+// as a triangle list because strips cannot be concatenated.
+//
+//==========================================================================
+
+void HWSprite::CreateBatchVertices(HWDrawInfo *di, FRenderState& state, HWSprite **batch, unsigned count)
+{
+	auto vert = state.AllocVertices(count * 6);
+	auto vp = vert.first;
+	vertexindex = vert.second;
+	polyoffset = false;
+
+	for (unsigned i = 0; i < count; i++, vp += 6)
+	{
+		auto spr = batch[i];
+		FVector3 v[4];
+		spr->CalculateVertices(di, v, &di->Viewpoint.Pos);
+
+		vp[0].Set(v[0][0], v[0][1], v[0][2], spr->ul, spr->vt);
+		vp[1].Set(v[1][0], v[1][1], v[1][2], spr->ur, spr->vt);
+		vp[2].Set(v[2][0], v[2][1], v[2][2], spr->ul, spr->vb);
+		vp[3] = vp[2];
+		vp[4] = vp[1];
+		vp[5].Set(v[3][0], v[3][1], v[3][2], spr->ur, spr->vb);
+	}
+}
+
+//==========================================================================
+//
+// Sprites that only need a plain textured quad with no per-sprite
+// render state can be drawn together with their neighbours in the
+// sorted list if everything DrawSprite sets up is the same.
+//
+//==========================================================================
+
+bool HWSprite::IsBatchable(HWDrawInfo *di)
+{
+	if (modelframe != nullptr || lightlist != nullptr) return false;
+	if (topclip != LARGE_VALUE || bottomclip != -LARGE_VALUE) return false;
+
+	// these need special treatment in DrawSprite.
+	if (RenderStyle.BlendOp == STYLEOP_Shadow || RenderStyle.BlendOp == STYLEOP_RevSub || RenderStyle.BlendOp == STYLEOP_Sub) return false;
+	if (actor != nullptr && ((actor->renderflags & RF_SPRITETYPEMASK) == RF_FLATSPRITE || r_showhitbox)) return false;
+
+	// sprite lighting is calculated per sprite.
+	if (di->Level->HasDynamicLights && !di->isFullbrightScene() && !fullbright) return false;
+	return true;
+}
+
+static sector_t *GetSpriteSector(HWSprite *spr)
+{
+	return spr->actor ? spr->actor->Sector : spr->particle ? spr->particle->subsector->sector : nullptr;
+}
+
+bool HWSprite::CanBatchWith(HWSprite *other)
+{
+	if (texture != other->texture || translation != other->translation || OverrideShader != other->OverrideShader) return false;
+	if (RenderStyle != other->RenderStyle || hw_styleflags != other->hw_styleflags || trans != other->trans) return false;
+	if (lightlevel != other->lightlevel || foglevel != other->foglevel || fullbright != other->fullbright) return false;
+	if (ThingColor != other->ThingColor || Colormap != other->Colormap) return false;
+
+	// CTF_Expand and the ColorAdd substitution depend on the actor.
+	if ((actor == nullptr) != (other->actor == nullptr)) return false;
+	if (actor && (actor->renderflags & RF_SPRITETYPEMASK) != (other->actor->renderflags & RF_SPRITETYPEMASK)) return false;
+
+	auto sec = GetSpriteSector(this);
+	auto othersec = GetSpriteSector(other);
+	if (sec == othersec) return true;
+	if (sec == nullptr || othersec == nullptr) return false;
+	return sec->SpecialColors[sector_t::sprites] == othersec->SpecialColors[sector_t::sprites] &&
+		sec->AdditiveColors[sector_t::sprites] == othersec->AdditiveColors[sector_t::sprites];
+}
+
 //==========================================================================
 //
 // 
@@ -16,6 +16,55 @@ struct HWMeshHelper
 	TArray<HWMissing> upper;
 };
 
+// Records what HWWall::Process emits for one seg so that it can be replayed
+// in later frames without redoing the setup.
+struct HWCachedWallEvent
+{
+	enum EType
+	{
+		Wall,
+		Surface,
+		UpperMissing,
+		LowerMissing,
+	};
+
+	EType type;
+	bool translucent;
+	unsigned index;
+	LevelMeshSurface* surface;
+	HWMissing missing;
+};
+
+struct HWWallRecorder
+{
+	TArray<HWWall> walls;
+	TArray<HWCachedWallEvent> events;
+	bool uncacheable = false;
+
+	void Clear()
+	{
+		walls.Clear();
+		events.Clear();
+		uncacheable = false;
+	}
+
+	void AddWall(const HWWall& wall, bool translucent)
+	{
+		auto index = walls.Push(wall);
+		events.Push({ HWCachedWallEvent::Wall, translucent, index, nullptr, {} });
+	}
+
+	void AddSurface(LevelMeshSurface* surface)
+	{
+		events.Push({ HWCachedWallEvent::Surface, false, 0, surface, {} });
+	}
+
+	void AddMissing(HWCachedWallEvent::EType type, side_t* side, subsector_t* sub, float height)
+	{
+		events.Push({ type, false, 0, nullptr, { side, sub, height } });
+	}
+};
+
 
 struct HWWallDispatcher
 {
@@ -23,6 +72,7 @@ struct HWWallDispatcher
 	HWDrawInfo* di;
 	HWMeshHelper* mh;
 	ELightMode lightmode;
+	HWWallRecorder* rec = nullptr;
 
 	HWWallDispatcher(HWDrawInfo* info)
 	{
@@ -42,6 +92,7 @@ struct HWWallDispatcher
 
 	void AddUpperMissingTexture(side_t* side, subsector_t* sub, float height)
 	{
+		if (rec) rec->AddMissing(HWCachedWallEvent::UpperMissing, side, sub, height);
 		if (di) di->AddUpperMissingTexture(side, sub, height);
 		else
 		{
@@ -51,6 +102,7 @@ struct HWWallDispatcher
 	}
 	void AddLowerMissingTexture(side_t* side, subsector_t* sub, float height)
 	{
+		if (rec) rec->AddMissing(HWCachedWallEvent::LowerMissing, side, sub, height);
 		if (di) di->AddLowerMissingTexture(side, sub, height);
 		else
 		{
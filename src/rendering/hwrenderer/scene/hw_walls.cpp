@@ -489,6 +489,8 @@ const char HWWall::passflag[] = {
 //==========================================================================
 void HWWall::PutWall(HWWallDispatcher *di, FRenderState& state, bool translucent)
 {
+	if (di->rec) di->rec->AddWall(*this, translucent);
+
 	if (texture && texture->GetTranslucency() && passflag[type] == 2)
 	{
 		translucent = true;
@@ -556,6 +558,9 @@ void HWWall::PutPortal(HWWallDispatcher *di, FRenderState& state, int ptype, int
 {
 	HWPortal * portal = nullptr;
 
+	// Portals get linked into the current scene's portal list and cannot be replayed.
+	if (di->rec) di->rec->uncacheable = true;
+
 	auto ddi = di->di;
 	if (ddi)
 	{
@@ -1131,6 +1136,7 @@ void HWWall::DoTexture(HWWallDispatcher *di, FRenderState& state, int _type,seg_
 			if (surface && di->di)
 			{
 				di->di->PushVisibleSurface(surface);
+				if (di->rec) di->rec->AddSurface(surface);
 			}
 		}
 		else
@@ -1215,6 +1221,7 @@ void HWWall::DoMidTexture(HWWallDispatcher *di, FRenderState& state, seg_t * seg
 				if (surface && di->di)
 				{
 					di->di->PushVisibleSurface(surface);
+					if (di->rec) di->rec->AddSurface(surface);
 				}
 			}
 		}
@@ -1564,6 +1571,7 @@ void HWWall::BuildFFBlock(HWWallDispatcher *di, FRenderState& state, seg_t * seg
 		if (surface)
 		{
 			di->di->PushVisibleSurface(surface);
+			if (di->rec) di->rec->AddSurface(surface);
 		}
 	}
 	else
@@ -1910,6 +1918,7 @@ inline int CalcRelLight(int lightlevel, int orglightlevel, int rel)
 CVAR(Int, topskew, 0, 0)
 CVAR(Int, midskew, 0, 0)
 CVAR(Int, bottomskew, 0, 0);
+EXTERN_CVAR(Int, r_fakecontrast)
 
 //==========================================================================
 //
@@ -2346,6 +2355,239 @@ void HWWall::Process(HWWallDispatcher *di, FRenderState& state, seg_t *seg, sect
 	}
 }
 
+//==========================================================================
+//
+// Wall cache
+//
+// Most walls come out of Process identically in every frame. For those the
+// calls Process makes into the dispatcher are recorded per seg and replayed
+// as long as nothing Process reads has changed. Everything it reads is
+// copied into a key that gets compared byte by byte, so moving planes,
+// texture animations, light changes and scrollers simply re-record the seg.
+// PutWall itself is replayed, so anything depending on the view (translucent
+// sorting distance, decals, dynamic lights) is still done every frame.
+//
+// Segs with portals, skies, 3D floors, fake flats or polyobjects are not
+// cached at all.
+//
+//==========================================================================
+
+CVAR(Bool, gl_wallcache, true, 0)
+
+struct HWWallCacheSector
+{
+	uint8_t planes[sizeof(sector_t::splane) * 2];
+	uint8_t floorplane[sizeof(secplane_t)];
+	uint8_t ceilingplane[sizeof(secplane_t)];
+	uint32_t SpecialColors[5];
+	uint32_t AdditiveColors[5];
+	uint8_t Colormap[sizeof(FColormap)];
+	FGameTexture* textures[2];
+	unsigned Portals[2];
+	uint32_t Flags;
+	uint16_t MoreFlags;
+	short lightlevel;
+};
+
+struct HWWallCacheKey
+{
+	FLevelLocals* Level;
+	uint32_t levelflags[3];
+	int compatflags[3];
+	int fogdensity[2];
+	uint32_t outsidefog;
+	int wallhorizlight, wallvertlight;
+	int lightmode;
+	int fakecontrast;
+	int skew[3];
+	bool fullbright;
+	bool mirrors;
+	int skyflat;
+
+	double vertexes[4];
+	uint32_t lineflags[2];
+	int special;
+	double alpha;
+
+	uint8_t parts[sizeof(side_t::part) * 3];
+	FGameTexture* textures[3];
+	int16_t Light;
+	int16_t TierLights[3];
+	uint16_t sideflags;
+
+	HWWallCacheSector sectors[2];
+};
+
+struct HWCachedWall
+{
+	HWWallCacheKey key;
+	HWWallRecorder rec;
+};
+
+static TArray<std::unique_ptr<HWCachedWall>> WallCache;
+
+void hw_ClearWallCache()
+{
+	WallCache.Reset();
+}
+
+static bool IsWallCacheable(HWWallDispatcher* di, seg_t* seg, sector_t* frontsector, sector_t* backsector)
+{
+	auto Level = di->Level;
+	if (di->di == nullptr || gl_seamless) return false;
+	if (seg->sidedef->Flags & WALLF_POLYOBJ) return false;
+	if (seg->linedef->portalindex != UINT_MAX || seg->linedef->portaltransferred != UINT_MAX) return false;
+
+	for (auto sec : { frontsector, backsector })
+	{
+		if (sec == nullptr) continue;
+		// anything coming out of hw_FakeFlat can change with the view.
+		if (sec != &Level->sectors[sec->sectornum]) return false;
+		if (sec->e->XFloor.ffloors.Size() || sec->e->XFloor.lightlist.Size()) return false;
+	}
+	return true;
+}
+
+static void MakeWallCacheSector(HWWallCacheSector& key, sector_t* sec)
+{
+	if (sec == nullptr) return;
+	memcpy(key.planes, sec->planes, sizeof(key.planes));
+	memcpy(key.floorplane, &sec->floorplane, sizeof(key.floorplane));
+	memcpy(key.ceilingplane, &sec->ceilingplane, sizeof(key.ceilingplane));
+	memcpy(key.SpecialColors, sec->SpecialColors, sizeof(key.SpecialColors));
+	memcpy(key.AdditiveColors, sec->AdditiveColors, sizeof(key.AdditiveColors));
+	memcpy(key.Colormap, &sec->Colormap, sizeof(key.Colormap));
+	key.textures[0] = TexMan.GetGameTexture(sec->GetTexture(sector_t::floor), true);
+	key.textures[1] = TexMan.GetGameTexture(sec->GetTexture(sector_t::ceiling), true);
+	key.Portals[0] = sec->Portals[0];
+	key.Portals[1] = sec->Portals[1];
+	key.Flags = sec->Flags;
+	key.MoreFlags = sec->MoreFlags;
+	key.lightlevel = sec->lightlevel;
+}
+
+static void MakeWallCacheKey(HWWallCacheKey& key, HWWallDispatcher* di, seg_t* seg, sector_t* frontsector, sector_t* backsector)
+{
+	auto Level = di->Level;
+	auto line = seg->linedef;
+	auto side = seg->sidedef;
+
+	// The key gets compared with memcmp so the padding must be cleared, too.
+	memset(&key, 0, sizeof(key));
+
+	key.Level = Level;
+	key.levelflags[0] = Level->flags;
+	key.levelflags[1] = Level->flags2;
+	key.levelflags[2] = Level->flags3;
+	key.compatflags[0] = Level->i_compatflags;
+	key.compatflags[1] = Level->i_compatflags2;
+	key.compatflags[2] = Level->ib_compatflags;
+	key.fogdensity[0] = Level->fogdensity;
+	key.fogdensity[1] = Level->outsidefogdensity;
+	key.outsidefog = Level->info->outsidefog;
+	key.wallhorizlight = Level->WallHorizLight;
+	key.wallvertlight = Level->WallVertLight;
+	key.lightmode = (int)di->lightmode;
+	key.fakecontrast = r_fakecontrast;
+	key.skew[0] = topskew;
+	key.skew[1] = midskew;
+	key.skew[2] = bottomskew;
+	key.fullbright = di->isFullbrightScene();
+	key.mirrors = gl_mirrors;
+	key.skyflat = skyflatnum.GetIndex();
+
+	key.vertexes[0] = line->v1->fX();
+	key.vertexes[1] = line->v1->fY();
+	key.vertexes[2] = line->v2->fX();
+	key.vertexes[3] = line->v2->fY();
+	key.lineflags[0] = line->flags;
+	key.lineflags[1] = line->flags2;
+	key.special = line->special;
+	key.alpha = line->alpha;
+
+	memcpy(key.parts, side->textures, sizeof(key.parts));
+	for (int i = 0; i < 3; i++)
+	{
+		key.textures[i] = TexMan.GetGameTexture(side->GetTexture(i), true);
+		key.TierLights[i] = side->TierLights[i];
+	}
+	key.Light = side->Light;
+	key.sideflags = side->Flags;
+
+	MakeWallCacheSector(key.sectors[0], frontsector);
+	MakeWallCacheSector(key.sectors[1], backsector);
+}
+
+//==========================================================================
+//
+// Same as Process but replays the previous result for this seg if
+// nothing relevant has changed since it was recorded.
+//
+//==========================================================================
+
+void HWWall::ProcessCached(HWWallDispatcher *di, FRenderState& state, seg_t *seg, sector_t * frontsector, sector_t * backsector)
+{
+	if (!gl_wallcache || !IsWallCacheable(di, seg, frontsector, backsector))
+	{
+		Process(di, state, seg, frontsector, backsector);
+		return;
+	}
+
+	// Each seg only gets processed by one thread per scene and the scenes are rendered one after another,
+	// so the entries need no locking. The array itself only gets resized when the level changes.
+	if (WallCache.Size() != di->Level->segs.Size())
+	{
+		WallCache.Reset();
+		WallCache.Resize(di->Level->segs.Size());
+	}
+
+	HWWallCacheKey key;
+	MakeWallCacheKey(key, di, seg, frontsector, backsector);
+
+	auto& entry = WallCache[seg->Index()];
+	if (entry && !memcmp(&entry->key, &key, sizeof(key)))
+	{
+		if (entry->rec.uncacheable)
+		{
+			Process(di, state, seg, frontsector, backsector);
+			return;
+		}
+		for (auto& ev : entry->rec.events)
+		{
+			switch (ev.type)
+			{
+			case HWCachedWallEvent::Wall:
+			{
+				HWWall wall = entry->rec.walls[ev.index];
+				wall.PutWall(di, state, ev.translucent);
+				break;
+			}
+
+			case HWCachedWallEvent::Surface:
+				di->di->PushVisibleSurface(ev.surface);
+				break;
+
+			case HWCachedWallEvent::UpperMissing:
+				di->AddUpperMissingTexture(ev.missing.side, ev.missing.sub, (float)ev.missing.plane);
+				break;
+
+			case HWCachedWallEvent::LowerMissing:
+				di->AddLowerMissingTexture(ev.missing.side, ev.missing.sub, (float)ev.missing.plane);
+				break;
+			}
+		}
+		return;
+	}
+
+	if (!entry) entry.reset(new HWCachedWall);
+	// Copied bytewise so that the cleared padding survives for the memcmp above.
+	memcpy(&entry->key, &key, sizeof(key));
+	entry->rec.Clear();
+	di->rec = &entry->rec;
+	Process(di, state, seg, frontsector, backsector);
+	di->rec = nullptr;
+}
+
 //==========================================================================
 //
 // 
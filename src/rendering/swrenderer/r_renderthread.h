@@ -60,6 +60,7 @@ namespace swrenderer
 		int X1 = 0;
 		int X2 = MAXWIDTH;
 		bool MainThread = false;
+		double SliceTime = 0.0; // Milliseconds spent rendering X1 to X2 in the last frame
 
 		std::unique_ptr<RenderMemory> FrameMemory;
 		std::unique_ptr<RenderOpaquePass> OpaquePass;
@@ -63,11 +63,19 @@ EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
 CVAR(Int, r_scene_multithreaded, 1, 0);
+CVAR(Bool, r_scene_adaptiveslices, true, 0);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles;
+
+	struct SliceStat
+	{
+		int X1, X2;
+		double Time;
+	};
+	static std::vector<SliceStat> LastSliceStats;
 	
 	RenderScene::RenderScene()
 	{
@@ -186,14 +194,29 @@ namespace swrenderer
 			StartThreads(numThreads);
 		}
 
+		// Camera textures render at a different size, so only the main view adapts its slices.
+		// Canvas renders use equal slices of their own and leave the main view's edges alone.
+		bool canvas = MainThread()->Viewport->RenderingToCanvas;
+		bool adaptive = r_scene_adaptiveslices && numThreads > 1 && !canvas;
+		std::vector<int> equalEdges;
+		if (!adaptive || SliceEdges.size() != (size_t)numThreads + 1 || SliceEdges.back() != viewwidth)
+		{
+			equalEdges.resize(numThreads + 1);
+			for (int i = 0; i <= numThreads; i++)
+				equalEdges[i] = viewwidth * i / numThreads;
+			if (!canvas)
+				SliceEdges = equalEdges;
+		}
+		const std::vector<int> &edges = canvas ? equalEdges : SliceEdges;
+
 		// Setup threads:
 		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
 			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
+			Threads[i]->X1 = edges[i];
+			Threads[i]->X2 = edges[i + 1];
 		}
 		run_id++;
 		FSoftwareTexture::CurrentUpdate = run_id;
@@ -221,13 +244,55 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		if (!MainThread()->Viewport->RenderingToCanvas)
+		{
+			LastSliceStats.resize(numThreads);
+			for (int i = 0; i < numThreads; i++)
+				LastSliceStats[i] = { Threads[i]->X1, Threads[i]->X2, Threads[i]->SliceTime };
+		}
+		if (adaptive)
+		{
+			UpdateSliceEdges(numThreads);
+		}
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
 	}
 
+	void RenderScene::UpdateSliceEdges(int numThreads)
+	{
+		// Treat the time of each slice as spread evenly over its columns and place the
+		// new edges where the accumulated time reaches an equal share for every thread.
+		std::vector<double> accumulated(numThreads + 1);
+		accumulated[0] = 0.0;
+		for (int i = 0; i < numThreads; i++)
+			accumulated[i + 1] = accumulated[i] + std::max(Threads[i]->SliceTime, 0.001);
+
+		int minWidth = std::max(viewwidth / (numThreads * 4), 1);
+		int slice = 0;
+		for (int edge = 1; edge < numThreads; edge++)
+		{
+			double target = accumulated[numThreads] * edge / numThreads;
+			while (slice < numThreads - 1 && accumulated[slice + 1] <= target)
+				slice++;
+
+			RenderThread *thread = Threads[slice].get();
+			double t = (target - accumulated[slice]) / (accumulated[slice + 1] - accumulated[slice]);
+			double x = thread->X1 + t * (thread->X2 - thread->X1);
+
+			// Only move halfway there, so that a single slow frame does not make the edges jump around
+			int newedge = xs_RoundToInt((SliceEdges[edge] + x) * 0.5);
+			newedge = std::max(newedge, SliceEdges[edge - 1] + minWidth);
+			newedge = std::min(newedge, viewwidth - (numThreads - edge) * minWidth);
+			SliceEdges[edge] = newedge;
+		}
+	}
+
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
+		auto starttime = std::chrono::steady_clock::now();
+
 		thread->FrameMemory->Clear();
 		thread->Clip3D->Cleanup();
 		thread->Clip3D->ResetClip(); // reset clips (floor/ceiling)
@@ -260,6 +325,8 @@ namespace swrenderer
 			thread->TranslucentPass->Render();
 		}
 
+		thread->SliceTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - starttime).count();
+
 #if 0 // shows the render slice edges
 		if (thread->Viewport->RenderTarget->IsBgra())
 		{
@@ -396,6 +463,16 @@ namespace swrenderer
 		return out;
 	}
 
+	ADD_STAT(swslices)
+	{
+		FString out;
+		for (auto &stat : LastSliceStats)
+		{
+			out.AppendFormat("%d-%d: %04.1f ms  ", stat.X1, stat.X2, stat.Time);
+		}
+		return out;
+	}
+
 	static double f_acc, w_acc, p_acc, m_acc;
 	static int acc_c;
 
@@ -59,6 +59,7 @@ namespace swrenderer
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
 		void RenderThreadSlice(RenderThread *thread);
+		void UpdateSliceEdges(int numThreads);
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -75,5 +76,8 @@ namespace swrenderer
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
+
+		// Slice boundaries for the next frame, moved towards equal render time per thread
+		std::vector<int> SliceEdges;
 	};
 }
@@ -39,7 +39,39 @@
 #include "m_alloc.h"
 #include "imagehelpers.h"
 #include "texturemanager.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "stats.h"
 #include <mutex>
+#include <vector>
+#include <cstring>
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
+// Copies a row-major image into column-major order. Works on small tiles so
+// that both the reads and the writes stay in the cache for large textures.
+template<typename DestType, typename SrcType, typename Func>
+static void TransposeToColumns(DestType *dest, const SrcType *src, int width, int height, Func convert)
+{
+	const int tilesize = 16;
+	for (int x0 = 0; x0 < width; x0 += tilesize)
+	{
+		int x1 = min(x0 + tilesize, width);
+		for (int y0 = 0; y0 < height; y0 += tilesize)
+		{
+			int y1 = min(y0 + tilesize, height);
+			for (int x = x0; x < x1; x++)
+			{
+				for (int y = y0; y < y1; y++)
+				{
+					dest[y + x * height] = convert(src[x + y * width]);
+				}
+			}
+		}
+	}
+}
 
 inline EUpscaleFlags scaleFlagFromUseType(ETextureType useType)
 {
@@ -115,45 +147,49 @@ void FSoftwareTexture::CalcBitSize ()
 
 //==========================================================================
 //
-// 
+// Reading the image goes through the shared image source and file system
+// code, which is not thread safe, so only that part is serialized across
+// all textures. The conversion to columns and the mipmaps are done outside
+// the lock into a local buffer, which then replaces the old pixels at once.
+//
+// The caller must hold UpdateMutex, so only one thread at a time rebuilds
+// and publishes the pixels of a texture.
 //
 //==========================================================================
 
+namespace swrenderer { extern std::mutex loadmutex; }
+
 const uint8_t *FSoftwareTexture::GetPixelsLocked(int style)
 {
 	if (Pixels.Size() == 0 || CheckModified(style))
 	{
-		if (mPhysicalScale == 1)
+		TArray<uint8_t> pixels;
+		FTextureBuffer tempbuffer;
 		{
-			Pixels = mSource->Get8BitPixels(style);
+			std::unique_lock<std::mutex> lock(swrenderer::loadmutex);
+			if (Pixels.Size() != 0 && !CheckModified(style))
+				return Pixels.Data();
+
+			if (mPhysicalScale == 1)
+				pixels = mSource->Get8BitPixels(style);
+			else
+				tempbuffer = mSource->CreateTexBuffer(0, mBufferFlags);
 		}
-		else
+
+		if (mPhysicalScale != 1)
 		{
-			auto f = mBufferFlags;
-			auto tempbuffer = mSource->CreateTexBuffer(0, f);
-			Pixels.Resize(GetPhysicalWidth()*GetPhysicalHeight());
+			pixels.Resize(GetPhysicalWidth()*GetPhysicalHeight());
 			PalEntry *pe = (PalEntry*)tempbuffer.mBuffer;
 			if (!style)
 			{
-				for (int y = 0; y < GetPhysicalHeight(); y++)
-				{
-					for (int x = 0; x < GetPhysicalWidth(); x++)
-					{
-						Pixels[y + x * GetPhysicalHeight()] = ImageHelpers::RGBToPalette(false, pe[x + y * GetPhysicalWidth()], true);
-					}
-				}
+				TransposeToColumns(pixels.Data(), pe, GetPhysicalWidth(), GetPhysicalHeight(), [](PalEntry c) { return ImageHelpers::RGBToPalette(false, c, true); });
 			}
 			else
 			{
-				for (int y = 0; y < GetPhysicalHeight(); y++)
-				{
-					for (int x = 0; x < GetPhysicalWidth(); x++)
-					{
-						Pixels[y + x * GetPhysicalHeight()] = pe[x + y * GetPhysicalWidth()].Luminance();
-					}
-				}
+				TransposeToColumns(pixels.Data(), pe, GetPhysicalWidth(), GetPhysicalHeight(), [](PalEntry c) { return (uint8_t)c.Luminance(); });
 			}
 		}
+		Pixels = std::move(pixels);
 	}
 	return Pixels.Data();
 }
@@ -162,25 +198,32 @@ const uint32_t *FSoftwareTexture::GetPixelsBgraLocked()
 {
 	if (PixelsBgra.Size() == 0 || CheckModified(2))
 	{
+		TArray<uint32_t> pixels;
+		FBitmap bitmap;
+		FTextureBuffer tempbuffer;
+		{
+			std::unique_lock<std::mutex> lock(swrenderer::loadmutex);
+			if (PixelsBgra.Size() != 0 && !CheckModified(2))
+				return PixelsBgra.Data();
+
+			if (mPhysicalScale == 1)
+				bitmap = mSource->GetBgraBitmap(nullptr);
+			else
+				tempbuffer = mSource->CreateTexBuffer(0, mBufferFlags);
+		}
+
 		if (mPhysicalScale == 1)
 		{
-			FBitmap bitmap = mSource->GetBgraBitmap(nullptr);
-			GenerateBgraFromBitmap(bitmap);
+			GenerateBgraFromBitmap(pixels, bitmap);
 		}
 		else
 		{
-			auto tempbuffer = mSource->CreateTexBuffer(0, mBufferFlags);
-			CreatePixelsBgraWithMipmaps();
+			CreatePixelsBgraWithMipmaps(pixels);
 			PalEntry *pe = (PalEntry*)tempbuffer.mBuffer;
-			for (int y = 0; y < GetPhysicalHeight(); y++)
-			{
-				for (int x = 0; x < GetPhysicalWidth(); x++)
-				{
-					PixelsBgra[y + x * GetPhysicalHeight()] = pe[x + y * GetPhysicalWidth()];
-				}
-			}
-			GenerateBgraMipmaps();
+			TransposeToColumns(pixels.Data(), pe, GetPhysicalWidth(), GetPhysicalHeight(), [](PalEntry c) { return (uint32_t)c; });
+			GenerateBgraMipmaps(pixels);
 		}
+		PixelsBgra = std::move(pixels);
 	}
 	return PixelsBgra.Data();
 }
@@ -192,12 +235,11 @@ const uint32_t *FSoftwareTexture::GetPixelsBgraLocked()
 //==========================================================================
 
 int FSoftwareTexture::CurrentUpdate = 0;
-namespace swrenderer { extern std::mutex loadmutex; }
 
 void FSoftwareTexture::UpdatePixels(int index)
 {
-	std::unique_lock<std::mutex> lock(swrenderer::loadmutex);
-	if (Unlockeddata[index].LastUpdate != CurrentUpdate)
+	std::unique_lock<std::mutex> lock(UpdateMutex);
+	if (Unlockeddata[index].LastUpdate.load(std::memory_order_relaxed) != CurrentUpdate)
 	{
 		if (index != 2)
 		{
@@ -205,7 +247,6 @@ void FSoftwareTexture::UpdatePixels(int index)
 			if (Spandata[index] == nullptr)
 				Spandata[index] = CreateSpans(Pixeldata);
 			Unlockeddata[index].Pixels = Pixeldata;
-			Unlockeddata[index].LastUpdate = CurrentUpdate;
 		}
 		else
 		{
@@ -213,8 +254,8 @@ void FSoftwareTexture::UpdatePixels(int index)
 			if (Spandata[index] == nullptr)
 				Spandata[index] = CreateSpans(Pixeldata);
 			Unlockeddata[index].Pixels = Pixeldata;
-			Unlockeddata[index].LastUpdate = CurrentUpdate;
 		}
+		Unlockeddata[index].LastUpdate.store(CurrentUpdate, std::memory_order_release);
 	}
 }
 
@@ -336,106 +377,243 @@ void FSoftwareTexture::FreeSpans (FSoftwareTextureSpan **spans)
 
 //==========================================================================
 //
-// 
+// Mipmap generation helpers
+//
+// The images are stored column-major (y + x * height), like everything
+// else in the software renderer.
 //
 //==========================================================================
 
-void FSoftwareTexture::GenerateBgraFromBitmap(const FBitmap &bitmap)
+namespace
 {
-	CreatePixelsBgraWithMipmaps();
+	struct Color4f
+	{
+		float a, r, g, b;
+		Color4f operator*(const Color4f &v) const { return Color4f{ a * v.a, r * v.r, g * v.g, b * v.b }; }
+		Color4f operator/(const Color4f &v) const { return Color4f{ a / v.a, r / v.r, g / v.g, b / v.b }; }
+		Color4f operator+(const Color4f &v) const { return Color4f{ a + v.a, r + v.r, g + v.g, b + v.b }; }
+		Color4f operator-(const Color4f &v) const { return Color4f{ a - v.a, r - v.r, g - v.g, b - v.b }; }
+		Color4f operator*(float s) const { return Color4f{ a * s, r * s, g * s, b * s }; }
+		Color4f operator/(float s) const { return Color4f{ a / s, r / s, g / s, b / s }; }
+		Color4f operator+(float s) const { return Color4f{ a + s, r + s, g + s, b + s }; }
+		Color4f operator-(float s) const { return Color4f{ a - s, r - s, g - s, b - s }; }
+	};
 
-	// Transpose
-	const uint32_t *src = (const uint32_t *)bitmap.GetPixels();
-	uint32_t *dest = PixelsBgra.Data();
-	for (int x = 0; x < GetPhysicalWidth(); x++)
+	// Gamma 2.2 conversion tables. They are built with the exact expressions the
+	// reference code evaluates per channel, so the output stays bit identical.
+	struct GammaTables
 	{
-		for (int y = 0; y < GetPhysicalHeight(); y++)
+		float ToLinear[256];
+
+		// Smallest linear value that encodes to each 8-bit sRGB value. Entry 0 is unused.
+		float ToSRGBThreshold[256];
+
+		GammaTables()
 		{
-			dest[y + x * GetPhysicalHeight()] = src[x + y * GetPhysicalWidth()];
+			for (int i = 0; i < 256; i++)
+				ToLinear[i] = powf(i * (1.0f / 255.0f), 2.2f);
+
+			ToSRGBThreshold[0] = 0.0f;
+			for (uint32_t i = 1; i < 256; i++)
+			{
+				// Binary search over the bit patterns of the non-negative floats up to 1.0
+				uint32_t lo = 0, hi = 0x3f800000;
+				while (lo < hi)
+				{
+					uint32_t mid = lo + (hi - lo) / 2;
+					float v;
+					memcpy(&v, &mid, sizeof(float));
+					if (EncodeReference(v) >= i)
+						hi = mid;
+					else
+						lo = mid + 1;
+				}
+				memcpy(&ToSRGBThreshold[i], &lo, sizeof(float));
+			}
 		}
-	}
 
-	GenerateBgraMipmaps();
-}
+		static uint32_t EncodeReference(float v)
+		{
+			return (uint32_t)clamp(powf(max(v, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
+		}
 
-void FSoftwareTexture::CreatePixelsBgraWithMipmaps()
-{
-	int levels = MipmapLevels();
-	int buffersize = 0;
-	for (int i = 0; i < levels; i++)
+		uint32_t Encode(float v) const
+		{
+			uint32_t pos = 0;
+			for (uint32_t step = 128; step != 0; step >>= 1)
+			{
+				if (ToSRGBThreshold[pos + step] <= v)
+					pos += step;
+			}
+			return pos;
+		}
+	};
+
+	const GammaTables &GetGammaTables()
 	{
-		int w = max(GetPhysicalWidth() >> i, 1);
-		int h = max(GetPhysicalHeight() >> i, 1);
-		buffersize += w * h;
+		static GammaTables tables;
+		return tables;
 	}
-	PixelsBgra.Resize(buffersize);
-}
 
-int FSoftwareTexture::MipmapLevels()
-{
-	int widthbits = 0;
-	while ((GetPhysicalWidth() >> widthbits) != 0) widthbits++;
+	int GetMipmapLevels(int width, int height)
+	{
+		int widthbits = 0;
+		while ((width >> widthbits) != 0) widthbits++;
 
-	int heightbits = 0;
-	while ((GetPhysicalHeight() >> heightbits) != 0) heightbits++;
+		int heightbits = 0;
+		while ((height >> heightbits) != 0) heightbits++;
 
-	return max(widthbits, heightbits);
-}
+		return max(widthbits, heightbits);
+	}
 
-//==========================================================================
-//
-// 
-//
-//==========================================================================
+	// Box filters src into dest (half the size)
+	void DownscaleMipmap(Color4f *dest, const Color4f *src, int srcw, int srch, int w, int h)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			int sx0 = x * 2;
+			int sx1 = min((x + 1) * 2, srcw - 1);
+			for (int y = 0; y < h; y++)
+			{
+				int sy0 = y * 2;
+				int sy1 = min((y + 1) * 2, srch - 1);
+
+#ifndef NO_SSE
+				__m128 src00 = _mm_loadu_ps(&src[sy0 + sx0 * srch].a);
+				__m128 src01 = _mm_loadu_ps(&src[sy1 + sx0 * srch].a);
+				__m128 src10 = _mm_loadu_ps(&src[sy0 + sx1 * srch].a);
+				__m128 src11 = _mm_loadu_ps(&src[sy1 + sx1 * srch].a);
+				__m128 c = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(src00, src01), src10), src11), _mm_set1_ps(0.25f));
+				_mm_storeu_ps(&dest[y + x * h].a, c);
+#else
+				Color4f src00 = src[sy0 + sx0 * srch];
+				Color4f src01 = src[sy1 + sx0 * srch];
+				Color4f src10 = src[sy0 + sx1 * srch];
+				Color4f src11 = src[sy1 + sx1 * srch];
+				dest[y + x * h] = (src00 + src01 + src10 + src11) * 0.25f;
+#endif
+			}
+		}
+	}
 
-void FSoftwareTexture::GenerateBgraMipmaps()
-{
-	struct Color4f
+	// Sharpen filter with a 3x3 kernel, wrapping around at the edges
+	void SharpenMipmap(Color4f *dest, Color4f *smoothed, int w, int h)
 	{
-		float a, r, g, b;
-		Color4f operator*(const Color4f &v) const { return Color4f{ a * v.a, r * v.r, g * v.g, b * v.b }; }
-		Color4f operator/(const Color4f &v) const { return Color4f{ a / v.a, r / v.r, g / v.g, b / v.b }; }
-		Color4f operator+(const Color4f &v) const { return Color4f{ a + v.a, r + v.r, g + v.g, b + v.b }; }
-		Color4f operator-(const Color4f &v) const { return Color4f{ a - v.a, r - v.r, g - v.g, b - v.b }; }
-		Color4f operator*(float s) const { return Color4f{ a * s, r * s, g * s, b * s }; }
-		Color4f operator/(float s) const { return Color4f{ a / s, r / s, g / s, b / s }; }
-		Color4f operator+(float s) const { return Color4f{ a + s, r + s, g + s, b + s }; }
-		Color4f operator-(float s) const { return Color4f{ a - s, r - s, g - s, b - s }; }
-	};
+		for (int x = 0; x < w; x++)
+		{
+			int columns[3] = { x > 0 ? x - 1 : w - 1, x, x + 1 < w ? x + 1 : 0 };
+			for (int y = 0; y < h; y++)
+			{
+				int rows[3] = { y > 0 ? y - 1 : h - 1, y, y + 1 < h ? y + 1 : 0 };
+#ifndef NO_SSE
+				__m128 c = _mm_setzero_ps();
+				for (int kx = 0; kx < 3; kx++)
+				{
+					for (int ky = 0; ky < 3; ky++)
+					{
+						c = _mm_add_ps(c, _mm_loadu_ps(&dest[rows[ky] + columns[kx] * h].a));
+					}
+				}
+				_mm_storeu_ps(&smoothed[y + x * h].a, _mm_mul_ps(c, _mm_set1_ps(1.0f / 9.0f)));
+#else
+				Color4f c = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (int kx = 0; kx < 3; kx++)
+				{
+					for (int ky = 0; ky < 3; ky++)
+					{
+						c = c + dest[rows[ky] + columns[kx] * h];
+					}
+				}
+				smoothed[y + x * h] = c * (1.0f / 9.0f);
+#endif
+			}
+		}
 
-	int levels = MipmapLevels();
-	std::vector<Color4f> image(PixelsBgra.Size());
+		float k = 0.08f;
+#ifndef NO_SSE
+		__m128 mk = _mm_set1_ps(k);
+		for (int j = 0; j < w * h; j++)
+		{
+			__m128 d = _mm_loadu_ps(&dest[j].a);
+			__m128 s = _mm_loadu_ps(&smoothed[j].a);
+			_mm_storeu_ps(&dest[j].a, _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(d, s), mk)));
+		}
+#else
+		for (int j = 0; j < w * h; j++)
+			dest[j] = dest[j] + (dest[j] - smoothed[j]) * k;
+#endif
+	}
 
-	// Convert to normalized linear colorspace
+	// Fills in all mipmap levels after the first one
+	void BuildBgraMipmaps(uint32_t *pixels, int width, int height, int levels)
 	{
-		for (int x = 0; x < GetPhysicalWidth(); x++)
+		const GammaTables &tables = GetGammaTables();
+		std::vector<Color4f> image(width * height * 2);
+
+		// Convert to normalized linear colorspace
+		for (int j = 0; j < width * height; j++)
 		{
-			for (int y = 0; y < GetPhysicalHeight(); y++)
+			uint32_t c8 = pixels[j];
+			image[j] = { tables.ToLinear[APART(c8)], tables.ToLinear[RPART(c8)], tables.ToLinear[GPART(c8)], tables.ToLinear[BPART(c8)] };
+		}
+
+		// Generate mipmaps. The next level never needs more space than the current one,
+		// so two buffers are enough: the source level and the level being built.
+		std::vector<Color4f> smoothed(width * height);
+		Color4f *src = image.data();
+		Color4f *dest = src + width * height;
+		uint32_t *destpixels = pixels + width * height;
+		for (int i = 1; i < levels; i++)
+		{
+			int srcw = max(width >> (i - 1), 1);
+			int srch = max(height >> (i - 1), 1);
+			int w = max(width >> i, 1);
+			int h = max(height >> i, 1);
+
+			DownscaleMipmap(dest, src, srcw, srch, w, h);
+			SharpenMipmap(dest, smoothed.data(), w, h);
+
+			// Convert to bgra8 sRGB colorspace
+			for (int j = 0; j < w * h; j++)
 			{
-				uint32_t c8 = PixelsBgra[x * GetPhysicalHeight() + y];
-				Color4f c;
-				c.a = powf(APART(c8) * (1.0f / 255.0f), 2.2f);
-				c.r = powf(RPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.g = powf(GPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.b = powf(BPART(c8) * (1.0f / 255.0f), 2.2f);
-				image[x * GetPhysicalHeight() + y] = c;
+				uint32_t a = tables.Encode(dest[j].a);
+				uint32_t r = tables.Encode(dest[j].r);
+				uint32_t g = tables.Encode(dest[j].g);
+				uint32_t b = tables.Encode(dest[j].b);
+				destpixels[j] = (a << 24) | (r << 16) | (g << 8) | b;
 			}
+
+			std::swap(src, dest);
+			destpixels += w * h;
 		}
 	}
 
-	// Generate mipmaps
+	// The original scalar implementation. Only used by the swmipmapbench command to validate BuildBgraMipmaps.
+	void BuildBgraMipmapsReference(uint32_t *pixels, int width, int height, int levels)
 	{
-		std::vector<Color4f> smoothed(GetPhysicalWidth() * GetPhysicalHeight());
+		std::vector<Color4f> image(width * height * 2);
+		for (int j = 0; j < width * height; j++)
+		{
+			uint32_t c8 = pixels[j];
+			Color4f c;
+			c.a = powf(APART(c8) * (1.0f / 255.0f), 2.2f);
+			c.r = powf(RPART(c8) * (1.0f / 255.0f), 2.2f);
+			c.g = powf(GPART(c8) * (1.0f / 255.0f), 2.2f);
+			c.b = powf(BPART(c8) * (1.0f / 255.0f), 2.2f);
+			image[j] = c;
+		}
+
+		std::vector<Color4f> smoothed(width * height);
 		Color4f *src = image.data();
-		Color4f *dest = src + GetPhysicalWidth() * GetPhysicalHeight();
+		Color4f *dest = src + width * height;
+		uint32_t *destpixels = pixels + width * height;
 		for (int i = 1; i < levels; i++)
 		{
-			int srcw = max(GetPhysicalWidth() >> (i - 1), 1);
-			int srch = max(GetPhysicalHeight() >> (i - 1), 1);
-			int w = max(GetPhysicalWidth() >> i, 1);
-			int h = max(GetPhysicalHeight() >> i, 1);
+			int srcw = max(width >> (i - 1), 1);
+			int srch = max(height >> (i - 1), 1);
+			int w = max(width >> i, 1);
+			int h = max(height >> i, 1);
 
-			// Downscale
 			for (int x = 0; x < w; x++)
 			{
 				int sx0 = x * 2;
@@ -444,18 +622,14 @@ void FSoftwareTexture::GenerateBgraMipmaps()
 				{
 					int sy0 = y * 2;
 					int sy1 = min((y + 1) * 2, srch - 1);
-
 					Color4f src00 = src[sy0 + sx0 * srch];
 					Color4f src01 = src[sy1 + sx0 * srch];
 					Color4f src10 = src[sy0 + sx1 * srch];
 					Color4f src11 = src[sy1 + sx1 * srch];
-					Color4f c = (src00 + src01 + src10 + src11) * 0.25f;
-
-					dest[y + x * h] = c;
+					dest[y + x * h] = (src00 + src01 + src10 + src11) * 0.25f;
 				}
 			}
 
-			// Sharpen filter with a 3x3 kernel:
 			for (int x = 0; x < w; x++)
 			{
 				for (int y = 0; y < h; y++)
@@ -474,41 +648,123 @@ void FSoftwareTexture::GenerateBgraMipmaps()
 							c = c + dest[a + b * h];
 						}
 					}
-					c = c * (1.0f / 9.0f);
-					smoothed[y + x * h] = c;
+					smoothed[y + x * h] = c * (1.0f / 9.0f);
 				}
 			}
 			float k = 0.08f;
 			for (int j = 0; j < w * h; j++)
 				dest[j] = dest[j] + (dest[j] - smoothed[j]) * k;
 
-			src = dest;
-			dest += w * h;
-		}
-	}
-
-	// Convert to bgra8 sRGB colorspace
-	{
-		Color4f *src = image.data() + GetPhysicalWidth() * GetPhysicalHeight();
-		uint32_t *dest = PixelsBgra.Data() + GetPhysicalWidth() * GetPhysicalHeight();
-		for (int i = 1; i < levels; i++)
-		{
-			int w = max(GetPhysicalWidth() >> i, 1);
-			int h = max(GetPhysicalHeight() >> i, 1);
 			for (int j = 0; j < w * h; j++)
 			{
-				uint32_t a = (uint32_t)clamp(powf(max(src[j].a, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t r = (uint32_t)clamp(powf(max(src[j].r, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t g = (uint32_t)clamp(powf(max(src[j].g, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t b = (uint32_t)clamp(powf(max(src[j].b, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				dest[j] = (a << 24) | (r << 16) | (g << 8) | b;
+				uint32_t a = GammaTables::EncodeReference(dest[j].a);
+				uint32_t r = GammaTables::EncodeReference(dest[j].r);
+				uint32_t g = GammaTables::EncodeReference(dest[j].g);
+				uint32_t b = GammaTables::EncodeReference(dest[j].b);
+				destpixels[j] = (a << 24) | (r << 16) | (g << 8) | b;
 			}
-			src += w * h;
-			dest += w * h;
+
+			std::swap(src, dest);
+			destpixels += w * h;
 		}
 	}
 }
 
+//==========================================================================
+//
+// 
+//
+//==========================================================================
+
+void FSoftwareTexture::GenerateBgraFromBitmap(TArray<uint32_t> &pixels, const FBitmap &bitmap)
+{
+	CreatePixelsBgraWithMipmaps(pixels);
+
+	// Transpose
+	TransposeToColumns(pixels.Data(), (const uint32_t *)bitmap.GetPixels(), GetPhysicalWidth(), GetPhysicalHeight(), [](uint32_t c) { return c; });
+
+	GenerateBgraMipmaps(pixels);
+}
+
+void FSoftwareTexture::CreatePixelsBgraWithMipmaps(TArray<uint32_t> &pixels)
+{
+	int levels = MipmapLevels();
+	int buffersize = 0;
+	for (int i = 0; i < levels; i++)
+	{
+		int w = max(GetPhysicalWidth() >> i, 1);
+		int h = max(GetPhysicalHeight() >> i, 1);
+		buffersize += w * h;
+	}
+	pixels.Resize(buffersize);
+}
+
+int FSoftwareTexture::MipmapLevels()
+{
+	return GetMipmapLevels(GetPhysicalWidth(), GetPhysicalHeight());
+}
+
+//==========================================================================
+//
+// 
+//
+//==========================================================================
+
+void FSoftwareTexture::GenerateBgraMipmaps(TArray<uint32_t> &pixels)
+{
+	BuildBgraMipmaps(pixels.Data(), GetPhysicalWidth(), GetPhysicalHeight(), MipmapLevels());
+}
+
+//==========================================================================
+//
+// Compares the mipmap builder against the scalar reference implementation
+//
+//==========================================================================
+
+CCMD(swmipmapbench)
+{
+	int size = argv.argc() > 1 ? clamp((int)strtol(argv[1], nullptr, 0), 1, 4096) : 256;
+	int count = argv.argc() > 2 ? clamp((int)strtol(argv[2], nullptr, 0), 1, 1000) : 20;
+
+	int levels = GetMipmapLevels(size, size);
+	int buffersize = 0;
+	for (int i = 0; i < levels; i++)
+		buffersize += max(size >> i, 1) * max(size >> i, 1);
+
+	std::vector<uint32_t> source(buffersize);
+	uint32_t seed = 0x12345678;
+	for (int j = 0; j < size * size; j++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		source[j] = seed;
+	}
+
+	std::vector<uint32_t> reference = source, result = source;
+	cycle_t referenceTime, resultTime;
+	referenceTime.Reset();
+	resultTime.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		referenceTime.Clock();
+		BuildBgraMipmapsReference(reference.data(), size, size, levels);
+		referenceTime.Unclock();
+
+		resultTime.Clock();
+		BuildBgraMipmaps(result.data(), size, size, levels);
+		resultTime.Unclock();
+	}
+
+	int mismatches = 0;
+	for (int j = 0; j < buffersize; j++)
+	{
+		if (reference[j] != result[j])
+			mismatches++;
+	}
+
+	Printf("%dx%d, %d runs: reference %.3f ms, current %.3f ms, %d mismatched texels\n", size, size, count,
+		referenceTime.TimeMS() / count, resultTime.TimeMS() / count, mismatches);
+}
+
 //==========================================================================
 //
 //
@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include "textures.h"
 #include "v_video.h"
 #include "g_levellocals.h"
@@ -23,8 +25,9 @@ protected:
 	struct
 	{
 		const void* Pixels = nullptr;
-		int LastUpdate = -1;
+		std::atomic<int> LastUpdate{ -1 };
 	} Unlockeddata[3];
+	std::mutex UpdateMutex;	// Serializes updates of this texture. Render threads working on other textures are not blocked.
 	FSoftwareTextureSpan **Spandata[3] = { };
 	DVector2 Scale;
 	uint8_t WidthBits = 0, HeightBits = 0;
@@ -99,7 +102,11 @@ public:
 	{
 		Pixels.Reset();
 		PixelsBgra.Reset();
-		for (auto& d : Unlockeddata) d = {};
+		for (auto& d : Unlockeddata)
+		{
+			d.Pixels = nullptr;
+			d.LastUpdate = -1;
+		}
 	}
 	
 	// Returns true if the next call to GetPixels() will return an image different from the
@@ -107,9 +114,9 @@ public:
 	// is immediately followed by a call to GetPixels().
 	virtual bool CheckModified (int which) { return false; }
 
-	void GenerateBgraFromBitmap(const FBitmap &bitmap);
-	void CreatePixelsBgraWithMipmaps();
-	void GenerateBgraMipmaps();
+	void GenerateBgraFromBitmap(TArray<uint32_t> &pixels, const FBitmap &bitmap);
+	void CreatePixelsBgraWithMipmaps(TArray<uint32_t> &pixels);
+	void GenerateBgraMipmaps(TArray<uint32_t> &pixels);
 	int MipmapLevels();
 	
 	// Returns true if GetPixelsBgra includes mipmaps
@@ -155,7 +162,7 @@ public:
 	const uint32_t* GetPixelsBgra()
 	{
 		int style = 2;
-		if (Unlockeddata[2].LastUpdate == CurrentUpdate)
+		if (Unlockeddata[2].LastUpdate.load(std::memory_order_acquire) == CurrentUpdate)
 		{
 			return static_cast<const uint32_t*>(Unlockeddata[style].Pixels);
 		}
@@ -169,7 +176,7 @@ public:
 	// Returns the whole texture, stored in column-major order
 	const uint8_t* GetPixels(int style)
 	{
-		if (Unlockeddata[style].LastUpdate == CurrentUpdate)
+		if (Unlockeddata[style].LastUpdate.load(std::memory_order_acquire) == CurrentUpdate)
 		{
 			return static_cast<const uint8_t*>(Unlockeddata[style].Pixels);
 		}
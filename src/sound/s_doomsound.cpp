@@ -903,6 +903,7 @@ void S_SerializeSounds(FSerializer &arc)
 			{
 				chan = (FSoundChan*)soundEngine->GetChannel(nullptr);
 				arc(nullptr, *chan);
+				soundEngine->IndexChannel(chan);
 				// Sounds always start out evicted when restored from a save.
 				chan->ChanFlags |= CHANF_EVICTED | CHANF_ABSTIME;
 			}